@@ -148,13 +148,15 @@ struct usermaphack_t
 extern spriteext_t spriteext[MAXSPRITES];
 extern spritesmooth_t spritesmooth[MAXSPRITES + MAXUNIQHUDID];
 
-extern sectortype sector[MAXSECTORS];
-extern walltype wall[MAXWALLS];
+// These are always addressable up to MAXSECTORS/MAXWALLS but only use memory for what the map needs. (see core/mapstorage.cpp)
+extern sectortype* sector;
+extern walltype* wall;
 extern spritetype sprite[MAXSPRITES];
 EXTERN int leveltimer;
 
-extern sectortype sectorbackup[MAXSECTORS];
-extern walltype wallbackup[MAXWALLS];
+extern sectortype* sectorbackup;
+extern walltype* wallbackup;
+void clearMapArrays();
 
 
 inline tspriteptr_t renderAddTSpriteFromSprite(spritetype* tsprite, int& spritesortcnt, uint16_t const spritenum)
@@ -357,6 +359,8 @@ void setVideoMode();
 class F2DDrawer;
 
 
+void   getzrange(ClipContext& ctx, const vec3_t* pos, int16_t sectnum, int32_t* ceilz, int32_t* ceilhit, int32_t* florz,
+                 int32_t* florhit, int32_t walldist, uint32_t cliptype) ATTRIBUTE((nonnull(2,4,5,6,7)));
 void   getzrange(const vec3_t *pos, int16_t sectnum, int32_t *ceilz, int32_t *ceilhit, int32_t *florz,
                  int32_t *florhit, int32_t walldist, uint32_t cliptype) ATTRIBUTE((nonnull(1,3,4,5,6)));
 inline void getzrange(int x, int y, int z, int16_t sectnum, int32_t* ceilz, int32_t* ceilhit, int32_t* florz,
@@ -366,6 +370,8 @@ inline void getzrange(int x, int y, int z, int16_t sectnum, int32_t* ceilz, int3
     getzrange(&v, sectnum, ceilz, ceilhit, florz, florhit, walldist, cliptype);
 }
 extern vec2_t hitscangoal;
+int32_t   hitscan(ClipContext& ctx, const vec3_t* sv, int16_t sectnum, int32_t vx, int32_t vy, int32_t vz,
+                  hitdata_t* hitinfo, uint32_t cliptype) ATTRIBUTE((nonnull(2,7)));
 int32_t   hitscan(const vec3_t *sv, int16_t sectnum, int32_t vx, int32_t vy, int32_t vz,
                   hitdata_t *hitinfo, uint32_t cliptype) ATTRIBUTE((nonnull(1,6)));
 inline int hitscan(int x, int y, int z, int16_t sectnum, int32_t vx, int32_t vy, int32_t vz,
@@ -387,6 +393,15 @@ void   neartag(int32_t xs, int32_t ys, int32_t zs, int16_t sectnum, int16_t ange
                int16_t *neartagsector, int16_t *neartagwall, int16_t *neartagsprite,
                int32_t *neartaghitdist, int32_t neartagrange, uint8_t tagsearch,
                int32_t (*blacklist_sprite_func)(int32_t) = nullptr) ATTRIBUTE((nonnull(6,7,8)));
+struct CanSeeQuery
+{
+    vec3_t start, end;
+    int16_t startsect, endsect;
+};
+void      canseebatch(ClipContext& ctx, const CanSeeQuery* queries, int count, uint8_t* results);
+void      canseebatch(const CanSeeQuery* queries, int count, uint8_t* results);
+int32_t   cansee(ClipContext& ctx, int32_t x1, int32_t y1, int32_t z1, int16_t sect1,
+                 int32_t x2, int32_t y2, int32_t z2, int16_t sect2);
 int32_t   cansee(int32_t x1, int32_t y1, int32_t z1, int16_t sect1,
                  int32_t x2, int32_t y2, int32_t z2, int16_t sect2);
 int32_t   inside(int32_t x, int32_t y, int sectnum);
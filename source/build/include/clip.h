@@ -21,6 +21,38 @@ typedef struct
 
 extern int16_t clipsectorlist[MAXCLIPSECTORS];
 
+// Scratch state of the collision queries (clipmove, pushmove, getzrange, hitscan, cansee).
+// The context-less versions of these functions all share one global instance, so they may only
+// be called from the main thread. Code that wants to run queries concurrently must give each
+// thread its own context. Note that the map data itself is only read, so it must not be modified
+// while such queries are in flight.
+struct ClipContext
+{
+    int16_t clipnum;
+    int32_t clipsectnum, clipspritenum;
+    int32_t warned;
+    int32_t boxtracenum = 3;
+    int32_t hitsectcf;
+    vec2_t hitscangoal = { (1 << 29) - 1, (1 << 29) - 1 };
+
+    linetype clipit[MAXCLIPNUM];
+    int16_t clipobjectval[MAXCLIPNUM];
+    uint8_t clipignore[(MAXCLIPNUM + 7) >> 3];
+    int16_t clipsectorlist[MAXCLIPSECTORS];
+    uint8_t clipsectormap[(MAXSECTORS + 7) >> 3];
+
+    // for clipupdatesector and cansee
+    int16_t sectlist[MAXSECTORS];
+    uint8_t sectbitmap[(MAXSECTORS + 7) >> 3];
+
+    // for canseebatch
+    TArray<uint64_t> sectrays;      // per sector, the rays of the current group that reached it
+    TArray<uint64_t> sectpending;   // per sector, the rays that still need to test its walls
+    TArray<int16_t> sectqueue;
+    TArray<uint32_t> wallside;      // per wall of the current sector, which side of the ray its first point is on
+    TArray<int> queryorder;
+};
+
 int clipinsidebox(vec2_t *vect, int wallnum, int walldist);
 inline int clipinsidebox(int x, int y, int wall, int dist)
 {
@@ -44,8 +76,13 @@ inline int clipmove(int* x, int* y, int* z, short* sect, int xv, int yv, int wal
     return retval;
 }
 
+int32_t clipmove(ClipContext& ctx, vec3_t* const pos, int16_t* const sectnum, int32_t xvect, int32_t yvect, int32_t const walldist, int32_t const ceildist,
+                 int32_t const flordist, uint32_t const cliptype) ATTRIBUTE((nonnull(2, 3)));
+
 int32_t clipmovex(vec3_t *const pos, int16_t *const sectnum, int32_t xvect, int32_t yvect, int32_t const walldist, int32_t const ceildist,
                   int32_t const flordist, uint32_t const cliptype, uint8_t const noslidep) ATTRIBUTE((nonnull(1, 2)));
+int pushmove(ClipContext& ctx, vec3_t* const vect, int16_t* const sectnum, int32_t const walldist, int32_t const ceildist, int32_t const flordist,
+             uint32_t const cliptype, bool clear = true) ATTRIBUTE((nonnull(2, 3)));
 int pushmove(vec3_t *const vect, int16_t *const sectnum, int32_t const walldist, int32_t const ceildist, int32_t const flordist,
                  uint32_t const cliptype, bool clear = true) ATTRIBUTE((nonnull(1, 2)));
 
@@ -11,19 +11,18 @@
 #include "engine_priv.h"
 #include "printf.h"
 #include "gamefuncs.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "sectorgrid.h"
+#include <thread>
+#include <memory>
 
 enum { MAXCLIPDIST = 1024 };
 
-static int16_t clipnum;
-static linetype clipit[MAXCLIPNUM];
-static int32_t clipsectnum, origclipsectnum, clipspritenum;
 int16_t clipsectorlist[MAXCLIPSECTORS];
-static int16_t origclipsectorlist[MAXCLIPSECTORS];
-static uint8_t clipsectormap[(MAXSECTORS+7)>>3];
-static uint8_t origclipsectormap[(MAXSECTORS+7)>>3];
-static int16_t clipobjectval[MAXCLIPNUM];
-static uint8_t clipignore[(MAXCLIPNUM+7)>>3];
-static int32_t rxi[8], ryi[8];
+
+// used by the context-less query functions.
+static ClipContext defaultClipContext;
 
 
 
@@ -168,37 +167,37 @@ int clipinsideboxline(int x, int y, int x1, int y1, int x2, int y2, int walldist
     return (x2 >= y2) << 1;
 }
 
-static int32_t clipmove_warned;
-
-static inline void addclipsect(int const sectnum)
+static inline void addclipsect(ClipContext& ctx, int const sectnum)
 {
-    if (clipsectnum < MAXCLIPSECTORS)
+    if (ctx.clipsectnum < MAXCLIPSECTORS)
     {
-        bitmap_set(clipsectormap, sectnum);
-        clipsectorlist[clipsectnum++] = sectnum;
+        bitmap_set(ctx.clipsectormap, sectnum);
+        ctx.clipsectorlist[ctx.clipsectnum++] = sectnum;
     }
     else
-        clipmove_warned |= 1;
+        ctx.warned |= 1;
 }
 
 
-static void addclipline(int32_t dax1, int32_t day1, int32_t dax2, int32_t day2, int16_t daoval, int nofix)
+static void addclipline(ClipContext& ctx, int32_t dax1, int32_t day1, int32_t dax2, int32_t day2, int16_t daoval, int nofix)
 {
+    int const clipnum = ctx.clipnum;
+
     if (clipnum >= MAXCLIPNUM)
     {
-        clipmove_warned |= 2;
+        ctx.warned |= 2;
         return;
     }
 
-    clipit[clipnum].x1 = dax1; clipit[clipnum].y1 = day1;
-    clipit[clipnum].x2 = dax2; clipit[clipnum].y2 = day2;
-    clipobjectval[clipnum] = daoval;
+    ctx.clipit[clipnum].x1 = dax1; ctx.clipit[clipnum].y1 = day1;
+    ctx.clipit[clipnum].x2 = dax2; ctx.clipit[clipnum].y2 = day2;
+    ctx.clipobjectval[clipnum] = daoval;
 
     uint32_t const mask = (1 << (clipnum&7));
-    uint8_t &value = clipignore[clipnum>>3];
+    uint8_t &value = ctx.clipignore[clipnum>>3];
     value = (value & ~mask) | (-nofix & mask);
 
-    clipnum++;
+    ctx.clipnum++;
 }
 
 inline void clipmove_tweak_pos(const vec3_t *pos, int32_t gx, int32_t gy, int32_t x1, int32_t y1, int32_t x2,
@@ -291,9 +290,11 @@ int32_t clipmovex(vec3_t *pos, int16_t *sectnum,
 //
 // raytrace (internal)
 //
-static inline int32_t cliptrace(vec2_t const pos, vec2_t * const goal)
+static inline int32_t cliptrace(ClipContext const& ctx, vec2_t const pos, vec2_t * const goal)
 {
     int32_t hitwall = -1;
+    auto const clipit = ctx.clipit;
+    int const clipnum = ctx.clipnum;
 
     for (int z=clipnum-1; z>=0; z--)
     {
@@ -344,8 +345,9 @@ static inline int32_t cliptrace(vec2_t const pos, vec2_t * const goal)
 //
 // keepaway (internal)
 //
-static inline void keepaway(int32_t *x, int32_t *y, int32_t w)
+static inline void keepaway(ClipContext const& ctx, int32_t *x, int32_t *y, int32_t w)
 {
+    auto const clipit = ctx.clipit;
     const int32_t x1 = clipit[w].x1, dx = clipit[w].x2-x1;
     const int32_t y1 = clipit[w].y1, dy = clipit[w].y2-y1;
     const int32_t ox = Sgn(-dy), oy = Sgn(dx);
@@ -394,7 +396,7 @@ static int get_floorspr_clipyou(vec2_t const v1, vec2_t const v2, vec2_t const v
     return clipyou;
 }
 
-static void clipupdatesector(vec2_t const pos, int16_t * const sectnum, int walldist)
+static void clipupdatesector(ClipContext& ctx, vec2_t const pos, int16_t * const sectnum, int walldist)
 {
 #if 0
     if (enginecompatibility_mode != ENGINECOMPATIBILITY_NONE)
@@ -415,8 +417,8 @@ static void clipupdatesector(vec2_t const pos, int16_t * const sectnum, int wall
         walldist = 0x7fff;
     }
 
-    static int16_t sectlist[MAXSECTORS];
-    static uint8_t sectbitmap[(MAXSECTORS+7)>>3];
+    auto const sectlist = ctx.sectlist;
+    auto const sectbitmap = ctx.sectbitmap;
 
     bfirst_search_init(sectlist, sectbitmap, &nsecs, MAXSECTORS, *sectnum);
 
@@ -433,7 +435,7 @@ static void clipupdatesector(vec2_t const pos, int16_t * const sectnum, int wall
         auto       uwal      = (uwallptr_t)&wall[startwall];
 
         for (int j = startwall; j < endwall; j++, uwal++)
-            if (uwal->nextsector >= 0 && bitmap_test(clipsectormap, uwal->nextsector))
+            if (uwal->nextsector >= 0 && bitmap_test(ctx.clipsectormap, uwal->nextsector))
                 bfirst_search_try(sectlist, sectbitmap, &nsecs, uwal->nextsector);
     }
 
@@ -447,7 +449,7 @@ static void clipupdatesector(vec2_t const pos, int16_t * const sectnum, int wall
         {
             // add sector to clipping list so the next call to clipupdatesector()
             // finishes in the loop above this one
-            addclipsect(listsectnum);
+            addclipsect(ctx, listsectnum);
             SET_AND_RETURN(*sectnum, listsectnum);
         }
 
@@ -471,10 +473,22 @@ static void clipupdatesector(vec2_t const pos, int16_t * const sectnum, int wall
 //
 int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int32_t yvect,
                  int32_t const walldist, int32_t const ceildist, int32_t const flordist, uint32_t const cliptype)
+{
+    defaultClipContext.boxtracenum = clipmoveboxtracenum;
+    return clipmove(defaultClipContext, pos, sectnum, xvect, yvect, walldist, ceildist, flordist, cliptype);
+}
+
+int32_t clipmove(ClipContext& ctx, vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int32_t yvect,
+                 int32_t const walldist, int32_t const ceildist, int32_t const flordist, uint32_t const cliptype)
 {
     if ((xvect|yvect) == 0 || *sectnum < 0)
         return 0;
 
+    auto const clipit = ctx.clipit;
+    auto const clipsectorlist = ctx.clipsectorlist;
+    auto const clipsectormap = ctx.clipsectormap;
+    int const clipmoveboxtracenum = ctx.boxtracenum;
+
     uspriteptr_t curspr=NULL;  // non-NULL when handling sprite with sector-like clipping
 
     int const initialsectnum = *sectnum;
@@ -498,11 +512,11 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
 
     clipsectorlist[0] = *sectnum;
 
-    clipsectnum   = 1;
-    clipnum       = 0;
-    clipspritenum = 0;
+    ctx.clipsectnum   = 1;
+    ctx.clipnum       = 0;
+    ctx.clipspritenum = 0;
 
-    clipmove_warned = 0;
+    ctx.warned = 0;
 
     memset(clipsectormap, 0, (numsectors+7)>>3);
     bitmap_set(clipsectormap, *sectnum);
@@ -571,11 +585,11 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
 
                 //Add 2 boxes at endpoints
                 int32_t bsz = walldist; if (diff.x < 0) bsz = -bsz;
-                addclipline(p1.x-bsz, p1.y-bsz, p1.x-bsz, p1.y+bsz, objtype, false);
-                addclipline(p2.x-bsz, p2.y-bsz, p2.x-bsz, p2.y+bsz, objtype, false);
+                addclipline(ctx, p1.x-bsz, p1.y-bsz, p1.x-bsz, p1.y+bsz, objtype, false);
+                addclipline(ctx, p2.x-bsz, p2.y-bsz, p2.x-bsz, p2.y+bsz, objtype, false);
                 bsz = walldist; if (diff.y < 0) bsz = -bsz;
-                addclipline(p1.x+bsz, p1.y-bsz, p1.x-bsz, p1.y-bsz, objtype, false);
-                addclipline(p2.x+bsz, p2.y-bsz, p2.x-bsz, p2.y-bsz, objtype, false);
+                addclipline(ctx, p1.x+bsz, p1.y-bsz, p1.x-bsz, p1.y-bsz, objtype, false);
+                addclipline(ctx, p2.x+bsz, p2.y-bsz, p2.x-bsz, p2.y-bsz, objtype, false);
 
                 v.x = walldist; if (d.y > 0) v.x = -v.x;
                 v.y = walldist; if (d.x < 0) v.y = -v.y;
@@ -583,19 +597,19 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
                 if (enginecompatibility_mode == ENGINECOMPATIBILITY_NONE && d.x * (pos->y-p1.y-v.y) < (pos->x-p1.x-v.x) * d.y)
                     v.x >>= 1, v.y >>= 1;
 
-                addclipline(p1.x+v.x, p1.y+v.y, p2.x+v.x, p2.y+v.y, objtype, false);
+                addclipline(ctx, p1.x+v.x, p1.y+v.y, p2.x+v.x, p2.y+v.y, objtype, false);
             }
             else if (wal->nextsector>=0)
             {
                 if (bitmap_test(clipsectormap, wal->nextsector) == 0)
-                    addclipsect(wal->nextsector);
+                    addclipsect(ctx, wal->nextsector);
             }
         }
 
-        if (clipmove_warned & 1)
+        if (ctx.warned & 1)
             Printf("clipsectnum >= MAXCLIPSECTORS!\n");
 
-        if (clipmove_warned & 2)
+        if (ctx.warned & 2)
             Printf("clipnum >= MAXCLIPNUM!\n");
 
         ////////// Sprites //////////
@@ -626,10 +640,10 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
                     {
                         int32_t bsz = (spr->clipdist << 2)+walldist;
                         if (diff.x < 0) bsz = -bsz;
-                        addclipline(p1.x-bsz, p1.y-bsz, p1.x-bsz, p1.y+bsz, (int16_t)j+49152, false);
+                        addclipline(ctx, p1.x-bsz, p1.y-bsz, p1.x-bsz, p1.y+bsz, (int16_t)j+49152, false);
                         bsz = (spr->clipdist << 2)+walldist;
                         if (diff.y < 0) bsz = -bsz;
-                        addclipline(p1.x+bsz, p1.y-bsz, p1.x-bsz, p1.y-bsz, (int16_t)j+49152, false);
+                        addclipline(ctx, p1.x+bsz, p1.y-bsz, p1.x-bsz, p1.y-bsz, (int16_t)j+49152, false);
                     }
                 }
                 break;
@@ -650,19 +664,19 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
                                      MulScale(bsin(spr->ang + 256), walldist, 14) };
 
                         if ((p1.x-pos->x) * (p2.y-pos->y) >= (p2.x-pos->x) * (p1.y-pos->y))  // Front
-                            addclipline(p1.x+v.x, p1.y+v.y, p2.x+v.y, p2.y-v.x, (int16_t)j+49152, false);
+                            addclipline(ctx, p1.x+v.x, p1.y+v.y, p2.x+v.y, p2.y-v.x, (int16_t)j+49152, false);
                         else
                         {
                             if ((cstat & 64) != 0)
                                 continue;
-                            addclipline(p2.x-v.x, p2.y-v.y, p1.x-v.y, p1.y+v.x, (int16_t)j+49152, false);
+                            addclipline(ctx, p2.x-v.x, p2.y-v.y, p1.x-v.y, p1.y+v.x, (int16_t)j+49152, false);
                         }
 
                         //Side blocker
                         if ((p2.x-p1.x) * (pos->x-p1.x)+(p2.y-p1.y) * (pos->y-p1.y) < 0)
-                            addclipline(p1.x-v.y, p1.y+v.x, p1.x+v.x, p1.y+v.y, (int16_t)j+49152, true);
+                            addclipline(ctx, p1.x-v.y, p1.y+v.x, p1.x+v.x, p1.y+v.y, (int16_t)j+49152, true);
                         else if ((p1.x-p2.x) * (pos->x-p2.x)+(p1.y-p2.y) * (pos->y-p2.y) < 0)
-                            addclipline(p2.x+v.y, p2.y-v.x, p2.x-v.x, p2.y-v.y, (int16_t)j+49152, true);
+                            addclipline(ctx, p2.x+v.y, p2.y-v.x, p2.x-v.x, p2.y-v.y, (int16_t)j+49152, true);
                     }
                 }
                 break;
@@ -676,6 +690,7 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
                         if ((pos->z > spr->z) == ((cstat&8)==0))
                             continue;
 
+                    int32_t rxi[4], ryi[4];
                     rxi[0] = p1.x;
                     ryi[0] = p1.y;
 
@@ -688,30 +703,30 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
                     if ((rxi[0]-pos->x) * (ryi[1]-pos->y) < (rxi[1]-pos->x) * (ryi[0]-pos->y))
                     {
                         if (clipinsideboxline(cent.x, cent.y, rxi[1], ryi[1], rxi[0], ryi[0], rad) != 0)
-                            addclipline(rxi[1]-v.y, ryi[1]+v.x, rxi[0]+v.x, ryi[0]+v.y, (int16_t)j+49152, false);
+                            addclipline(ctx, rxi[1]-v.y, ryi[1]+v.x, rxi[0]+v.x, ryi[0]+v.y, (int16_t)j+49152, false);
                     }
                     else if ((rxi[2]-pos->x) * (ryi[3]-pos->y) < (rxi[3]-pos->x) * (ryi[2]-pos->y))
                     {
                         if (clipinsideboxline(cent.x, cent.y, rxi[3], ryi[3], rxi[2], ryi[2], rad) != 0)
-                            addclipline(rxi[3]+v.y, ryi[3]-v.x, rxi[2]-v.x, ryi[2]-v.y, (int16_t)j+49152, false);
+                            addclipline(ctx, rxi[3]+v.y, ryi[3]-v.x, rxi[2]-v.x, ryi[2]-v.y, (int16_t)j+49152, false);
                     }
 
                     if ((rxi[1]-pos->x) * (ryi[2]-pos->y) < (rxi[2]-pos->x) * (ryi[1]-pos->y))
                     {
                         if (clipinsideboxline(cent.x, cent.y, rxi[2], ryi[2], rxi[1], ryi[1], rad) != 0)
-                            addclipline(rxi[2]-v.x, ryi[2]-v.y, rxi[1]-v.y, ryi[1]+v.x, (int16_t)j+49152, false);
+                            addclipline(ctx, rxi[2]-v.x, ryi[2]-v.y, rxi[1]-v.y, ryi[1]+v.x, (int16_t)j+49152, false);
                     }
                     else if ((rxi[3]-pos->x) * (ryi[0]-pos->y) < (rxi[0]-pos->x) * (ryi[3]-pos->y))
                     {
                         if (clipinsideboxline(cent.x, cent.y, rxi[0], ryi[0], rxi[3], ryi[3], rad) != 0)
-                            addclipline(rxi[0]+v.x, ryi[0]+v.y, rxi[3]+v.y, ryi[3]-v.x, (int16_t)j+49152, false);
+                            addclipline(ctx, rxi[0]+v.x, ryi[0]+v.y, rxi[3]+v.y, ryi[3]-v.x, (int16_t)j+49152, false);
                     }
                 }
                 break;
             }
             }
         }
-    } while (clipsectcnt < clipsectnum || clipspritecnt < clipspritenum);
+    } while (clipsectcnt < ctx.clipsectnum || clipspritecnt < ctx.clipspritenum);
 
     int32_t hitwalls[4], hitwall;
     int32_t clipReturn = 0;
@@ -722,12 +737,12 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
     {
         if (enginecompatibility_mode == ENGINECOMPATIBILITY_NONE && (xvect|yvect)) 
         {
-            for (int i=clipnum-1;i>=0;--i)
+            for (int i=ctx.clipnum-1;i>=0;--i)
             {
-                if (!bitmap_test(clipignore, i) && clipinsideboxline(pos->x, pos->y, clipit[i].x1, clipit[i].y1, clipit[i].x2, clipit[i].y2, walldist))
+                if (!bitmap_test(ctx.clipignore, i) && clipinsideboxline(pos->x, pos->y, clipit[i].x1, clipit[i].y1, clipit[i].x2, clipit[i].y2, walldist))
                 {
                     vec2_t const vec = pos->vec2;
-                    keepaway(&pos->x, &pos->y, i);
+                    keepaway(ctx, &pos->x, &pos->y, i);
                     if (inside(pos->x,pos->y, *sectnum) != 1)
                         pos->vec2 = vec;
                     break;
@@ -737,7 +752,7 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
 
         vec2_t vec = goal;
         
-        if ((hitwall = cliptrace(pos->vec2, &vec)) >= 0)
+        if ((hitwall = cliptrace(ctx, pos->vec2, &vec)) >= 0)
         {
             vec2_t const  clipr  = { clipit[hitwall].x2 - clipit[hitwall].x1, clipit[hitwall].y2 - clipit[hitwall].y1 };
             // clamp to the max value we can utilize without reworking the scaling below
@@ -779,17 +794,17 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
                 }
             }
 
-            keepaway(&goal.x, &goal.y, hitwall);
+            keepaway(ctx, &goal.x, &goal.y, hitwall);
             xvect = (goal.x-vec.x)<<14;
             yvect = (goal.y-vec.y)<<14;
 
             if (cnt == clipmoveboxtracenum)
-                clipReturn = (uint16_t) clipobjectval[hitwall];
+                clipReturn = (uint16_t) ctx.clipobjectval[hitwall];
             hitwalls[cnt] = hitwall;
         }
 
         if (enginecompatibility_mode == ENGINECOMPATIBILITY_NONE)
-            clipupdatesector(vec, sectnum, rad);
+            clipupdatesector(ctx, vec, sectnum, rad);
 
         pos->x = vec.x;
         pos->y = vec.y;
@@ -798,7 +813,7 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
 
     if (enginecompatibility_mode != ENGINECOMPATIBILITY_NONE)
     {
-        for (native_t j=0; j<clipsectnum; j++)
+        for (native_t j=0; j<ctx.clipsectnum; j++)
             if (inside(pos->x, pos->y, clipsectorlist[j]) == 1)
             {
                 *sectnum = clipsectorlist[j];
@@ -853,8 +868,16 @@ int32_t clipmove(vec3_t * const pos, int16_t * const sectnum, int32_t xvect, int
 //
 int pushmove(vec3_t *const vect, int16_t *const sectnum,
     int32_t const walldist, int32_t const ceildist, int32_t const flordist, uint32_t const cliptype, bool clear /*= true*/)
+{
+    return pushmove(defaultClipContext, vect, sectnum, walldist, ceildist, flordist, cliptype, clear);
+}
+
+int pushmove(ClipContext& ctx, vec3_t *const vect, int16_t *const sectnum,
+    int32_t const walldist, int32_t const ceildist, int32_t const flordist, uint32_t const cliptype, bool clear /*= true*/)
 {
     int bad;
+    auto const clipsectorlist = ctx.clipsectorlist;
+    auto const clipsectormap = ctx.clipsectormap;
 
     const int32_t dawalclipmask = (cliptype&65535);
     //    const int32_t dasprclipmask = (cliptype >> 16);
@@ -876,7 +899,7 @@ int pushmove(vec3_t *const vect, int16_t *const sectnum,
             if (enginecompatibility_mode != ENGINECOMPATIBILITY_NONE && *sectnum < 0)
                 return 0;
             clipsectorlist[0] = *sectnum;
-            clipsectnum = 1;
+            ctx.clipsectnum = 1;
 
             memset(clipsectormap, 0, (numsectors + 7) >> 3);
             bitmap_set(clipsectormap, *sectnum);
@@ -943,15 +966,15 @@ int pushmove(vec3_t *const vect, int16_t *const sectnum,
                         } while (clipinsidebox(&vect->vec2, i, walldist-4) != 0);
                         bad = -1;
                         k--; if (k <= 0) return bad;
-                        clipupdatesector(vect->vec2, sectnum, walldist);
+                        clipupdatesector(ctx, vect->vec2, sectnum, walldist);
                         if (enginecompatibility_mode == ENGINECOMPATIBILITY_NONE && *sectnum < 0) return -1;
                     }
                     else if (bitmap_test(clipsectormap, wal->nextsector) == 0)
-                        addclipsect(wal->nextsector);
+                        addclipsect(ctx, wal->nextsector);
                 }
 
             clipsectcnt++;
-        } while (clipsectcnt < clipsectnum);
+        } while (clipsectcnt < ctx.clipsectnum);
         dir = -dir;
     } while (bad != 0);
 
@@ -964,6 +987,13 @@ int pushmove(vec3_t *const vect, int16_t *const sectnum,
 void getzrange(const vec3_t *pos, int16_t sectnum,
                int32_t *ceilz, int32_t *ceilhit, int32_t *florz, int32_t *florhit,
                int32_t walldist, uint32_t cliptype)
+{
+    getzrange(defaultClipContext, pos, sectnum, ceilz, ceilhit, florz, florhit, walldist, cliptype);
+}
+
+void getzrange(ClipContext& ctx, const vec3_t *pos, int16_t sectnum,
+               int32_t *ceilz, int32_t *ceilhit, int32_t *florz, int32_t *florhit,
+               int32_t walldist, uint32_t cliptype)
 {
     if (sectnum < 0)
     {
@@ -992,9 +1022,12 @@ void getzrange(const vec3_t *pos, int16_t sectnum,
         getzsofslope(sectnum,closest.x,closest.y,ceilz,florz);
     *ceilhit = sectnum+16384; *florhit = sectnum+16384;
 
+    auto const clipsectorlist = ctx.clipsectorlist;
+    auto const clipsectormap = ctx.clipsectormap;
+
     clipsectorlist[0] = sectnum;
-    clipsectnum = 1;
-    clipspritenum = 0;
+    ctx.clipsectnum = 1;
+    ctx.clipspritenum = 0;
     memset(clipsectormap, 0, (numsectors+7)>>3);
     bitmap_set(clipsectormap, sectnum);
 
@@ -1035,7 +1068,7 @@ void getzrange(const vec3_t *pos, int16_t sectnum,
                 if (((sec->floorstat&1) == 0) && (pos->z >= sec->floorz-(3<<8))) continue;
 
                 if (bitmap_test(clipsectormap, k) == 0)
-                    addclipsect(k);
+                    addclipsect(ctx, k);
 
                 if (((v1.x < xmin + MAXCLIPDIST) && (v2.x < xmin + MAXCLIPDIST)) ||
                     ((v1.x > xmax - MAXCLIPDIST) && (v2.x > xmax - MAXCLIPDIST)) ||
@@ -1066,12 +1099,12 @@ void getzrange(const vec3_t *pos, int16_t sectnum,
         }
         clipsectcnt++;
     }
-    while (clipsectcnt < clipsectnum || clipspritecnt < clipspritenum);
+    while (clipsectcnt < ctx.clipsectnum || clipspritecnt < ctx.clipspritenum);
 
     ////////// Sprites //////////
 
     if (dasprclipmask)
-    for (bssize_t i=0; i<clipsectnum; i++)
+    for (bssize_t i=0; i<ctx.clipsectnum; i++)
     {
         int j;
         if (clipsectorlist[i] == MAXSECTORS) continue;    // we got a deleted sprite in here somewhere. Skip this entry.
@@ -1211,11 +1244,9 @@ static inline void hit_set(hitdata_t *hit, int32_t sectnum, int32_t wallnum, int
     hit->pos.z = z;
 }
 
-static int32_t hitscan_hitsectcf=-1;
-
 // stat, heinum, z: either ceiling- or floor-
 // how: -1: behave like ceiling, 1: behave like floor
-static int32_t hitscan_trysector(const vec3_t *sv, usectorptr_t sec, hitdata_t *hit,
+static int32_t hitscan_trysector(ClipContext& ctx, const vec3_t *sv, usectorptr_t sec, hitdata_t *hit,
                                  int32_t vx, int32_t vy, int32_t vz,
                                  uint16_t stat, int16_t heinum, int32_t z, int32_t how, const intptr_t *tmp)
 {
@@ -1263,7 +1294,7 @@ static int32_t hitscan_trysector(const vec3_t *sv, usectorptr_t sec, hitdata_t *
             if (inside(x1,y1,int(sec-sector)) == 1)
             {
                 hit_set(hit, int(sec-sector), -1, -1, x1, y1, z1);
-                hitscan_hitsectcf = (how+1)>>1;
+                ctx.hitsectcf = (how+1)>>1;
             }
         }
         else
@@ -1288,6 +1319,13 @@ static int32_t hitscan_trysector(const vec3_t *sv, usectorptr_t sec, hitdata_t *
 //
 int32_t hitscan(const vec3_t *sv, int16_t sectnum, int32_t vx, int32_t vy, int32_t vz,
                 hitdata_t *hit, uint32_t cliptype)
+{
+    defaultClipContext.hitscangoal = hitscangoal;
+    return hitscan(defaultClipContext, sv, sectnum, vx, vy, vz, hit, cliptype);
+}
+
+int32_t hitscan(ClipContext& ctx, const vec3_t *sv, int16_t sectnum, int32_t vx, int32_t vy, int32_t vz,
+                hitdata_t *hit, uint32_t cliptype)
 {
     int32_t x1, y1=0, z1=0, x2, y2, intx, inty, intz;
     int32_t i, k, daz;
@@ -1304,12 +1342,13 @@ int32_t hitscan(const vec3_t *sv, int16_t sectnum, int32_t vx, int32_t vy, int32
     if (sectnum < 0)
         return -1;
 
-    hit->pos.vec2 = hitscangoal;
+    hit->pos.vec2 = ctx.hitscangoal;
 
+    auto const clipsectorlist = ctx.clipsectorlist;
     clipsectorlist[0] = sectnum;
     tempshortcnt  = 0;
     tempshortnum  = 1;
-    clipspritecnt = clipspritenum = 0;
+    clipspritecnt = ctx.clipspritenum = 0;
 
     do
     {
@@ -1321,9 +1360,9 @@ int32_t hitscan(const vec3_t *sv, int16_t sectnum, int32_t vx, int32_t vy, int32
         i = 1;
         if (enginecompatibility_mode != ENGINECOMPATIBILITY_19950829)
         {
-            if (hitscan_trysector(sv, sec, hit, vx,vy,vz, sec->ceilingstat, sec->ceilingheinum, sec->ceilingz, -i, tmpptr))
+            if (hitscan_trysector(ctx, sv, sec, hit, vx,vy,vz, sec->ceilingstat, sec->ceilingheinum, sec->ceilingz, -i, tmpptr))
                 continue;
-            if (hitscan_trysector(sv, sec, hit, vx,vy,vz, sec->floorstat, sec->floorheinum, sec->floorz, i, tmpptr))
+            if (hitscan_trysector(ctx, sv, sec, hit, vx,vy,vz, sec->floorstat, sec->floorheinum, sec->floorz, i, tmpptr))
                 continue;
         }
 
@@ -1523,8 +1562,110 @@ int32_t hitscan(const vec3_t *sv, int16_t sectnum, int32_t vx, int32_t vy, int32
             }
         }
     }
-    while (++tempshortcnt < tempshortnum || clipspritecnt < clipspritenum);
+    while (++tempshortcnt < tempshortnum || clipspritecnt < ctx.clipspritenum);
 
     return 0;
 }
 
+
+//
+// Runs the same clipmove, getzrange and hitscan queries for every sprite in the map
+// serially and on multiple threads, each with its own ClipContext, and compares the results.
+//
+struct ClipTestResult
+{
+    int32_t x, y, z, sect, ret;
+    int32_t ceilz, ceilhit, florz, florhit;
+    int32_t hit[4][6];
+};
+
+static void RunClipTest(ClipContext& ctx, int spritenum, ClipTestResult& res)
+{
+    auto const spr = (uspriteptr_t)&sprite[spritenum];
+    const uint32_t clipmask = (1 << 16) + 1, hitmask = (256 << 16) + 64;
+
+    vec3_t pos = spr->pos;
+    int16_t sect = spr->sectnum;
+    res.ret = clipmove(ctx, &pos, &sect, bcos(spr->ang, 9), bsin(spr->ang, 9), 164, 4 << 8, 4 << 8, clipmask);
+    res.x = pos.x;
+    res.y = pos.y;
+    res.z = pos.z;
+    res.sect = sect;
+
+    if ((unsigned)sect < (unsigned)numsectors)
+        getzrange(ctx, &pos, sect, &res.ceilz, &res.ceilhit, &res.florz, &res.florhit, 164, clipmask);
+    else
+        res.ceilz = res.ceilhit = res.florz = res.florhit = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        const int ang = (spr->ang + i * 512) & 2047;
+        hitdata_t hit{};
+        hitscan(ctx, &spr->pos, spr->sectnum, bcos(ang), bsin(ang), (i - 2) << 12, &hit, hitmask);
+        res.hit[i][0] = hit.pos.x;
+        res.hit[i][1] = hit.pos.y;
+        res.hit[i][2] = hit.pos.z;
+        res.hit[i][3] = hit.sprite;
+        res.hit[i][4] = hit.wall;
+        res.hit[i][5] = hit.sect;
+    }
+}
+
+CCMD(clip_threadtest)
+{
+    if (numsectors <= 0)
+    {
+        Printf("No map loaded\n");
+        return;
+    }
+    int numthreads = argv.argc() > 1 ? (int)strtoull(argv[1], nullptr, 0) : (int)std::thread::hardware_concurrency();
+    numthreads = clamp(numthreads, 1, 64);
+
+    TArray<int> sprites;
+    for (int i = 0; i < MAXSPRITES; i++)
+        if (sprite[i].statnum < MAXSTATUS && (unsigned)sprite[i].sectnum < (unsigned)numsectors)
+            sprites.Push(i);
+
+    TArray<ClipTestResult> serial(sprites.Size(), true), threaded(sprites.Size(), true);
+    cycle_t timer;
+
+    // The sector grid is rebuilt lazily by its first lookup, which must not happen on the worker threads.
+    sectorGrid.GetCandidates(0, 0);
+
+    timer.Reset();
+    timer.Clock();
+    auto ctx = std::make_unique<ClipContext>();
+    for (unsigned i = 0; i < sprites.Size(); i++)
+        RunClipTest(*ctx, sprites[i], serial[i]);
+    timer.Unclock();
+    double serialtime = timer.TimeMS();
+
+    timer.Reset();
+    timer.Clock();
+    TArray<std::thread> threads;
+    for (int t = 0; t < numthreads; t++)
+    {
+        threads.Push(std::thread([&, t]()
+        {
+            auto ctx = std::make_unique<ClipContext>();
+            for (unsigned i = t; i < sprites.Size(); i += numthreads)
+                RunClipTest(*ctx, sprites[i], threaded[i]);
+        }));
+    }
+    for (auto& thread : threads) thread.join();
+    timer.Unclock();
+    double threadtime = timer.TimeMS();
+
+    int mismatches = 0;
+    for (unsigned i = 0; i < sprites.Size(); i++)
+    {
+        if (memcmp(&serial[i], &threaded[i], sizeof(ClipTestResult)))
+        {
+            if (mismatches++ < 10) Printf("Sprite %d: results differ\n", sprites[i]);
+        }
+    }
+
+    Printf("%u sprites, serial: %.3f ms, %d threads: %.3f ms\n", sprites.Size(), serialtime, numthreads, threadtime);
+    if (mismatches) Printf(TEXTCOLOR_RED "%d of %u results differ!\n", mismatches, sprites.Size());
+    else Printf("All results match\n");
+}
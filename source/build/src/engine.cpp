@@ -32,6 +32,8 @@
 #include "render.h"
 #include "gamefuncs.h"
 #include "hw_voxels.h"
+#include "sectorgrid.h"
+#include "sectorgeometry.h"
 
 #ifdef USE_OPENGL
 # include "mdsprite.h"
@@ -44,8 +46,6 @@
 spriteext_t spriteext[MAXSPRITES];
 spritesmooth_t spritesmooth[MAXSPRITES + MAXUNIQHUDID];
 
-sectortype sector[MAXSECTORS];
-walltype wall[MAXWALLS];
 spritetype sprite[MAXSPRITES];
 
 int32_t r_rortexture = 0;
@@ -956,8 +956,9 @@ int32_t nextsectorneighborz(int16_t sectnum, int32_t refz, int16_t topbottom, in
 //
 // cansee
 //
-int32_t cansee_old(int32_t xs, int32_t ys, int32_t zs, int16_t sectnums, int32_t xe, int32_t ye, int32_t ze, int16_t sectnume)
+static int32_t cansee_old(ClipContext& ctx, int32_t xs, int32_t ys, int32_t zs, int16_t sectnums, int32_t xe, int32_t ye, int32_t ze, int16_t sectnume)
 {
+    auto const clipsectorlist = ctx.clipsectorlist;
     sectortype *sec, *nsec;
     walltype *wal, *wal2;
     int32_t intx, inty, intz, i, cnt, nextsector, dasectnum, dacnt, danum;
@@ -994,15 +995,29 @@ int32_t cansee_old(int32_t xs, int32_t ys, int32_t zs, int16_t sectnums, int32_t
     return 0;
 }
 
+static ClipContext canseeContext;
+
+// Queries recorded by cansee_record for cansee_replay.
+static TArray<CanSeeQuery> canseeRecording;
+static bool canseeRecordActive;
+
 int32_t cansee(int32_t x1, int32_t y1, int32_t z1, int16_t sect1, int32_t x2, int32_t y2, int32_t z2, int16_t sect2)
+{
+    if (canseeRecordActive)
+        canseeRecording.Push({ { x1, y1, z1 }, { x2, y2, z2 }, sect1, sect2 });
+    return cansee(canseeContext, x1, y1, z1, sect1, x2, y2, z2, sect2);
+}
+
+int32_t cansee(ClipContext& ctx, int32_t x1, int32_t y1, int32_t z1, int16_t sect1, int32_t x2, int32_t y2, int32_t z2, int16_t sect2)
 {
     if (enginecompatibility_mode == ENGINECOMPATIBILITY_19950829)
-        return cansee_old(x1, y1, z1, sect1, x2, y2, z2, sect2);
+        return cansee_old(ctx, x1, y1, z1, sect1, x2, y2, z2, sect2);
     int32_t dacnt, danum;
     const int32_t x21 = x2-x1, y21 = y2-y1, z21 = z2-z1;
 
-    static uint8_t sectbitmap[(MAXSECTORS+7)>>3];
-    memset(sectbitmap, 0, sizeof(sectbitmap));
+    auto const clipsectorlist = ctx.clipsectorlist;
+    auto const sectbitmap = ctx.sectbitmap;
+    memset(sectbitmap, 0, sizeof(ctx.sectbitmap));
     if (x1 == x2 && y1 == y2)
         return (sect1 == sect2);
 
@@ -1069,6 +1084,459 @@ int32_t cansee(int32_t x1, int32_t y1, int32_t z1, int16_t sect1, int32_t x2, in
     return 0;
 }
 
+//
+// cansee, batched version
+//
+// Queries with the same start sector are traced together, in groups of up to 64 rays.
+// The group walks the portal graph once: each sector is visited once, and each of its
+// walls is loaded once and tested against all rays of the group that reached the sector.
+// Every ray still crosses exactly the walls the scalar version would, so the results are
+// identical. All arithmetic is done unsigned to reproduce the scalar version's wraparound.
+// With SSE2 the wall tests run on 4 rays at a time when at least 4 rays reach a sector.
+// A query that has its start sector to itself goes straight to the scalar version.
+//
+// This pays off for rays that stay together, like several checks towards the same target.
+// Rays that fan out to far apart targets each end up alone in most sectors, and are then
+// somewhat slower than the scalar version because of the shared bookkeeping.
+//
+enum { CANSEEGROUP = 64 };
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifndef NO_SSE
+#include <emmintrin.h>
+
+// 32 bit multiply keeping the low half of each product. SSE2 has no instruction for this.
+static inline __m128i mullo32(__m128i a, __m128i b)
+{
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
+static inline int lowestbit(uint64_t v)
+{
+#ifdef _MSC_VER
+    unsigned long r;
+    _BitScanForward64(&r, v);
+    return r;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static void canseebatch_group(ClipContext& ctx, const CanSeeQuery* queries, const int* indices, int count, uint8_t* results)
+{
+    uint64_t active = 0;
+    for (int r = 0; r < count; r++)
+    {
+        auto& q = queries[indices[r]];
+        if (q.start.x == q.end.x && q.start.y == q.end.y)
+            results[indices[r]] = (q.startsect == q.endsect);
+        else
+            active |= uint64_t(1) << r;
+    }
+    if (!active)
+        return;
+
+    auto& sectrays = ctx.sectrays;
+    auto& sectpending = ctx.sectpending;
+    auto& queue = ctx.sectqueue;
+    uint64_t blocked = 0;
+
+    const int sect1 = queries[indices[0]].startsect;
+    sectrays[sect1] = sectpending[sect1] = active;
+    queue.Clear();
+    queue.Push(sect1);
+
+    for (unsigned qi = 0; qi < queue.Size(); qi++)
+    {
+        const int dasectnum = queue[qi];
+        const uint64_t pending = sectpending[dasectnum] & ~blocked;
+        sectpending[dasectnum] = 0;
+        if (!pending)
+            continue;
+
+        auto const sec = (usectorptr_t)&sector[dasectnum];
+        const int wallptr = sec->wallptr, wallnum = sec->wallnum;
+        auto const walls = (uwallptr_t)&wall[wallptr];
+
+        // Called for each wall that ray r crosses, with the intersection already confirmed.
+        // Returns false if the wall blocks the ray.
+        auto cross = [&](uwallptr_t wal, int r, int32_t bot, uint32_t t2) -> bool
+        {
+            const uint64_t bit = uint64_t(1) << r;
+            const int32_t nexts = wal->nextsector;
+            if (nexts < 0 || wal->cstat&32)
+            {
+                blocked |= bit;
+                return false;
+            }
+
+            auto& q = queries[indices[r]];
+            const int32_t t = DivScale(int32_t(t2), bot, 24);
+            const int32_t x = q.start.x + MulScale(q.end.x - q.start.x, t, 24);
+            const int32_t y = q.start.y + MulScale(q.end.y - q.start.y, t, 24);
+            const int32_t z = q.start.z + MulScale(q.end.z - q.start.z, t, 24);
+            int32_t cfz[2];
+
+            getzsofslope(dasectnum, x,y, &cfz[0],&cfz[1]);
+            if (z <= cfz[0] || z >= cfz[1])
+            {
+                blocked |= bit;
+                return false;
+            }
+
+            getzsofslope(nexts, x,y, &cfz[0],&cfz[1]);
+            if (z <= cfz[0] || z >= cfz[1])
+            {
+                blocked |= bit;
+                return false;
+            }
+
+            if (!(sectrays[nexts] & bit))
+            {
+                sectrays[nexts] |= bit;
+                if (!sectpending[nexts]) queue.Push(nexts);
+                sectpending[nexts] |= bit;
+            }
+            return true;
+        };
+
+        // One ray at a time, with the same tests as the scalar version.
+        auto trace = [&](int r)
+        {
+            auto& q = queries[indices[r]];
+            const uint32_t x1 = q.start.x, y1 = q.start.y;
+            const uint32_t x21 = q.end.x - q.start.x, y21 = q.end.y - q.start.y;
+            for (int i = 0; i < wallnum; i++)
+            {
+                auto const wal = &walls[i];
+                auto const wal2 = (uwallptr_t)&wall[wal->point2];
+                const uint32_t x31 = wal->x - x1, x34 = wal->x - wal2->x;
+                const uint32_t y31 = wal->y - y1, y34 = wal->y - wal2->y;
+
+                const int32_t bot = int32_t(y21*x34 - x21*y34);
+                if (bot <= 0) continue;
+                if (y21*x31 - x21*y31 >= uint32_t(bot)) continue;
+                const uint32_t t2 = y31*x34 - x31*y34;
+                if (t2 >= uint32_t(bot)) continue;
+                if (!cross(wal, r, bot, t2)) break;
+            }
+        };
+
+        uint64_t rest = pending;
+#ifndef NO_SSE
+        // With at least 4 rays the first two tests are done 4 rays at a time. They are rewritten in
+        // terms of the side each wall point is on: side(v) = y21*v.x - x21*v.y - (y21*x1 - x21*y1)
+        // gives t1 = side(wal) and bot = side(wal) - side(wal2), exact in 32 bit wraparound
+        // arithmetic. So each point only needs to be computed once, with 2 multiplies.
+        int atleast4 = 0;
+        for (uint64_t p = pending; p && atleast4 < 4; p &= p - 1) atleast4++;
+        if (atleast4 == 4)
+        {
+            // Gather the rays, padded to a multiple of 4 with zero length rays, which never cross a wall.
+            int rays[CANSEEGROUP + 3], numrays = 0;
+            alignas(16) uint32_t x21[CANSEEGROUP + 3], y21[CANSEEGROUP + 3], c[CANSEEGROUP + 3];
+            for (uint64_t p = pending; p; p &= p - 1)
+            {
+                const int r = lowestbit(p);
+                auto& q = queries[indices[r]];
+                x21[numrays] = uint32_t(q.end.x - q.start.x);
+                y21[numrays] = uint32_t(q.end.y - q.start.y);
+                c[numrays] = y21[numrays]*uint32_t(q.start.x) - x21[numrays]*uint32_t(q.start.y);
+                rays[numrays++] = r;
+            }
+            for (int k = numrays; k & 3; k++)
+            {
+                x21[k] = y21[k] = c[k] = 0;
+                rays[k] = -1;
+            }
+
+            auto& side = ctx.wallside;
+            side.Resize(wallnum * 4);
+            const __m128i sign = _mm_set1_epi32(INT32_MIN);
+            for (int k = 0; k < numrays; k += 4)
+            {
+                const __m128i vx21 = _mm_load_si128((const __m128i*)&x21[k]);
+                const __m128i vy21 = _mm_load_si128((const __m128i*)&y21[k]);
+                const __m128i vc = _mm_load_si128((const __m128i*)&c[k]);
+                auto sideof = [&](uwallptr_t w)
+                {
+                    return _mm_sub_epi32(_mm_sub_epi32(mullo32(vy21, _mm_set1_epi32(w->x)), mullo32(vx21, _mm_set1_epi32(w->y))), vc);
+                };
+                for (int i = 0; i < wallnum; i++)
+                    _mm_storeu_si128((__m128i*)&side[i * 4], sideof(&walls[i]));
+
+                int live = 0;
+                for (int l = 0; l < 4; l++)
+                    if (rays[k + l] >= 0) live |= 1 << l;
+
+                for (int i = 0; i < wallnum && live; i++)
+                {
+                    auto const wal = &walls[i];
+                    const int p2 = wal->point2 - wallptr;
+                    const __m128i t1 = _mm_loadu_si128((const __m128i*)&side[i * 4]);
+                    const __m128i s2 = (unsigned)p2 < (unsigned)wallnum ? _mm_loadu_si128((const __m128i*)&side[p2 * 4]) : sideof((uwallptr_t)&wall[wal->point2]);
+                    const __m128i bot = _mm_sub_epi32(t1, s2);
+
+                    // bot > 0, and t1 below bot as unsigned values.
+                    __m128i hit = _mm_cmpgt_epi32(bot, _mm_setzero_si128());
+                    hit = _mm_and_si128(hit, _mm_cmplt_epi32(_mm_xor_si128(t1, sign), _mm_xor_si128(bot, sign)));
+                    int mask = _mm_movemask_ps(_mm_castsi128_ps(hit)) & live;
+                    if (!mask)
+                        continue;
+
+                    alignas(16) int32_t bots[4];
+                    _mm_store_si128((__m128i*)bots, bot);
+                    auto const wal2 = (uwallptr_t)&wall[wal->point2];
+                    const uint32_t x34 = wal->x - wal2->x, y34 = wal->y - wal2->y;
+                    for (; mask; mask &= mask - 1)
+                    {
+                        const int l = lowestbit(mask);
+                        auto& q = queries[indices[rays[k + l]]];
+                        const uint32_t x31 = wal->x - uint32_t(q.start.x), y31 = wal->y - uint32_t(q.start.y);
+                        const uint32_t t2 = y31*x34 - x31*y34;
+                        if (t2 >= uint32_t(bots[l])) continue;
+                        if (!cross(wal, rays[k + l], bots[l], t2)) live &= ~(1 << l);
+                    }
+                }
+            }
+            rest = 0;
+        }
+#endif
+        for (; rest; rest &= rest - 1)
+            trace(lowestbit(rest));
+    }
+
+    for (uint64_t p = active; p; p &= p - 1)
+    {
+        const int r = lowestbit(p);
+        const int sect2 = queries[indices[r]].endsect;
+        results[indices[r]] = !(blocked & (uint64_t(1) << r)) && (unsigned)sect2 < (unsigned)numsectors && (sectrays[sect2] & (uint64_t(1) << r));
+    }
+
+    // Leave the per-sector masks cleared for the next group.
+    for (auto sect : queue)
+        sectrays[sect] = sectpending[sect] = 0;
+}
+
+void canseebatch(ClipContext& ctx, const CanSeeQuery* queries, int count, uint8_t* results)
+{
+    if (count <= 0)
+        return;
+
+    if (enginecompatibility_mode == ENGINECOMPATIBILITY_19950829)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            auto& q = queries[i];
+            results[i] = cansee_old(ctx, q.start.x, q.start.y, q.start.z, q.startsect, q.end.x, q.end.y, q.end.z, q.endsect);
+        }
+        return;
+    }
+
+    // These are only resized when a new map gets loaded and are always left cleared.
+    if (ctx.sectrays.Size() != (unsigned)numsectors)
+    {
+        ctx.sectrays.Resize(numsectors);
+        ctx.sectpending.Resize(numsectors);
+        memset(ctx.sectrays.Data(), 0, numsectors * sizeof(ctx.sectrays[0]));
+        memset(ctx.sectpending.Data(), 0, numsectors * sizeof(ctx.sectpending[0]));
+    }
+
+    auto& order = ctx.queryorder;
+    order.Clear();
+    for (int i = 0; i < count; i++)
+    {
+        if ((unsigned)queries[i].startsect < (unsigned)numsectors)
+            order.Push(i);
+        else
+            results[i] = 0;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return queries[a].startsect != queries[b].startsect ? queries[a].startsect < queries[b].startsect : a < b;
+    });
+
+    for (unsigned i = 0; i < order.Size();)
+    {
+        unsigned n = 1;
+        while (i + n < order.Size() && n < CANSEEGROUP && queries[order[i + n]].startsect == queries[order[i]].startsect)
+            n++;
+        if (n == 1)
+        {
+            auto& q = queries[order[i]];
+            results[order[i]] = (uint8_t)cansee(ctx, q.start.x, q.start.y, q.start.z, q.startsect, q.end.x, q.end.y, q.end.z, q.endsect);
+        }
+        else
+            canseebatch_group(ctx, queries, &order[i], n, results);
+        i += n;
+    }
+}
+
+void canseebatch(const CanSeeQuery* queries, int count, uint8_t* results)
+{
+    if (canseeRecordActive)
+        for (int i = 0; i < count; i++) canseeRecording.Push(queries[i]);
+    canseebatch(canseeContext, queries, count, results);
+}
+
+//
+// Compares canseebatch against the scalar cansee for all pairs of sprites in the map.
+//
+CCMD(bench_cansee)
+{
+    if (numsectors <= 0)
+    {
+        Printf("No map loaded\n");
+        return;
+    }
+    int maxsprites = argv.argc() > 1 ? (int)strtoull(argv[1], nullptr, 0) : 256;
+
+    TArray<int> sprites;
+    for (int i = 0; i < MAXSPRITES && (int)sprites.Size() < maxsprites; i++)
+        if (sprite[i].statnum < MAXSTATUS && (unsigned)sprite[i].sectnum < (unsigned)numsectors)
+            sprites.Push(i);
+
+    TArray<CanSeeQuery> queries;
+    for (auto a : sprites)
+        for (auto b : sprites)
+            if (a != b)
+                queries.Push({ sprite[a].pos, sprite[b].pos, sprite[a].sectnum, sprite[b].sectnum });
+    if (queries.Size() == 0)
+        return;
+
+    TArray<uint8_t> scalar(queries.Size(), true), batch(queries.Size(), true);
+    cycle_t timer;
+
+    timer.Reset();
+    timer.Clock();
+    for (unsigned i = 0; i < queries.Size(); i++)
+    {
+        auto& q = queries[i];
+        scalar[i] = (uint8_t)cansee(q.start.x, q.start.y, q.start.z, q.startsect, q.end.x, q.end.y, q.end.z, q.endsect);
+    }
+    timer.Unclock();
+    double scalartime = timer.TimeMS();
+
+    timer.Reset();
+    timer.Clock();
+    canseebatch(queries.Data(), queries.Size(), batch.Data());
+    timer.Unclock();
+    double batchtime = timer.TimeMS();
+
+    int mismatches = 0;
+    for (unsigned i = 0; i < queries.Size(); i++)
+        if (scalar[i] != batch[i]) mismatches++;
+
+    Printf("%u queries between %u sprites\n", queries.Size(), sprites.Size());
+    Printf("scalar: %.3f ms, batch: %.3f ms\n", scalartime, batchtime);
+    if (mismatches) Printf(TEXTCOLOR_RED "%d results differ!\n", mismatches);
+}
+
+//
+// Records the sight checks the game makes so that they can be replayed
+// against the current map with cansee_replay.
+//
+static const char canseeRecordId[4] = { 'C', 'S', 'Q', '1' };
+
+CCMD(cansee_record)
+{
+    if (!canseeRecordActive)
+    {
+        if (argv.argc() < 2)
+        {
+            Printf("Usage: cansee_record <file>\n");
+            return;
+        }
+        canseeRecording.Clear();
+        canseeRecordActive = true;
+        Printf("Recording sight checks, run cansee_record again to stop\n");
+        return;
+    }
+    canseeRecordActive = false;
+    if (argv.argc() < 2)
+    {
+        Printf("Recording discarded, no file given\n");
+        return;
+    }
+    auto fw = FileWriter::Open(argv[1]);
+    if (fw == nullptr)
+    {
+        Printf("Unable to open %s\n", argv[1]);
+        return;
+    }
+    int32_t header[2] = { numsectors, (int32_t)canseeRecording.Size() };
+    fw->Write(canseeRecordId, sizeof(canseeRecordId));
+    fw->Write(header, sizeof(header));
+    fw->Write(canseeRecording.Data(), canseeRecording.Size() * sizeof(CanSeeQuery));
+    delete fw;
+    Printf("%u sight checks written to %s\n", canseeRecording.Size(), argv[1]);
+    canseeRecording.Reset();
+}
+
+//
+// Runs recorded sight checks through canseebatch and the scalar cansee and
+// reports any query where the two disagree.
+//
+CCMD(cansee_replay)
+{
+    if (argv.argc() < 2)
+    {
+        Printf("Usage: cansee_replay <file>\n");
+        return;
+    }
+    FileReader fr;
+    if (!fr.OpenFile(argv[1]))
+    {
+        Printf("Unable to open %s\n", argv[1]);
+        return;
+    }
+    char id[4];
+    int32_t header[2];
+    if (fr.Read(id, sizeof(id)) != sizeof(id) || memcmp(id, canseeRecordId, sizeof(id)) || fr.Read(header, sizeof(header)) != sizeof(header) || header[1] < 0)
+    {
+        Printf("%s is not a sight check recording\n", argv[1]);
+        return;
+    }
+    if (header[0] != numsectors)
+    {
+        Printf("%s was recorded on a different map\n", argv[1]);
+        return;
+    }
+    TArray<CanSeeQuery> queries(header[1], true);
+    if (fr.Read(queries.Data(), queries.Size() * sizeof(CanSeeQuery)) != (FileReader::Size)(queries.Size() * sizeof(CanSeeQuery)))
+    {
+        Printf("%s is truncated\n", argv[1]);
+        return;
+    }
+    if (queries.Size() == 0)
+        return;
+
+    TArray<uint8_t> scalar(queries.Size(), true), batch(queries.Size(), true);
+    for (unsigned i = 0; i < queries.Size(); i++)
+    {
+        auto& q = queries[i];
+        scalar[i] = (uint8_t)cansee(canseeContext, q.start.x, q.start.y, q.start.z, q.startsect, q.end.x, q.end.y, q.end.z, q.endsect);
+    }
+    canseebatch(canseeContext, queries.Data(), queries.Size(), batch.Data());
+
+    int mismatches = 0;
+    for (unsigned i = 0; i < queries.Size(); i++)
+    {
+        if (scalar[i] == batch[i]) continue;
+        auto& q = queries[i];
+        if (mismatches++ < 10)
+            Printf("(%d, %d, %d) in %d to (%d, %d, %d) in %d: cansee %d, canseebatch %d\n", q.start.x, q.start.y, q.start.z, q.startsect,
+                q.end.x, q.end.y, q.end.z, q.endsect, scalar[i], batch[i]);
+    }
+    if (mismatches) Printf(TEXTCOLOR_RED "%d of %u results differ!\n", mismatches, queries.Size());
+    else Printf("%u sight checks replayed, all results match\n", queries.Size());
+}
+
 //
 // neartag
 //
@@ -1198,9 +1666,10 @@ void dragpoint(int16_t pointhighlight, int32_t dax, int32_t day, uint8_t flags)
 
         while (1)
         {
-            sector[wall[w].sector].dirty = 255;
+            sectorGeometry.MarkDirty(wall[w].sector);
             wall[w].x = dax;
             wall[w].y = day;
+            sectorGrid.Extend(wall[w].sector, dax, day);
             walbitmap[w>>3] |= (1<<(w&7));
 
             if (!clockwise)  //search points CCW
@@ -1365,9 +1834,18 @@ void updatesector(int32_t const x, int32_t const y, int16_t * const sectnum)
 
     // we need to support passing in a sectnum of -1, unfortunately
 
-    for (int i = numsectors - 1; i >= 0; --i)
-        if (inside_p(x, y, i))
-            SET_AND_RETURN(*sectnum, i);
+    if (auto cands = sectorGrid.GetCandidates(x, y))
+    {
+        for (auto i : *cands)
+            if (inside_p(x, y, i))
+                SET_AND_RETURN(*sectnum, i);
+    }
+    else
+    {
+        for (int i = numsectors - 1; i >= 0; --i)
+            if (inside_p(x, y, i))
+                SET_AND_RETURN(*sectnum, i);
+    }
 
     *sectnum = -1;
 }
@@ -1422,9 +1900,18 @@ void updatesectorz(int32_t const x, int32_t const y, int32_t const z, int16_t *
     }
 
     // we need to support passing in a sectnum of -1, unfortunately
-    for (int i = numsectors - 1; i >= 0; --i)
-        if (inside_z_p(x, y, z, i))
-            SET_AND_RETURN(*sectnum, i);
+    if (auto cands = sectorGrid.GetCandidates(x, y))
+    {
+        for (auto i : *cands)
+            if (inside_z_p(x, y, z, i))
+                SET_AND_RETURN(*sectnum, i);
+    }
+    else
+    {
+        for (int i = numsectors - 1; i >= 0; --i)
+            if (inside_z_p(x, y, z, i))
+                SET_AND_RETURN(*sectnum, i);
+    }
 
     *sectnum = -1;
 }
@@ -338,6 +338,66 @@ FString SoundStream::GetStats()
 	return "No stream stats available.";
 }
 
+//==========================================================================
+//
+// SoundRenderer :: DecodeSound
+//
+// Decodes a compressed sound into PCM data for LoadSoundRaw. This does not
+// touch the backend so that it can be done on a worker thread.
+//
+//==========================================================================
+
+bool SoundRenderer::DecodeSound(uint8_t *sfxdata, int length, FDecodedSound &result)
+{
+	ChannelConfig chans;
+	SampleType type;
+	int srate;
+	uint32_t loop_start = 0, loop_end = ~0u;
+	zmusic_bool startass = false, endass = false;
+
+	FindLoopTags(sfxdata, length, &loop_start, &startass, &loop_end, &endass);
+	auto decoder = CreateDecoder(sfxdata, length, true);
+	if (!decoder)
+		return false;
+
+	SoundDecoder_GetInfo(decoder, &srate, &chans, &type);
+	result.frequency = srate;
+	result.channels = chans == ChannelConfig_Mono ? 1 : chans == ChannelConfig_Stereo ? 2 : 0;
+	result.bits = type == SampleType_UInt8 ? 8 : type == SampleType_Int16 ? 16 : 0;
+	if (result.channels == 0 || result.bits == 0)
+	{
+		SoundDecoder_Close(decoder);
+		return false;
+	}
+
+	unsigned total = 0;
+	unsigned got;
+
+	result.data.Resize(32768);
+	while ((got = (unsigned)SoundDecoder_Read(decoder, (char*)&result.data[total], result.data.Size() - total)) > 0)
+	{
+		total += got;
+		result.data.Resize(total * 2);
+	}
+	SoundDecoder_Close(decoder);
+	result.data.Resize(total);
+	if (total == 0)
+		return false;
+
+	if (!startass) loop_start = Scale(loop_start, srate, 1000);
+	if (!endass && loop_end != ~0u) loop_end = Scale(loop_end, srate, 1000);
+	const uint32_t samples = total / (result.channels * result.bits / 8);
+	if (loop_start > samples) loop_start = 0;
+	if (loop_end > samples) loop_end = samples;
+
+	if ((loop_start > 0 || loop_end > 0) && loop_end > loop_start)
+	{
+		result.loopstart = loop_start;
+		result.loopend = loop_end;
+	}
+	return true;
+}
+
 //==========================================================================
 //
 // SoundRenderer :: LoadSoundVoc
@@ -88,6 +88,17 @@ typedef bool (*SoundStreamCallback)(SoundStream *stream, void *buff, int len, vo
 struct SoundDecoder;
 class MIDIDevice;
 
+// PCM data produced by SoundRenderer::DecodeSound, ready for LoadSoundRaw.
+struct FDecodedSound
+{
+	TArray<uint8_t> data;
+	int frequency = 0;
+	int channels = 0;
+	int bits = 0;
+	int loopstart = -1;
+	int loopend = -1;
+};
+
 class SoundRenderer
 {
 public:
@@ -99,6 +110,7 @@ public:
 	virtual void SetMusicVolume (float volume) = 0;
 	virtual SoundHandle LoadSound(uint8_t *sfxdata, int length) = 0;
 	SoundHandle LoadSoundVoc(uint8_t *sfxdata, int length);
+	static bool DecodeSound(uint8_t *sfxdata, int length, FDecodedSound &result);	// thread safe
 	virtual SoundHandle LoadSoundRaw(uint8_t *sfxdata, int length, int frequency, int channels, int bits, int loopstart, int loopend = -1) = 0;
 	virtual void UnloadSound (SoundHandle sfx) = 0;	// unloads a sound from memory
 	virtual unsigned int GetMSLength(SoundHandle sfx) = 0;	// Gets the length of a sound at its default frequency
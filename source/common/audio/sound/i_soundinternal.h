@@ -32,6 +32,7 @@ enum EChanFlag
 	CHANF_LOCAL = 16384,	// only plays locally for the calling actor
 	CHANF_TRANSIENT = 32768,	// Do not record in savegames - used for sounds that get restarted outside the sound system (e.g. ambients in SW and Blood)
 	CHANF_FORCE = 65536,		// Start, even if sound is paused.
+	CHANF_DECODING = 131072,	// internal: Waiting for the sound to be decoded in the background.
 };
 
 typedef TFlags<EChanFlag> EChanFlags;
@@ -35,6 +35,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "templates.h"
 #include "s_soundinternal.h"
@@ -44,8 +47,14 @@
 #include "m_random.h"
 #include "printf.h"
 #include "c_cvars.h"
+#include "i_time.h"
 
 CVARD(Bool, snd_enabled, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG, "enables/disables sound effects")
+CVARD(Bool, snd_asyncdecode, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG, "decode compressed sounds in the background when they are first played")
+CUSTOM_CVARD(Int, snd_decodelatency, 150, CVAR_ARCHIVE | CVAR_GLOBALCONFIG, "maximum delay in ms for a sound waiting to be decoded")
+{
+	if (self < 0) self = 0;
+}
 
 int SoundEnabled()
 {
@@ -108,6 +117,8 @@ void SoundEngine::Shutdown ()
 		delete chan;
 	}
 	FreeChannels = NULL;
+
+	DestroyDecodeQueue();
 }
 
 //==========================================================================
@@ -488,7 +499,7 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 	}
 
 	// Make sure the sound is loaded.
-	sfx = LoadSound(sfx);
+	sfx = LoadSound(sfx, snd_asyncdecode);
 
 	// The empty sound never plays.
 	if (sfx->lumpnum == sfx_empty)
@@ -496,6 +507,12 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 		return NULL;
 	}
 
+	// If it is still being decoded, set up an evicted channel that gets started once the data is ready.
+	if (sfx->bDecoding)
+	{
+		chanflags |= CHANF_EVICTED | CHANF_DECODING;
+	}
+
 	// Select priority.
 	if (type == SOURCE_None || source == listener.ListenerObject)
 	{
@@ -582,6 +599,12 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 		GSnd->MarkStartTime(chan);
 		chanflags |= CHANF_EVICTED;
 	}
+	else if (chan == NULL && (chanflags & CHANF_DECODING))
+	{
+		// Non-looping sounds should play from the start, just a bit late, or not at all.
+		chan = (FSoundChan*)GetChannel(NULL);
+		chan->DecodeDeadline = I_msTime() + snd_decodelatency;
+	}
 	if (attenuation > 0 && type != SOURCE_None)
 	{
 		chanflags |= CHANF_IS3D | CHANF_JUSTSTARTED;
@@ -715,14 +738,12 @@ void SoundEngine::RestartChannel(FSoundChan *chan)
 //
 //==========================================================================
 
-sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
+sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx, bool async)
 {
 	if (GSnd->IsNull()) return sfx;
 
 	while (!sfx->data.isValid())
 	{
-		unsigned int i;
-
 		if (sfx->lumpnum == sfx_empty)
 		{
 			return sfx;
@@ -730,18 +751,23 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 		
 		// See if there is another sound already initialized with this lump. If so,
 		// then set this one up as a link, and don't load the sound again.
-		for (i = 0; i < S_sfx.Size(); i++)
+		auto other = FindLoadedLump(sfx);
+		if (other != nullptr)
 		{
-			if (S_sfx[i].data.isValid() && S_sfx[i].link == sfxinfo_t::NO_LINK && S_sfx[i].lumpnum == sfx->lumpnum &&
-				(!sfx->bLoadRAW || (sfx->RawRate == S_sfx[i].RawRate)))	// Raw sounds with different sample rates may not share buffers, even if they use the same source data.
-			{
-				DPrintf (DMSG_NOTIFY, "Linked %s to %s (%d)\n", sfx->name.GetChars(), S_sfx[i].name.GetChars(), i);
-				sfx->link = i;
-				// This is necessary to avoid using the rolloff settings of the linked sound if its
-				// settings are different.
-				if (sfx->Rolloff.MinDistance == 0) sfx->Rolloff = S_Rolloff;
-				return &S_sfx[i];
-			}
+			DPrintf (DMSG_NOTIFY, "Linked %s to %s (%td)\n", sfx->name.GetChars(), other->name.GetChars(), other - &S_sfx[0]);
+			sfx->link = unsigned(other - &S_sfx[0]);
+			// This is necessary to avoid using the rolloff settings of the linked sound if its
+			// settings are different.
+			if (sfx->Rolloff.MinDistance == 0) sfx->Rolloff = S_Rolloff;
+			return other;
+		}
+
+		if (sfx->bDecoding)
+		{
+			if (async) return sfx;
+			// Needed right now so wait for the background thread or take the job back from it.
+			FinishDecodes(sfx);
+			continue;
 		}
 
 		DPrintf(DMSG_NOTIFY, "Loading sound \"%s\" (%td)\n", sfx->name.GetChars(), sfx - &S_sfx[0]);
@@ -770,6 +796,12 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 				sfx->data = GSnd->LoadSoundRaw(sfxdata.Data()+8, dmxlen, frequency, 1, 8, sfx->LoopStart);
 			}
 			// If that fails, let the sound system try and figure it out.
+			// This is the expensive case so do it in the background if possible.
+			else if (async)
+			{
+				QueueDecode(sfx, sfxdata);
+				return sfx;
+			}
 			else
 			{
 				sfx->data = GSnd->LoadSound(sfxdata.Data(), size);
@@ -784,11 +816,233 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 				continue;
 			}
 		}
+		else LoadedLumps[sfx->lumpnum] = unsigned(sfx - &S_sfx[0]);
 		break;
 	}
 	return sfx;
 }
 
+//==========================================================================
+//
+// Background decoding of compressed sounds
+//
+// Only the decoding runs on the worker thread. Reading the lump and
+// passing the decoded data to the backend is done on the main thread.
+//
+//==========================================================================
+
+struct FDecodeJob
+{
+	unsigned sfx;
+	unsigned generation;
+	bool ok;
+	TArray<uint8_t> sfxdata;
+	FDecodedSound result;
+};
+
+class FSoundDecodeQueue
+{
+	std::thread Thread;
+	std::mutex Mutex;
+	std::condition_variable Wake, Done;
+	TArray<FDecodeJob*> Pending, Finished;
+	bool Quit = false;
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		while (true)
+		{
+			Wake.wait(lock, [this] { return Quit || Pending.Size() > 0; });
+			if (Quit) return;
+			auto job = Pending[0];
+			Pending.Delete(0);
+			lock.unlock();
+			job->ok = SoundRenderer::DecodeSound(job->sfxdata.Data(), job->sfxdata.Size(), job->result);
+			lock.lock();
+			Finished.Push(job);
+			Done.notify_all();
+		}
+	}
+
+public:
+	FSoundDecodeQueue()
+	{
+		Thread = std::thread([this] { Run(); });
+	}
+
+	~FSoundDecodeQueue()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Quit = true;
+		}
+		Wake.notify_one();
+		Thread.join();
+		for (auto job : Pending) delete job;
+		for (auto job : Finished) delete job;
+	}
+
+	void Submit(FDecodeJob* job)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Pending.Push(job);
+		Wake.notify_one();
+	}
+
+	// Takes back a job that has not been started yet.
+	FDecodeJob* Withdraw(unsigned sfx, unsigned generation)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (unsigned i = 0; i < Pending.Size(); i++)
+		{
+			if (Pending[i]->sfx == sfx && Pending[i]->generation == generation)
+			{
+				auto job = Pending[i];
+				Pending.Delete(i);
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	// Optionally blocks until the job for the given sound is done.
+	void TakeFinished(TArray<FDecodeJob*>& jobs, unsigned waitfor = ~0u)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		if (waitfor != ~0u)
+		{
+			Done.wait(lock, [&]
+			{
+				for (auto job : Finished) if (job->sfx == waitfor) return true;
+				return false;
+			});
+		}
+		jobs.Append(Finished);
+		Finished.Clear();
+	}
+};
+
+//==========================================================================
+//
+// Finds a sound that already holds the data for this sound's lump.
+//
+//==========================================================================
+
+sfxinfo_t* SoundEngine::FindLoadedLump(sfxinfo_t* sfx)
+{
+	auto index = LoadedLumps.CheckKey(sfx->lumpnum);
+	if (index == nullptr) return nullptr;
+
+	auto other = *index < S_sfx.Size() ? &S_sfx[*index] : nullptr;
+	if (other == nullptr || !other->data.isValid() || other->link != sfxinfo_t::NO_LINK || other->lumpnum != sfx->lumpnum)
+	{
+		// Got unloaded or redefined in the meantime.
+		LoadedLumps.Remove(sfx->lumpnum);
+		return nullptr;
+	}
+	// Raw sounds with different sample rates may not share buffers, even if they use the same source data.
+	if (sfx->bLoadRAW && sfx->RawRate != other->RawRate) return nullptr;
+	return other;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void SoundEngine::QueueDecode(sfxinfo_t* sfx, TArray<uint8_t>& sfxdata)
+{
+	if (DecodeQueue == nullptr) DecodeQueue = new FSoundDecodeQueue;
+	auto job = new FDecodeJob;
+	job->sfx = unsigned(sfx - &S_sfx[0]);
+	job->generation = DecodeGeneration;
+	job->ok = false;
+	job->sfxdata = std::move(sfxdata);
+	sfx->bDecoding = true;
+	DecodeQueue->Submit(job);
+}
+
+//==========================================================================
+//
+// Passes all decoded sounds to the backend. If 'waitfor' is given, that
+// sound is guaranteed to be no longer pending afterward.
+//
+//==========================================================================
+
+void SoundEngine::FinishDecodes(sfxinfo_t* waitfor)
+{
+	if (DecodeQueue == nullptr) return;
+
+	TArray<FDecodeJob*> jobs;
+	unsigned waitindex = ~0u;
+	if (waitfor != nullptr)
+	{
+		waitindex = unsigned(waitfor - &S_sfx[0]);
+		auto job = DecodeQueue->Withdraw(waitindex, DecodeGeneration);
+		if (job != nullptr)
+		{
+			// Nothing done yet so the caller can just as well load it itself.
+			delete job;
+			waitfor->bDecoding = false;
+			waitindex = ~0u;
+		}
+	}
+	DecodeQueue->TakeFinished(jobs, waitindex);
+
+	for (auto job : jobs)
+	{
+		auto sfx = job->sfx < S_sfx.Size() ? &S_sfx[job->sfx] : nullptr;
+		if (job->generation == DecodeGeneration && sfx != nullptr && sfx->bDecoding)
+		{
+			sfx->bDecoding = false;
+			if (!sfx->data.isValid() && !GSnd->IsNull())
+			{
+				auto& pcm = job->result;
+				if (job->ok)
+				{
+					sfx->data = GSnd->LoadSoundRaw(pcm.data.Data(), pcm.data.Size(), pcm.frequency, pcm.channels, pcm.bits, pcm.loopstart, pcm.loopend);
+				}
+				if (!sfx->data.isValid())
+				{
+					// Let the backend have a go at it so that any errors get reported.
+					sfx->data = GSnd->LoadSound(job->sfxdata.Data(), job->sfxdata.Size());
+				}
+				if (sfx->data.isValid()) LoadedLumps[sfx->lumpnum] = job->sfx;
+				else sfx->lumpnum = sfx_empty;
+			}
+		}
+		delete job;
+	}
+}
+
+//==========================================================================
+//
+// Any decode still in progress gets discarded when it is done.
+//
+//==========================================================================
+
+void SoundEngine::CancelDecodes()
+{
+	DecodeGeneration++;
+	for (auto& sfx : S_sfx) sfx.bDecoding = false;
+}
+
+//==========================================================================
+//
+// Stops the decoder thread. This must be defined after FSoundDecodeQueue,
+// otherwise its destructor will not be called.
+//
+//==========================================================================
+
+void SoundEngine::DestroyDecodeQueue()
+{
+	CancelDecodes();
+	delete DecodeQueue;
+	DecodeQueue = nullptr;
+}
+
 //==========================================================================
 //
 // S_CheckSingular
@@ -1213,6 +1467,18 @@ void SoundEngine::RestoreEvictedChannel(FSoundChan *chan)
 		return;
 	}
 	RestoreEvictedChannel(chan->NextChan);
+	if (chan->ChanFlags & CHANF_DECODING)
+	{
+		if (S_sfx[chan->SoundID].bDecoding)
+		{
+			if (!(chan->ChanFlags & CHANF_LOOP) && I_msTime() > chan->DecodeDeadline)
+			{ // Too late to be of any use.
+				ReturnChannel(chan);
+			}
+			return;
+		}
+		chan->ChanFlags &= ~CHANF_DECODING;
+	}
 	if (chan->ChanFlags & CHANF_EVICTED)
 	{
 		RestartChannel(chan);
@@ -1276,6 +1542,7 @@ void SoundEngine::UpdateSounds(int time)
 
 	GSnd->UpdateListener(&listener);
 	GSnd->UpdateSounds();
+	FinishDecodes();
 
 	if (time >= RestartEvictionsAt)
 	{
@@ -1437,10 +1704,12 @@ void SoundEngine::StopChannel(FSoundChan *chan)
 
 void SoundEngine::UnloadAllSounds()
 {
+	CancelDecodes();
 	for (unsigned i = 0; i < S_sfx.Size(); i++)
 	{
 		UnloadSound(&S_sfx[i]);
 	}
+	LoadedLumps.Clear();
 }
 
 void SoundEngine::Reset()
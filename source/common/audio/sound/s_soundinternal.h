@@ -43,6 +43,7 @@ struct sfxinfo_t
 	bool		bUsed = false;
 	bool		bSingular = false;
 	bool		bTentative = true;
+	bool		bDecoding = false;					// being decoded by the background thread
 
 	TArray<int> UserData;
 
@@ -146,6 +147,7 @@ struct FSoundChan : public FISoundChannel
 	float		LimitRange;
 	const void *Source;
 	float Point[3];	// Sound is not attached to any source.
+	uint64_t	DecodeDeadline;	// in ms. A non-looping sound that is not decoded by then will be dropped.
 };
 
 
@@ -196,7 +198,9 @@ void S_SetEnvironment (const ReverbContainer *settings);
 ReverbContainer *S_FindEnvironment (const char *name);
 ReverbContainer *S_FindEnvironment (int id);
 void S_AddEnvironment (ReverbContainer *settings);
-	
+
+class FSoundDecodeQueue;
+
 class SoundEngine
 {
 protected:
@@ -213,6 +217,9 @@ protected:
 	TArray<uint8_t> S_SoundCurve;
 	TMap<int, int> ResIdMap;
 	TArray<FRandomSoundList> S_rnd;
+	TMap<int, unsigned> LoadedLumps;	// lump number -> sound holding the data for it, for linking duplicates
+	FSoundDecodeQueue* DecodeQueue = nullptr;
+	unsigned DecodeGeneration = 0;
 	bool blockNewSounds = false;
 
 private:
@@ -232,6 +239,11 @@ private:
 
 	// Checks if a copy of this sound is already playing.
 	bool CheckSingular(int sound_id);
+	sfxinfo_t* FindLoadedLump(sfxinfo_t* sfx);
+	void QueueDecode(sfxinfo_t* sfx, TArray<uint8_t>& sfxdata);
+	void FinishDecodes(sfxinfo_t* waitfor = nullptr);
+	void CancelDecodes();
+	void DestroyDecodeQueue();
 	virtual TArray<uint8_t> ReadSound(int lumpnum) = 0;
 protected:
 	virtual bool CheckSoundLimit(sfxinfo_t* sfx, const FVector3& pos, int near_limit, float limit_range, int sourcetype, const void* actor, int channel, float attenuation);
@@ -253,7 +265,7 @@ public:
 	virtual void SetSource(FSoundChan* chan, int index) {}
 
 	virtual void StopChannel(FSoundChan* chan);
-	sfxinfo_t* LoadSound(sfxinfo_t* sfx);
+	sfxinfo_t* LoadSound(sfxinfo_t* sfx, bool async = false);
 	const sfxinfo_t* GetSfx(unsigned snd)
 	{
 		if (snd >= S_sfx.Size()) return nullptr;
@@ -425,9 +425,15 @@ void WriteLineToLog(FILE *LogFile, const char *outline)
 }
 
 extern bool gameisdead;
+thread_local FString* PrintCapture;
 
 int PrintString (int iprintlevel, const char *outline)
 {
+	if (PrintCapture)
+	{
+		if ((iprintlevel & PRINT_TYPES) != PRINT_LOG) *PrintCapture += outline;
+		return (int)strlen(outline);
+	}
 	if (gameisdead)
 		return 0;
 
@@ -42,6 +42,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <thread>
+#include <atomic>
 #include "c_console.h"
 #include "c_dispatch.h"
 #include "engineerrors.h"
@@ -52,6 +54,8 @@
 #include "version.h"
 #include "findfile.h"
 #include "md5.h"
+#include "m_crc32.h"
+#include "i_time.h"
 
 extern FILE* Logfile;
 
@@ -318,6 +322,99 @@ CCMD (md5sum)
 	}
 }
 
+//==========================================================================
+//
+// CCMD fs_stresstest
+//
+// Reads all lumps from multiple threads at once, using the different
+// read functions in a different order per thread, and compares them
+// against a single threaded read.
+//
+//==========================================================================
+
+static uint32_t StressReadLump(int lump, int method)
+{
+	switch (method)
+	{
+	default:
+	{
+		auto data = fileSystem.GetFileData(lump);
+		return CalcCRC32(data.Data(), data.Size());
+	}
+
+	case 1:
+	{
+		auto data = fileSystem.ReadFile(lump);
+		return CalcCRC32((const uint8_t*)data.GetMem(), data.GetSize());
+	}
+
+	case 2:
+	{
+		// small reads to interleave with the other threads as much as possible.
+		auto fr = fileSystem.OpenFileReader(lump);
+		uint8_t buffer[1000];
+		uint32_t crc = 0;
+		long len;
+		while ((len = fr.Read(buffer, sizeof(buffer))) > 0)
+		{
+			crc = AddCRC32(crc, buffer, len);
+		}
+		return crc;
+	}
+	}
+}
+
+CCMD(fs_stresstest)
+{
+	int numthreads = argv.argc() > 1 ? (int)strtol(argv[1], nullptr, 0) : 0;
+	if (numthreads <= 0) numthreads = std::max(2u, std::thread::hardware_concurrency());
+	int first = 0, count = fileSystem.GetNumEntries();
+	if (argv.argc() > 2)
+	{
+		int wadnum = fileSystem.CheckIfResourceFileLoaded(argv[2]);
+		if (wadnum < 0)
+		{
+			Printf("%s is not loaded.\n", argv[2]);
+			return;
+		}
+		first = fileSystem.GetFirstEntry(wadnum);
+		count = fileSystem.GetEntryCount(wadnum);
+	}
+	if (count <= 0) return;
+
+	TArray<uint32_t> reference(count, true);
+	size_t totalsize = 0;
+	for (int i = 0; i < count; i++)
+	{
+		reference[i] = StressReadLump(first + i, 0);
+		totalsize += fileSystem.FileLength(first + i);
+	}
+
+	std::atomic<int> errors{ 0 };
+	auto start = I_nsTime();
+	TArray<std::thread> threads;
+	for (int t = 0; t < numthreads; t++)
+	{
+		threads.Push(std::thread([&, t]()
+		{
+			// Each thread starts at a different lump and alternates the read methods.
+			int offset = int((int64_t)count * t / numthreads);
+			for (int i = 0; i < count; i++)
+			{
+				int index = (offset + i) % count;
+				if (StressReadLump(first + index, (i + t) % 3) != reference[index])
+				{
+					errors++;
+				}
+			}
+		}));
+	}
+	for (auto& thread : threads) thread.join();
+	double time = (I_nsTime() - start) / 1e6;
+
+	Printf("%d threads read %d lumps (%.1f MB) each in %.1f ms, %d mismatches\n", numthreads, count, totalsize / 1048576., time, errors.load());
+}
+
 CCMD(printlocalized)
 {
 	if (argv.argc() > 1)
@@ -62,8 +62,7 @@ void PaletteContainer::Init(int numslots, const uint8_t* indexmap)	// This canno
 	remap.Inactive = true;
 	TranslationTables.Resize(numslots);
 	StoreTranslation(0, &remap);	// make sure that translation ID 0 is the identity.
-	ColorMatcher.SetPalette(BaseColors);
-	ColorMatcher.SetIndexMap(indexmap);
+	ColorMatcher.SetIndexMap(indexmap);	// the palette gets passed along once SetPalette provides the colors.
 }
 
 void PaletteContainer::SetPalette(const uint8_t* colors, int transparent_index)
@@ -86,6 +85,7 @@ void PaletteContainer::SetPalette(const uint8_t* colors, int transparent_index)
 	}
 
 	uniqueRemaps[0]->crc32 = CalcCRC32((uint8_t*)uniqueRemaps[0]->Palette, sizeof(uniqueRemaps[0]->Palette));
+	ColorMatcher.SetPalette(BaseColors);	// the color matcher needs to rebuild its lookup data.
 
 
 	// Find white and black from the original palette so that they can be
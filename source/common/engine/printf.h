@@ -87,6 +87,11 @@ int Printf (int printlevel, const char *format, ...) ATTRIBUTE((format(printf,2,
 int Printf (const char *format, ...) ATTRIBUTE((format(printf,1,2)));
 int DPrintf (int level, const char *format, ...) ATTRIBUTE((format(printf,2,3)));
 
+// If set, output of the current thread is appended here instead of being printed.
+// For worker threads whose messages need to be printed later by the main thread.
+class FString;
+extern thread_local FString* PrintCapture;
+
 void I_DebugPrint(const char* cp);
 void debugprintf(const char* f, ...);	// Prints to the debugger's log.
 
@@ -57,17 +57,24 @@ ColorTable256k RGB256k;
 void BuildTransTable (const PalEntry *palette)
 {
 	int r, g, b;
+	PalEntry row[64];
 	
 	// create the RGB555 lookup table
 	for (r = 0; r < 32; r++)
 		for (g = 0; g < 32; g++)
+		{
 			for (b = 0; b < 32; b++)
-				RGB32k.RGB[r][g][b] = ColorMatcher.Pick ((r<<3)|(r>>2), (g<<3)|(g>>2), (b<<3)|(b>>2));
+				row[b] = PalEntry((r<<3)|(r>>2), (g<<3)|(g>>2), (b<<3)|(b>>2));
+			ColorMatcher.PickBatch(row, RGB32k.RGB[r][g], 32);
+		}
 	// create the RGB666 lookup table
 	for (r = 0; r < 64; r++)
 		for (g = 0; g < 64; g++)
+		{
 			for (b = 0; b < 64; b++)
-				RGB256k.RGB[r][g][b] = ColorMatcher.Pick ((r<<2)|(r>>4), (g<<2)|(g>>4), (b<<2)|(b>>4));
+				row[b] = PalEntry((r<<2)|(r>>4), (g<<2)|(g>>4), (b<<2)|(b>>4));
+			ColorMatcher.PickBatch(row, RGB256k.RGB[r][g], 64);
+		}
 	
 	int x, y;
 	
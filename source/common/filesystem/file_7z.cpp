@@ -186,6 +186,7 @@ class F7ZFile : public FResourceFile
 
 	F7ZLump *Lumps;
 	C7zArchive *Archive;
+	std::mutex ExtractMutex;	// the 7z decoder keeps state in the archive object.
 
 public:
 	F7ZFile(const char * filename, FileReader &filer);
@@ -344,8 +345,10 @@ F7ZFile::~F7ZFile()
 
 int F7ZLump::FillCache()
 {
+	auto file = static_cast<F7ZFile*>(Owner);
+	std::lock_guard<std::mutex> lock(file->ExtractMutex);
 	Cache = new char[LumpSize];
-	static_cast<F7ZFile*>(Owner)->Archive->Extract(Position, Cache);
+	file->Archive->Extract(Position, Cache);
 	RefCount = 1;
 	return 1;
 }
@@ -75,7 +75,6 @@ public:
 	{
 		if(!Compressed)
 		{
-			Owner->Reader.Seek(Position, FileReader::SeekSet);
 			return &Owner->Reader;
 		}
 		return NULL;
@@ -95,19 +94,19 @@ public:
 			}
 		}
 
-		Owner->Reader.Seek(Position, FileReader::SeekSet);
 		Cache = new char[LumpSize];
 
 		if(Compressed)
 		{
-			FileReader lzss;
-			if (lzss.OpenDecompressor(Owner->Reader, LumpSize, METHOD_LZSS, false, [](const char* err) { I_Error("%s", err); }))
+			FileReader part, lzss;
+			part.OpenFilePart(Owner->Reader, Position, (long)Owner->Reader.GetLength() - Position);
+			if (lzss.OpenDecompressor(part, LumpSize, METHOD_LZSS, false, [](const char* err) { I_Error("%s", err); }))
 			{
 				lzss.Read(Cache, LumpSize);
 			}
 		}
 		else
-			Owner->Reader.Read(Cache, LumpSize);
+			Owner->Reader.ReadAt(Cache, LumpSize, Position);
 
 		RefCount = 1;
 		return 1;
@@ -404,7 +403,7 @@ void FWadFile::SetNamespace(const char *startmarker, const char *endmarker, name
 void FWadFile::SkinHack ()
 {
 	// this being static is not a problem. The only relevant thing is that each skin gets a different number.
-	static int namespc = ns_firstskin;
+	static std::atomic<int> namespc{ ns_firstskin };
 	bool skinned = false;
 	bool hasmap = false;
 	uint32_t i;
@@ -420,12 +419,12 @@ void FWadFile::SkinHack ()
 			{
 				skinned = true;
 				uint32_t j;
+				int skinns = namespc++;
 
 				for (j = 0; j < NumLumps; j++)
 				{
-					Lumps[j].Namespace = namespc;
+					Lumps[j].Namespace = skinns;
 				}
-				namespc++;
 			}
 		}
 		if ((lump->getName()[0] == 'M' &&
@@ -382,8 +382,7 @@ FCompressedBuffer FZipLump::GetRawData()
 {
 	FCompressedBuffer cbuf = { (unsigned)LumpSize, (unsigned)CompressedSize, Method, GPFlags, CRC32, new char[CompressedSize] };
 	if (NeedFileStart) SetLumpAddress();
-	Owner->Reader.Seek(Position, FileReader::SeekSet);
-	Owner->Reader.Read(cbuf.mBuffer, CompressedSize);
+	Owner->Reader.ReadAt(cbuf.mBuffer, CompressedSize, Position);
 	return cbuf;
 }
 
@@ -401,8 +400,9 @@ void FZipLump::SetLumpAddress()
 	FZipLocalFileHeader localHeader;
 	int skiplen;
 
-	Owner->Reader.Seek(Position, FileReader::SeekSet);
-	Owner->Reader.Read(&localHeader, sizeof(localHeader));
+	std::lock_guard<std::recursive_mutex> lock(GetMutex());
+	if (!NeedFileStart) return;	// another thread got here first.
+	Owner->Reader.ReadAt(&localHeader, sizeof(localHeader), Position);
 	skiplen = LittleShort(localHeader.NameLength) + LittleShort(localHeader.ExtraLength);
 	Position += sizeof(localHeader) + skiplen;
 	NeedFileStart = false;
@@ -421,7 +421,6 @@ FileReader *FZipLump::GetReader()
 	if (Method == METHOD_STORED)
 	{
 		if (NeedFileStart) SetLumpAddress();
-		Owner->Reader.Seek(Position, FileReader::SeekSet);
 		return &Owner->Reader;
 	}
 	else return NULL;	
@@ -446,9 +445,10 @@ int FZipLump::FillCache()
 		return -1;
 	}
 
-	Owner->Reader.Seek(Position, FileReader::SeekSet);
+	FileReader part;
+	part.OpenFilePart(Owner->Reader, Position, CompressedSize);
 	Cache = new char[LumpSize];
-	UncompressZipLump(Cache, Owner->Reader, Method, LumpSize, CompressedSize, GPFlags);
+	UncompressZipLump(Cache, part, Method, LumpSize, CompressedSize, GPFlags);
 	RefCount = 1;
 	return 1;
 }
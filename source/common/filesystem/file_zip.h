@@ -13,7 +13,7 @@ struct FZipLump : public FResourceLump
 {
 	uint16_t	GPFlags;
 	uint8_t	Method;
-	bool	NeedFileStart;
+	std::atomic<bool> NeedFileStart;
 	int		CompressedSize;
 	int		Position;
 	unsigned CRC32;
@@ -39,6 +39,9 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <thread>
+#include <atomic>
+#include <exception>
 
 #include "m_argv.h"
 #include "cmdlib.h"
@@ -46,6 +49,8 @@
 #include "m_crc32.h"
 #include "printf.h"
 #include "md5.h"
+#include "stats.h"
+#include "i_time.h"
 
 extern	FILE* hashfile;
 
@@ -156,6 +161,31 @@ struct FileSystem::LumpRecord
 
 static void PrintLastError ();
 
+//==========================================================================
+//
+// Runs func(first, last) on ranges of [0, count) on all available cores.
+// Small jobs stay on the calling thread.
+//
+//==========================================================================
+
+template<class Func>
+static void ParallelRange(unsigned count, unsigned minperthread, Func func)
+{
+	unsigned numthreads = std::min<unsigned>(std::max(std::thread::hardware_concurrency(), 1u), count / std::max(minperthread, 1u));
+	if (numthreads <= 1 || Args->CheckParm("-serialfs"))
+	{
+		func(0u, count);
+		return;
+	}
+	TArray<std::thread> threads;
+	for (unsigned t = 1; t < numthreads; t++)
+	{
+		threads.Push(std::thread(func, unsigned(uint64_t(count) * t / numthreads), unsigned(uint64_t(count) * (t + 1) / numthreads)));
+	}
+	func(0u, unsigned(count / numthreads));
+	for (auto& thread : threads) thread.join();
+}
+
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
 FileSystem fileSystem;
@@ -208,23 +238,88 @@ void FileSystem::InitSingleFile(const char* filename, bool quiet)
 	InitMultipleFiles(filenames, true);
 }
 
+//==========================================================================
+//
+// The archives are opened and their directories parsed in parallel.
+// Each worker gets its own copy of the filter because FString's reference
+// counting is not thread safe, and its console output is collected and
+// printed in load order afterward.
+//
+//==========================================================================
+
+struct FOpenedArchive
+{
+	FResourceFile *resfile = nullptr;
+	FileReader reader;
+	FString messages;
+	std::exception_ptr error;
+};
+
+static void CopyFilterStrings(TArray<FString>& to, const TArray<FString>& from)
+{
+	to.Clear();
+	for (auto& str : from) to.Push(FString(str.GetChars()));
+}
+
+static void CopyFilter(LumpFilterInfo& to, const LumpFilterInfo& from)
+{
+	CopyFilterStrings(to.gameTypeFilter, from.gameTypeFilter);
+	to.dotFilter = from.dotFilter.GetChars();
+	CopyFilterStrings(to.reservedFolders, from.reservedFolders);
+	CopyFilterStrings(to.requiredPrefixes, from.requiredPrefixes);
+	CopyFilterStrings(to.embeddings, from.embeddings);
+}
+
+static FResourceFile *OpenArchive(const char *filename, FileReader *filer, FileReader &filereader, bool quiet, LumpFilterInfo* filter);
+
 void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, LumpFilterInfo* filter)
 {
 	int numfiles;
+	uint64_t starttime = I_nsTime();
 
 	// open all the files, load headers, and count lumps
 	DeleteAll();
 	numfiles = 0;
 
+	TArray<FOpenedArchive> archives(filenames.Size(), true);
+	ParallelRange(filenames.Size(), 2, [&](unsigned first, unsigned last)
+	{
+		LumpFilterInfo localfilter;
+		if (filter) CopyFilter(localfilter, *filter);
+		for (unsigned i = first; i < last; i++)
+		{
+			auto& archive = archives[i];
+			FString filename = filenames[i].GetChars();
+			PrintCapture = &archive.messages;
+			try
+			{
+				archive.resfile = OpenArchive(filename, nullptr, archive.reader, quiet, filter ? &localfilter : nullptr);
+			}
+			catch (...)
+			{
+				archive.error = std::current_exception();
+			}
+			PrintCapture = nullptr;
+		}
+	});
+	uint64_t opentime = I_nsTime();
+
 	for(unsigned i=0;i<filenames.Size(); i++)
 	{
-		int baselump = NumEntries;
-		AddFile (filenames[i], nullptr, quiet, filter);
+		auto& archive = archives[i];
+		if (archive.messages.IsNotEmpty()) Printf("%s", archive.messages.GetChars());
+		if (archive.error)
+		{
+			for (unsigned j = i + 1; j < filenames.Size(); j++) delete archives[j].resfile;
+			std::rethrow_exception(archive.error);
+		}
+		if (archive.resfile) AddResourceFile(filenames[i], archive.resfile, archive.reader, quiet, filter);
 		
 		if (i == (unsigned)MaxIwadIndex) MoveLumpsInFolder("after_iwad/");
 		FStringf path("filter/%s", Files.Last()->GetHash().GetChars());
 		MoveLumpsInFolder(path);
 	}
+	uint64_t addtime = I_nsTime();
 	
 	NumEntries = FileInfo.Size();
 	if (NumEntries == 0)
@@ -233,9 +328,18 @@ void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, Lump
 		else return;
 	}
 	if (filter && filter->postprocessFunc) filter->postprocessFunc();
+	uint64_t posttime = I_nsTime();
 
 	// [RH] Set up hash table
 	InitHashChains ();
+	uint64_t endtime = I_nsTime();
+
+	if (!quiet && Args->CheckParm("-stdout"))
+	{
+		Printf("File system setup: %u files, %u lumps, %.1f ms (open %.1f, add %.1f, postprocess %.1f, hash %.1f)\n",
+			Files.Size(), NumEntries, (endtime - starttime) / 1e6, (opentime - starttime) / 1e6, (addtime - opentime) / 1e6,
+			(posttime - addtime) / 1e6, (endtime - posttime) / 1e6);
+	}
 }
 
 //==========================================================================
@@ -297,9 +401,23 @@ int FileSystem::AddFromBuffer(const char* name, const char* type, char* data, in
 
 void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, LumpFilterInfo* filter)
 {
-	int startlump;
-	bool isdir = false;
 	FileReader filereader;
+	FResourceFile *resfile = OpenArchive(filename, filer, filereader, quiet, filter);
+	if (resfile != NULL) AddResourceFile(filename, resfile, filereader, quiet, filter);
+}
+
+//==========================================================================
+//
+// OpenArchive
+//
+// Opens a file or directory and reads its directory. Does not touch the
+// file system's state so that multiple files can be opened in parallel.
+//
+//==========================================================================
+
+static FResourceFile *OpenArchive(const char *filename, FileReader *filer, FileReader &filereader, bool quiet, LumpFilterInfo* filter)
+{
+	bool isdir = false;
 
 	if (filer == nullptr)
 	{
@@ -311,73 +429,106 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 				Printf(TEXTCOLOR_RED "%s: File or Directory not found\n", filename);
 				PrintLastError();
 			}
-			return;
+			return nullptr;
 		}
 
 		if (!isdir)
 		{
-			if (!filereader.OpenFile(filename))
+			// Map archives into memory so that stored lumps can be used in place.
+			bool mapped = !Args->CheckParm("-nommap") && filereader.OpenFileMapped(filename);
+			if (!mapped && !filereader.OpenFile(filename))
 			{ // Didn't find file
 				if (!quiet)
 				{
 					Printf(TEXTCOLOR_RED "%s: File not found\n", filename);
 					PrintLastError();
 				}
-				return;
+				return nullptr;
 			}
 		}
 	}
 	else filereader = std::move(*filer);
 
 	if (!batchrun && !quiet) Printf (" adding %s", filename);
-	startlump = NumEntries;
 
-	FResourceFile *resfile;
-	
 	if (!isdir)
-		resfile = FResourceFile::OpenResourceFile(filename, filereader, quiet, false, filter);
+		return FResourceFile::OpenResourceFile(filename, filereader, quiet, false, filter);
 	else
-		resfile = FResourceFile::OpenDirectory(filename, quiet, filter);
+		return FResourceFile::OpenDirectory(filename, quiet, filter);
+}
 
-	if (resfile != NULL)
+//==========================================================================
+//
+// AddResourceFile
+//
+// Adds the lumps of an opened file to the directory
+//
+//==========================================================================
+
+void FileSystem::AddResourceFile(const char *filename, FResourceFile *resfile, FileReader &filereader, bool quiet, LumpFilterInfo* filter)
+{
+	if (!quiet && !batchrun) Printf(", %d lumps\n", resfile->LumpCount());
+
+	uint32_t lumpstart = FileInfo.Size();
+
+	resfile->SetFirstLump(lumpstart);
+	FileInfo.Reserve(resfile->LumpCount());
+	int filenum = Files.Size();
+	ParallelRange(resfile->LumpCount(), 4096, [=](unsigned first, unsigned last)
 	{
-		if (!quiet && !batchrun) Printf(", %d lumps\n", resfile->LumpCount());
+		for (uint32_t i = first; i < last; i++)
+		{
+			FileInfo[lumpstart + i].SetFromLump(filenum, resfile->GetLump(i));
+		}
+	});
 
-		uint32_t lumpstart = FileInfo.Size();
+	Files.Push(resfile);
 
-		resfile->SetFirstLump(lumpstart);
-		for (uint32_t i=0; i < resfile->LumpCount(); i++)
+	for (uint32_t i=0; i < resfile->LumpCount(); i++)
+	{
+		FResourceLump *lump = resfile->GetLump(i);
+		if (lump->Flags & LUMPF_EMBEDDED)
 		{
-			FResourceLump *lump = resfile->GetLump(i);
-			FileSystem::LumpRecord *lump_p = &FileInfo[FileInfo.Reserve(1)];
-			lump_p->SetFromLump(Files.Size(), lump);
+			FString path;
+			path.Format("%s:%s", filename, lump->getName());
+			auto embedded = lump->NewReader();
+			AddFile(path, &embedded, quiet, filter);
 		}
+	}
 
-		Files.Push(resfile);
+	if (hashfile && !quiet)
+	{
+		uint8_t cksum[16];
+		char cksumout[33];
+		memset(cksumout, 0, sizeof(cksumout));
 
-		for (uint32_t i=0; i < resfile->LumpCount(); i++)
+		if (filereader.isOpen())
 		{
-			FResourceLump *lump = resfile->GetLump(i);
-			if (lump->Flags & LUMPF_EMBEDDED)
+			MD5Context md5;
+			filereader.Seek(0, FileReader::SeekSet);
+			md5Update(filereader, md5, (unsigned)filereader.GetLength());
+			md5.Final(cksum);
+
+			for (size_t j = 0; j < sizeof(cksum); ++j)
 			{
-				FString path;
-				path.Format("%s:%s", filename, lump->getName());
-				auto embedded = lump->NewReader();
-				AddFile(path, &embedded, quiet, filter);
+				sprintf(cksumout + (j * 2), "%02X", cksum[j]);
 			}
+
+			fprintf(hashfile, "file: %s, hash: %s, size: %d\n", filename, cksumout, (int)filereader.GetLength());
 		}
 
-		if (hashfile && !quiet)
+		else
+			fprintf(hashfile, "file: %s, Directory structure\n", filename);
+
+		for (uint32_t i = 0; i < resfile->LumpCount(); i++)
 		{
-			uint8_t cksum[16];
-			char cksumout[33];
-			memset(cksumout, 0, sizeof(cksumout));
+			FResourceLump *lump = resfile->GetLump(i);
 
-			if (filereader.isOpen())
+			if (!(lump->Flags & LUMPF_EMBEDDED))
 			{
 				MD5Context md5;
-				filereader.Seek(0, FileReader::SeekSet);
-				md5Update(filereader, md5, (unsigned)filereader.GetLength());
+				auto reader = lump->NewReader();
+				md5Update(reader, md5, lump->LumpSize);
 				md5.Final(cksum);
 
 				for (size_t j = 0; j < sizeof(cksum); ++j)
@@ -385,33 +536,9 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 					sprintf(cksumout + (j * 2), "%02X", cksum[j]);
 				}
 
-				fprintf(hashfile, "file: %s, hash: %s, size: %d\n", filename, cksumout, (int)filereader.GetLength());
-			}
-
-			else
-				fprintf(hashfile, "file: %s, Directory structure\n", filename);
-
-			for (uint32_t i = 0; i < resfile->LumpCount(); i++)
-			{
-				FResourceLump *lump = resfile->GetLump(i);
-
-				if (!(lump->Flags & LUMPF_EMBEDDED))
-				{
-					MD5Context md5;
-					auto reader = lump->NewReader();
-					md5Update(reader, md5, lump->LumpSize);
-					md5.Final(cksum);
-
-					for (size_t j = 0; j < sizeof(cksum); ++j)
-					{
-						sprintf(cksumout + (j * 2), "%02X", cksum[j]);
-					}
-
-					fprintf(hashfile, "file: %s, lump: %s, hash: %s, size: %d\n", filename, lump->getName(), cksumout, lump->LumpSize);
-				}
+				fprintf(hashfile, "file: %s, lump: %s, hash: %s, size: %d\n", filename, lump->getName(), cksumout, lump->LumpSize);
 			}
 		}
-		return;
 	}
 }
 
@@ -866,26 +993,44 @@ void FileSystem::InitHashChains (void)
 	NextLumpIndex_ResId = &Hashes[NumEntries * 7];
 
 
+	// Calculate all hash keys in bulk. This is the expensive part.
+	struct LumpKeys
+	{
+		uint32_t shortname, fullname, noext;
+	};
+	TArray<LumpKeys> keys(NumEntries, true);
+	ParallelRange(NumEntries, 16384, [&](unsigned first, unsigned last)
+	{
+		for (unsigned i = first; i < last; i++)
+		{
+			auto& key = keys[i];
+			auto& longName = FileInfo[i].longName;
+			key.shortname = LumpNameHash(FileInfo[i].shortName.String) % NumEntries;
+			if (longName.IsNotEmpty())
+			{
+				auto dot = longName.LastIndexOf('.');
+				auto slash = longName.LastIndexOf('/');
+				key.fullname = MakeKey(longName.GetChars(), longName.Len()) % NumEntries;
+				key.noext = MakeKey(longName.GetChars(), dot > slash ? dot : longName.Len()) % NumEntries;
+			}
+		}
+	});
+
 	// Now set up the chains
 	for (i = 0; i < (unsigned)NumEntries; i++)
 	{
-		j = LumpNameHash (FileInfo[i].shortName.String) % NumEntries;
+		j = keys[i].shortname;
 		NextLumpIndex[i] = FirstLumpIndex[j];
 		FirstLumpIndex[j] = i;
 
 		// Do the same for the full paths
 		if (FileInfo[i].longName.IsNotEmpty())
 		{
-			j = MakeKey(FileInfo[i].longName) % NumEntries;
+			j = keys[i].fullname;
 			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
 			FirstLumpIndex_FullName[j] = i;
 
-			FString nameNoExt = FileInfo[i].longName;
-			auto dot = nameNoExt.LastIndexOf('.');
-			auto slash = nameNoExt.LastIndexOf('/');
-			if (dot > slash) nameNoExt.Truncate(dot);
-
-			j = MakeKey(nameNoExt) % NumEntries;
+			j = keys[i].noext;
 			NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
 			FirstLumpIndex_NoExt[j] = i;
 
@@ -1430,6 +1575,41 @@ FileReader FileSystem::OpenFileReader(const char* name)
 	else return OpenFileReader(lump);
 }
 
+//==========================================================================
+//
+// Shows how much of each archive is mapped into memory and resident,
+// and how much lump data had to be copied out of it.
+//
+//==========================================================================
+
+FString FileSystem::GetArchiveStats() const
+{
+	FString out;
+	for (auto file : Files)
+	{
+		auto reader = file->GetReader();
+		out.AppendFormat("%s: ", ExtractFileBase(file->FileName, true).GetChars());
+		if (reader == nullptr)
+		{
+			out += "directory";
+		}
+		else
+		{
+			auto resident = reader->GetResidentSize();
+			out.AppendFormat("%s %.1fM, resident ", reader->GetBuffer() ? "mapped" : "file", reader->GetLength() / 1048576.);
+			if (resident >= 0) out.AppendFormat("%.1fM", resident / 1048576.);
+			else out += "n/a";
+		}
+		out.AppendFormat(", copied %.1fM\n", file->CopiedBytes / 1048576.);
+	}
+	return out;
+}
+
+ADD_STAT(archives)
+{
+	return fileSystem.GetArchiveStats();
+}
+
 //==========================================================================
 //
 // GetFileReader
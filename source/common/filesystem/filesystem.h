@@ -128,7 +128,11 @@ public:
 	void SetLinkedTexture(int lump, FGameTexture *tex);
 	FGameTexture *GetLinkedTexture(int lump);
 
-
+	// Reading lumps is thread safe once all files have been added, i.e. ReadFile, GetFileData,
+	// OpenFileReader and ReopenFileReader may be called from any thread, together with the
+	// read-only lookups like CheckNumForFullName, FileLength or GetFileContainer.
+	// Each FileReader returned may only be used by one thread at a time.
+	// Adding, renaming or deleting files and the texture links are not thread safe.
 	void ReadFile (int lump, void *dest);
 	TArray<uint8_t> GetFileData(int lump, int pad = 0);	// reads lump into a writable buffer and optionally adds some padding at the end. (FileData isn't writable!)
 	FileData ReadFile (int lump);
@@ -189,6 +193,7 @@ public:
 	FileReader* GetFileReader(int wadnum);	// Gets a FileReader object to the entire WAD
 	void InitHashChains();
 	FResourceLump* GetFileAt(int no);
+	FString GetArchiveStats() const;
 
 protected:
 
@@ -219,6 +224,7 @@ protected:
 private:
 	void DeleteAll();
 	void MoveLumpsInFolder(const char *);
+	void AddResourceFile(const char *filename, FResourceFile *resfile, FileReader &filereader, bool quiet, LumpFilterInfo* filter);
 
 };
 
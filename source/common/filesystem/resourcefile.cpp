@@ -185,15 +185,28 @@ FileReader FResourceLump::NewReader()
 //
 //==========================================================================
 
+std::recursive_mutex &FResourceLump::GetMutex() const
+{
+	static std::recursive_mutex LumpMutexes[64];
+	return LumpMutexes[(reinterpret_cast<uintptr_t>(this) / sizeof(void*)) % 64];
+}
+
+//==========================================================================
+//
+// Caches a lump's content and increases the reference counter
+//
+//==========================================================================
+
 void *FResourceLump::Lock()
 {
+	std::lock_guard<std::recursive_mutex> lock(GetMutex());
 	if (Cache != NULL)
 	{
 		if (RefCount > 0) RefCount++;
 	}
 	else if (LumpSize > 0)
 	{
-		FillCache();
+		if (FillCache() > 0 && Owner != nullptr) Owner->CopiedBytes += LumpSize;
 	}
 	return Cache;
 }
@@ -206,6 +219,7 @@ void *FResourceLump::Lock()
 
 int FResourceLump::Unlock()
 {
+	std::lock_guard<std::recursive_mutex> lock(GetMutex());
 	if (LumpSize > 0 && RefCount > 0)
 	{
 		if (--RefCount == 0)
@@ -577,7 +591,6 @@ FResourceLump *FResourceFile::FindLump(const char *name)
 
 FileReader *FUncompressedLump::GetReader()
 {
-	Owner->Reader.Seek(Position, FileReader::SeekSet);
 	return &Owner->Reader;
 }
 
@@ -599,9 +612,8 @@ int FUncompressedLump::FillCache()
 		return -1;
 	}
 
-	Owner->Reader.Seek(Position, FileReader::SeekSet);
 	Cache = new char[LumpSize];
-	Owner->Reader.Read(Cache, LumpSize);
+	Owner->Reader.ReadAt(Cache, LumpSize, Position);
 	RefCount = 1;
 	return 1;
 }
@@ -4,6 +4,8 @@
 #define __RESFILE_H
 
 #include <limits.h>
+#include <atomic>
+#include <mutex>
 
 #include "files.h"
 
@@ -89,7 +91,7 @@ struct FResourceLump
 	friend class FWadFile;	// this still needs direct access.
 
 	int				LumpSize;
-	int				RefCount;
+	std::atomic<int> RefCount;
 protected:
 	FString			FullName;
 public:
@@ -125,6 +127,10 @@ public:
 protected:
 	virtual int FillCache() { return -1; }
 
+	// Guards Cache, RefCount and lazily resolved lump data against concurrent access.
+	// The mutexes are shared between lumps to avoid bloating the lump objects.
+	std::recursive_mutex &GetMutex() const;
+
 };
 
 class FResourceFile
@@ -132,6 +138,7 @@ class FResourceFile
 public:
 	FileReader Reader;
 	FString FileName;
+	std::atomic<size_t> CopiedBytes{ 0 };	// lump data that had to be read into a separate buffer
 protected:
 	uint32_t NumLumps;
 	FString Hash;
@@ -373,6 +373,7 @@ enum EUpscaleFlags : int
 
 extern int upscalemask;
 void UpdateUpscaleMask();
+void FlushUpscaleCache();
 
 void calcShouldUpscale(FGameTexture* tex);
 inline int shouldUpscale(FGameTexture* tex, EUpscaleFlags UseType)
@@ -0,0 +1,375 @@
+/*
+** hqcache.cpp
+**
+** Persistent disk cache for upscaled textures
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 agent
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Every upscaled image is stored zlib-compressed in its own file in the
+** 'upscale' subdirectory of the cache path, named after the key the
+** upscaler computes from the source pixels and the scaler settings.
+** A small index keeps the size and last use of each file so that the
+** least recently used ones can be discarded once the size limit is reached.
+**
+*/
+
+#include <stdio.h>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <zlib.h>
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "cmdlib.h"
+#include "files.h"
+#include "i_specialpaths.h"
+#include "i_time.h"
+#include "printf.h"
+#include "textures.h"
+#include "tarray.h"
+#include "zstring.h"
+
+CVAR(Bool, gl_texture_hqresize_cache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CUSTOM_CVAR(Int, gl_texture_hqresize_cachesize, 512, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// in MB
+{
+	if (self < 16) self = 16;
+}
+
+static const char IndexMagic[4] = { 'R', 'Z', 'U', 'I' };
+static const char EntryMagic[4] = { 'R', 'Z', 'U', 'P' };
+static const uint32_t IndexVersion = 1;
+
+struct FUpscaleCacheEntry
+{
+	uint32_t size;		// on disk
+	uint32_t lastuse;
+};
+
+static TMap<FString, FUpscaleCacheEntry> CacheIndex;
+static std::mutex CacheMutex;
+static uint64_t CacheSize;
+static uint32_t UseCounter;
+static int StoresSinceFlush;
+static bool IndexLoaded;
+static bool IndexDirty;
+
+static std::atomic<unsigned> Hits, Misses, Stores, Evictions;
+static std::atomic<unsigned> TempCounter;
+static std::atomic<uint64_t> LoadTime, ScaleTime;	// in ns
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static FString CacheDir(bool create)
+{
+	FString path = M_GetCachePath(create);
+	path << "/upscale/";
+	if (create) CreatePath(path);
+	return path;
+}
+
+static FString EntryFileName(const FString& key, bool create)
+{
+	return CacheDir(create) + key + ".rzu";
+}
+
+//==========================================================================
+//
+// Must be called with the mutex held.
+//
+//==========================================================================
+
+static void LoadIndex()
+{
+	if (IndexLoaded) return;
+	IndexLoaded = true;
+
+	FileReader fr;
+	if (!fr.OpenFile(CacheDir(false) + "index.rzi")) return;
+
+	char magic[4];
+	if (fr.Read(magic, 4) != 4 || memcmp(magic, IndexMagic, 4) != 0 || fr.ReadUInt32() != IndexVersion) return;
+	UseCounter = fr.ReadUInt32();
+	uint32_t count = fr.ReadUInt32();
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		char hexdigest[33];
+		if (fr.Read(hexdigest, 32) != 32) break;
+		hexdigest[32] = 0;
+		FUpscaleCacheEntry entry;
+		entry.size = fr.ReadUInt32();
+		entry.lastuse = fr.ReadUInt32();
+		CacheIndex[hexdigest] = entry;
+		CacheSize += entry.size;
+	}
+}
+
+//==========================================================================
+//
+// Must be called with the mutex held.
+//
+//==========================================================================
+
+static void SaveIndex()
+{
+	if (!IndexDirty) return;
+	IndexDirty = false;
+	StoresSinceFlush = 0;
+
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(CacheDir(true) + "index.rzi"));
+	if (!fw) return;
+
+	uint32_t header[3] = { IndexVersion, UseCounter, CacheIndex.CountUsed() };
+	fw->Write(IndexMagic, 4);
+	fw->Write(header, sizeof(header));
+
+	TMap<FString, FUpscaleCacheEntry>::Iterator it(CacheIndex);
+	TMap<FString, FUpscaleCacheEntry>::Pair* pair;
+	while (it.NextPair(pair))
+	{
+		fw->Write(pair->Key.GetChars(), 32);
+		fw->Write(&pair->Value, sizeof(FUpscaleCacheEntry));
+	}
+}
+
+//==========================================================================
+//
+// Must be called with the mutex held.
+//
+//==========================================================================
+
+static void RemoveEntry(const FString& key)
+{
+	auto entry = CacheIndex.CheckKey(key);
+	if (entry == nullptr) return;
+	CacheSize -= entry->size;
+	remove(EntryFileName(key, false).GetChars());
+	CacheIndex.Remove(key);
+	IndexDirty = true;
+}
+
+//==========================================================================
+//
+// Discards the least recently used entries until the cache is
+// a bit below the size limit so that this does not happen on every store.
+//
+//==========================================================================
+
+static void EvictEntries()
+{
+	uint64_t limit = uint64_t(gl_texture_hqresize_cachesize) << 20;
+	if (CacheSize <= limit) return;
+
+	TArray<std::pair<uint32_t, FString>> order;
+	order.Grow(CacheIndex.CountUsed());
+	TMap<FString, FUpscaleCacheEntry>::Iterator it(CacheIndex);
+	TMap<FString, FUpscaleCacheEntry>::Pair* pair;
+	while (it.NextPair(pair))
+	{
+		order.Push(std::make_pair(pair->Value.lastuse, pair->Key));
+	}
+	std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	limit -= limit / 8;
+	for (unsigned i = 0; i < order.Size() && CacheSize > limit; i++)
+	{
+		RemoveEntry(order[i].second);
+		Evictions++;
+	}
+}
+
+//==========================================================================
+//
+// Replaces the texture's buffer with the cached image if one exists.
+// May be called from the precaching worker threads.
+//
+//==========================================================================
+
+bool UpscaleCacheLoad(const FString& key, FTextureBuffer& texbuffer, int width, int height)
+{
+	if (!gl_texture_hqresize_cache) return false;
+	uint64_t start = I_nsTime();
+	{
+		std::lock_guard<std::mutex> lock(CacheMutex);
+		LoadIndex();
+		auto entry = CacheIndex.CheckKey(key);
+		if (entry == nullptr)
+		{
+			Misses++;
+			return false;
+		}
+		entry->lastuse = ++UseCounter;
+		IndexDirty = true;
+	}
+
+	FileReader fr;
+	bool ok = fr.OpenFile(EntryFileName(key, false));
+	uint8_t* buffer = nullptr;
+	if (ok)
+	{
+		char magic[4];
+		ok = fr.Read(magic, 4) == 4 && memcmp(magic, EntryMagic, 4) == 0;
+		ok = ok && fr.ReadUInt32() == (uint32_t)width && fr.ReadUInt32() == (uint32_t)height;
+		uint32_t csize = ok ? fr.ReadUInt32() : 0;
+		ok = ok && csize > 0 && (long)csize <= fr.GetLength();
+		if (ok)
+		{
+			TArray<uint8_t> compressed(csize, true);
+			buffer = new uint8_t[width * height * 4];
+			uLongf size = width * height * 4;
+			ok = fr.Read(compressed.Data(), csize) == (long)csize &&
+				uncompress(buffer, &size, compressed.Data(), csize) == Z_OK && size == (uLongf)width * height * 4;
+		}
+	}
+	if (!ok)
+	{
+		// Damaged or deleted from outside. Forget about it and scale the image again.
+		delete[] buffer;
+		std::lock_guard<std::mutex> lock(CacheMutex);
+		RemoveEntry(key);
+		Misses++;
+		return false;
+	}
+
+	delete[] texbuffer.mBuffer;
+	texbuffer.mBuffer = buffer;
+	texbuffer.mWidth = width;
+	texbuffer.mHeight = height;
+	Hits++;
+	LoadTime += I_nsTime() - start;
+	return true;
+}
+
+//==========================================================================
+//
+// Adds a freshly upscaled image. 'scaletime' is what it took to create it
+// and only used for the statistics.
+// The file is written under a temporary name and renamed afterward, so
+// that threads storing the same image at once never write to the same
+// file and a reader never sees a partially written one.
+//
+//==========================================================================
+
+void UpscaleCacheStore(const FString& key, const FTextureBuffer& texbuffer, uint64_t scaletime)
+{
+	ScaleTime += scaletime;
+	if (!gl_texture_hqresize_cache) return;
+
+	uLong srcsize = texbuffer.mWidth * texbuffer.mHeight * 4;
+	uLongf csize = compressBound(srcsize);
+	TArray<uint8_t> compressed(csize, true);
+	if (compress2(compressed.Data(), &csize, texbuffer.mBuffer, srcsize, Z_BEST_SPEED) != Z_OK) return;
+
+	FString filename = EntryFileName(key, true);
+	FString tempname;
+	tempname.Format("%s.%u.tmp", filename.GetChars(), TempCounter++);
+	{
+		std::unique_ptr<FileWriter> fw(FileWriter::Open(tempname));
+		if (!fw) return;
+		uint32_t header[3] = { (uint32_t)texbuffer.mWidth, (uint32_t)texbuffer.mHeight, (uint32_t)csize };
+		fw->Write(EntryMagic, 4);
+		fw->Write(header, sizeof(header));
+		if (fw->Write(compressed.Data(), csize) != csize)
+		{
+			fw.reset();
+			remove(tempname.GetChars());
+			return;
+		}
+	}
+	// Windows does not replace existing files. Anything stored under the same key has the same content, so it can go.
+	if (rename(tempname.GetChars(), filename.GetChars()) != 0)
+	{
+		remove(filename.GetChars());
+		if (rename(tempname.GetChars(), filename.GetChars()) != 0)
+		{
+			remove(tempname.GetChars());
+			return;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(CacheMutex);
+	LoadIndex();
+	auto entry = CacheIndex.CheckKey(key);
+	if (entry) CacheSize -= entry->size;
+	FUpscaleCacheEntry& newentry = CacheIndex[key];
+	newentry.size = uint32_t(4 + 3 * sizeof(uint32_t) + csize);
+	newentry.lastuse = ++UseCounter;
+	CacheSize += newentry.size;
+	IndexDirty = true;
+	Stores++;
+	EvictEntries();
+	if (++StoresSinceFlush >= 64) SaveIndex();
+}
+
+//==========================================================================
+//
+// Writes out the index. Called after precaching and at shutdown.
+//
+//==========================================================================
+
+void FlushUpscaleCache()
+{
+	std::lock_guard<std::mutex> lock(CacheMutex);
+	SaveIndex();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(upscalecache)
+{
+	std::lock_guard<std::mutex> lock(CacheMutex);
+	LoadIndex();
+
+	if (argv.argc() > 1 && !stricmp(argv[1], "clear"))
+	{
+		TArray<FString> keys;
+		TMap<FString, FUpscaleCacheEntry>::Iterator it(CacheIndex);
+		TMap<FString, FUpscaleCacheEntry>::Pair* pair;
+		while (it.NextPair(pair)) keys.Push(pair->Key);
+		for (auto& key : keys) RemoveEntry(key);
+		SaveIndex();
+		Printf("Upscale cache cleared, %u entries deleted\n", keys.Size());
+		return;
+	}
+
+	unsigned hits = Hits, misses = Misses;
+	Printf("Upscale cache: %s, %s\n", gl_texture_hqresize_cache ? "enabled" : "disabled", CacheDir(false).GetChars());
+	Printf("%u entries, %.1f of %d MB\n", CacheIndex.CountUsed(), CacheSize / 1048576., *gl_texture_hqresize_cachesize);
+	Printf("%u hits, %u misses, %u stores, %u evictions\n", hits, misses, (unsigned)Stores, (unsigned)Evictions);
+	if (hits > 0) Printf("%.3f ms per cache hit\n", LoadTime / 1e6 / hits);
+	if (misses > 0) Printf("%.3f ms per upscale\n", ScaleTime / 1e6 / misses);
+}
@@ -45,10 +45,16 @@
 #include "textures.h"
 #include "texturemanager.h"
 #include "printf.h"
+#include "i_time.h"
+#include "md5.h"
 
 int upscalemask;
 
+bool UpscaleCacheLoad(const FString& key, FTextureBuffer& texbuffer, int width, int height);
+void UpscaleCacheStore(const FString& key, const FTextureBuffer& texbuffer, uint64_t scaletime);
+
 EXTERN_CVAR(Int, gl_texture_hqresizemult)
+EXTERN_CVAR(Bool, gl_texture_hqresize_cache)
 CUSTOM_CVAR(Int, gl_texture_hqresizemode, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_NOINITCALL)
 {
 	if (self < 0 || self > 6)
@@ -296,13 +302,8 @@ static unsigned char *hqNxAsmHelper( void (*hqNxFunction) ( int*, unsigned char*
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		HQnX_asm::InitLUTs();
-		initdone = true;
-	}
+	static const bool initdone = (HQnX_asm::InitLUTs(), true);
+	(void)initdone;
 
 	HQnX_asm::CImage cImageIn;
 	cImageIn.SetImage(inputBuffer, inWidth, inHeight, 32);
@@ -323,13 +324,9 @@ static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( unsigned*,
 							  int &outWidth,
 							  int &outHeight )
 {
-	static int initdone = false;
-
-	if (!initdone)
-	{
-		hqxInit();
-		initdone = true;
-	}
+	// This can be called from the precacher's worker threads so let the compiler take care of synchronizing the init.
+	static const bool initdone = (hqxInit(), true);
+	(void)initdone;
 	outWidth = N * inWidth;
 	outHeight = N *inHeight;
 
@@ -412,6 +409,90 @@ static void xbrzOldScale(size_t factor, const uint32_t* src, uint32_t* trg, int
 }
 
 
+//===========================================================================
+// 
+// Runs the selected scaler on the buffer. Returns false if the
+// combination of scaler and factor is not supported.
+//
+//===========================================================================
+
+static bool UpscaleBuffer(FTextureBuffer& texbuffer, int type, int mult)
+{
+	int inWidth = texbuffer.mWidth;
+	int inHeight = texbuffer.mHeight;
+
+	if (type == 1)
+	{
+		if (mult == 2)
+			texbuffer.mBuffer = scaleNxHelper(&scale2x, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else if (mult == 3)
+			texbuffer.mBuffer = scaleNxHelper(&scale3x, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else if (mult == 4)
+			texbuffer.mBuffer = scaleNxHelper(&scale4x, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else return false;
+	}
+	else if (type == 2)
+	{
+		if (mult == 2)
+			texbuffer.mBuffer = hqNxHelper(&hq2x_32, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else if (mult == 3)
+			texbuffer.mBuffer = hqNxHelper(&hq3x_32, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else if (mult == 4)
+			texbuffer.mBuffer = hqNxHelper(&hq4x_32, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else return false;
+	}
+#ifdef HAVE_MMX
+	else if (type == 3)
+	{
+		if (mult == 2)
+			texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq2x_32, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else if (mult == 3)
+			texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq3x_32, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else if (mult == 4)
+			texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq4x_32, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		else return false;
+	}
+#endif
+	else if (type == 4)
+		texbuffer.mBuffer = xbrzHelper(xbrz::scale, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+	else if (type == 5)
+		texbuffer.mBuffer = xbrzHelper(xbrzOldScale, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+	else if (type == 6)
+		texbuffer.mBuffer = normalNx(mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+	else
+		return false;
+	return true;
+}
+
+//===========================================================================
+// 
+// The cache key covers everything that affects the scaler's output.
+// Translations do not need to be considered because the source pixels
+// already have them applied.
+//
+//===========================================================================
+
+static FString UpscaleCacheKey(const FTextureBuffer& texbuffer, int type, int mult, bool hasAlpha)
+{
+	int32_t params[5] = { texbuffer.mWidth, texbuffer.mHeight, type, mult, hasAlpha };
+	MD5Context md5;
+	md5.Update((const uint8_t*)params, sizeof(params));
+	if (type == 4 || type == 5)
+	{
+		float xbrzparams[5] = { xbrz_luminanceweight, xbrz_equalcolortolerance, xbrz_centerdirectionbias, xbrz_dominantdirectionthreshold, xbrz_steepdirectionthreshold };
+		int32_t format = xbrz_colorformat;
+		md5.Update((const uint8_t*)xbrzparams, sizeof(xbrzparams));
+		md5.Update((const uint8_t*)&format, sizeof(format));
+	}
+	md5.Update(texbuffer.mBuffer, texbuffer.mWidth * texbuffer.mHeight * 4);
+
+	uint8_t digest[16];
+	md5.Final(digest);
+	FString key;
+	for (int i = 0; i < 16; i++) key.AppendFormat("%02x", digest[i]);
+	return key;
+}
+
 //===========================================================================
 // 
 // [BB] Upsamples the texture in texbuffer.mBuffer, frees texbuffer.mBuffer and returns
@@ -440,48 +521,20 @@ void FTexture::CreateUpsampledTextureBuffer(FTextureBuffer &texbuffer, bool hasA
 	if (mult < 2 || mult > 6 || type < 1 || type > 6) return;
 	if (type < 4 && mult > 4) mult = 4;
 
-	if (!checkonly)
+	if (!checkonly && !gl_texture_hqresize_cache)
 	{
-		if (type == 1)
-		{
-			if (mult == 2)
-				texbuffer.mBuffer = scaleNxHelper(&scale2x, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = scaleNxHelper(&scale3x, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = scaleNxHelper(&scale4x, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
-		}
-		else if (type == 2)
-		{
-			if (mult == 2)
-				texbuffer.mBuffer = hqNxHelper(&hq2x_32, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = hqNxHelper(&hq3x_32, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = hqNxHelper(&hq4x_32, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
-		}
-#ifdef HAVE_MMX
-		else if (type == 3)
+		// no need to hash the whole image if the cache is off.
+		if (!UpscaleBuffer(texbuffer, type, mult)) return;
+	}
+	else if (!checkonly)
+	{
+		FString cachekey = UpscaleCacheKey(texbuffer, type, mult, hasAlpha);
+		if (!UpscaleCacheLoad(cachekey, texbuffer, inWidth * mult, inHeight * mult))
 		{
-			if (mult == 2)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq2x_32, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq3x_32, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq4x_32, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
+			uint64_t start = I_nsTime();
+			if (!UpscaleBuffer(texbuffer, type, mult)) return;
+			UpscaleCacheStore(cachekey, texbuffer, I_nsTime() - start);
 		}
-#endif
-		else if (type == 4)
-			texbuffer.mBuffer = xbrzHelper(xbrz::scale, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else if (type == 5)
-			texbuffer.mBuffer = xbrzHelper(xbrzOldScale, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else if (type == 6)
-			texbuffer.mBuffer = normalNx(mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else
-			return;
 	}
 	else
 	{
@@ -342,71 +342,142 @@ FTextureBuffer FTexture::CreateTexBuffer(int translation, int flags)
 	}
 	else
 	{
-		unsigned char* buffer = nullptr;
-		int W, H;
-		int isTransparent = -1;
 		bool checkonly = !!(flags & CTF_CheckOnly);
 
-		int exx = !!(flags & CTF_Expand);
-
-		W = GetWidth() + 2 * exx;
-		H = GetHeight() + 2 * exx;
-
-		if (!checkonly)
+		// Only do postprocessing for image-backed textures. (i.e. not for the burn texture which can also pass through here.)
+		if (GetImage() && flags & CTF_ProcessData)
 		{
-			buffer = new unsigned char[W * (H + 1) * 4];
-			memset(buffer, 0, W * (H + 1) * 4);
-
-			auto remap = translation <= 0 || IsLuminosityTranslation(translation) ? nullptr : GPalette.TranslationToTable(translation);
-			if (remap && remap->Inactive) remap = nullptr;
-			if (remap) translation = remap->Index;
-			FBitmap bmp(buffer, W * 4, W, H);
-
-			int trans;
-			auto Pixels = GetBgraBitmap(remap ? remap->Palette : nullptr, &trans);
-			bmp.Blit(exx, exx, Pixels);
-			if (IsLuminosityTranslation(translation))
+			if (checkonly || !TakePrecachedBuffer(translation, flags, result))
 			{
-				V_ApplyLuminosityTranslation(translation, buffer, W * H);
+				int isTransparent = CreateBaseTexBuffer(result, translation, flags);
+				if (flags & CTF_Upscale) CreateUpsampledTextureBuffer(result, !!isTransparent, checkonly);
 			}
+			if (!checkonly) ProcessData(result.mBuffer, result.mWidth, result.mHeight, false);
+		}
+		else CreateBaseTexBuffer(result, translation, flags);
+	}
+	return result;
 
-			if (remap == nullptr)
-			{
-				CheckTrans(buffer, W * H, trans);
-				isTransparent = bTranslucent;
-			}
-			else
-			{
-				isTransparent = 0;
-				// A translated image is not conclusive for setting the texture's transparency info.
-			}
+}
+
+//===========================================================================
+// 
+// Creates the texture's image with the translation applied but without
+// any postprocessing. Returns whether the image has transparent parts.
+//
+//===========================================================================
+
+int FTexture::CreateBaseTexBuffer(FTextureBuffer& result, int translation, int flags)
+{
+	unsigned char* buffer = nullptr;
+	int W, H;
+	int isTransparent = -1;
+	bool checkonly = !!(flags & CTF_CheckOnly);
+
+	int exx = !!(flags & CTF_Expand);
+
+	W = GetWidth() + 2 * exx;
+	H = GetHeight() + 2 * exx;
+
+	if (!checkonly)
+	{
+		buffer = new unsigned char[W * (H + 1) * 4];
+		memset(buffer, 0, W * (H + 1) * 4);
+
+		auto remap = translation <= 0 || IsLuminosityTranslation(translation) ? nullptr : GPalette.TranslationToTable(translation);
+		if (remap && remap->Inactive) remap = nullptr;
+		if (remap) translation = remap->Index;
+		FBitmap bmp(buffer, W * 4, W, H);
+
+		int trans;
+		auto Pixels = GetBgraBitmap(remap ? remap->Palette : nullptr, &trans);
+		bmp.Blit(exx, exx, Pixels);
+		if (IsLuminosityTranslation(translation))
+		{
+			V_ApplyLuminosityTranslation(translation, buffer, W * H);
 		}
 
-		if (GetImage())
+		if (remap == nullptr)
 		{
-			FContentIdBuilder builder;
-			builder.id = 0;
-			builder.imageID = GetImage()->GetId();
-			builder.translation = MAX(0, translation);
-			builder.expand = exx;
-			result.mContentId = builder.id;
+			CheckTrans(buffer, W * H, trans);
+			isTransparent = bTranslucent;
 		}
-		else result.mContentId = 0;	// for non-image backed textures this has no meaning so leave it at 0.
+		else
+		{
+			isTransparent = 0;
+			// A translated image is not conclusive for setting the texture's transparency info.
+		}
+	}
 
-		result.mBuffer = buffer;
-		result.mWidth = W;
-		result.mHeight = H;
+	if (GetImage())
+	{
+		FContentIdBuilder builder;
+		builder.id = 0;
+		builder.imageID = GetImage()->GetId();
+		builder.translation = MAX(0, translation);
+		builder.expand = exx;
+		result.mContentId = builder.id;
+	}
+	else result.mContentId = 0;	// for non-image backed textures this has no meaning so leave it at 0.
 
-		// Only do postprocessing for image-backed textures. (i.e. not for the burn texture which can also pass through here.)
-		if (GetImage() && flags & CTF_ProcessData)
-		{
-			if (flags & CTF_Upscale) CreateUpsampledTextureBuffer(result, !!isTransparent, checkonly);
+	result.mBuffer = buffer;
+	result.mWidth = W;
+	result.mHeight = H;
+	return isTransparent;
+}
 
-			if (!checkonly) ProcessData(result.mBuffer, result.mWidth, result.mHeight, false);
+//===========================================================================
+// 
+// Precaching support.
+//
+// The upscaling step of CreateTexBuffer is by far its most expensive part
+// and is independent of any shared state, so the precacher can run it on
+// worker threads ahead of time. PrepareTexBuffer does everything before it
+// and must be called on the main thread. The result of the upscaling is
+// stored in the texture and picked up by the next CreateTexBuffer call
+// with the same parameters.
+//
+//===========================================================================
+
+bool FTexture::PrepareTexBuffer(FTextureBuffer& result, int translation, int flags, bool* hasAlpha)
+{
+	if ((flags & (CTF_Indexed | CTF_CheckOnly)) || !(flags & CTF_ProcessData) || !(flags & CTF_Upscale) || !GetImage()) return false;
+	for (auto& pc : PrecachedBuffers)
+	{
+		if (pc.translation == translation && pc.flags == flags) return false;
+	}
+	*hasAlpha = !!CreateBaseTexBuffer(result, translation, flags);
+	return true;
+}
+
+void FTexture::StorePrecachedBuffer(int translation, int flags, FTextureBuffer&& buffer)
+{
+	PrecachedBuffers.Push({ translation, flags, buffer.mBuffer, buffer.mWidth, buffer.mHeight, buffer.mContentId });
+	buffer.mBuffer = nullptr;
+}
+
+bool FTexture::TakePrecachedBuffer(int translation, int flags, FTextureBuffer& result)
+{
+	for (unsigned i = 0; i < PrecachedBuffers.Size(); i++)
+	{
+		auto& pc = PrecachedBuffers[i];
+		if (pc.translation == translation && pc.flags == flags)
+		{
+			result.mBuffer = pc.buffer;
+			result.mWidth = pc.width;
+			result.mHeight = pc.height;
+			result.mContentId = pc.contentId;
+			PrecachedBuffers.Delete(i);
+			return true;
 		}
 	}
-	return result;
+	return false;
+}
 
+void FTexture::ClearPrecachedBuffers()
+{
+	for (auto& pc : PrecachedBuffers) delete[] pc.buffer;
+	PrecachedBuffers.Reset();
 }
 
 //===========================================================================
@@ -220,6 +220,16 @@ protected:
 	int8_t bTranslucent = -1;
 	int8_t areacount = 0;			// this is capped at 4 sections.
 
+	struct FPrecachedBuffer
+	{
+		int translation;
+		int flags;
+		uint8_t* buffer;
+		int width, height;
+		uint64_t contentId;
+	};
+	TArray<FPrecachedBuffer> PrecachedBuffers;	// upscaled ahead of time by the precacher.
+
 
 public:
 
@@ -285,8 +295,15 @@ public:
 
 	FTexture (int lumpnum = -1);
 
+protected:
+	int CreateBaseTexBuffer(FTextureBuffer& result, int translation, int flags);
+	bool TakePrecachedBuffer(int translation, int flags, FTextureBuffer& result);
+
 public:
 	FTextureBuffer CreateTexBuffer(int translation, int flags = 0);
+	bool PrepareTexBuffer(FTextureBuffer& result, int translation, int flags, bool* hasAlpha);
+	void StorePrecachedBuffer(int translation, int flags, FTextureBuffer&& buffer);
+	void ClearPrecachedBuffers();
 	virtual bool DetermineTranslucency();
 	bool GetTranslucency()
 	{
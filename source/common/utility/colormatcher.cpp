@@ -0,0 +1,208 @@
+/*
+** colormatcher.cpp
+**
+** Accelerated closest color search
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 agent
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <limits.h>
+#include "colormatcher.h"
+
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
+enum
+{
+	CELLBITS = 4,
+	CELLSIZE = 1 << CELLBITS,
+	CELLSPERAXIS = 256 / CELLSIZE,
+	SENTINEL = 0x2000,	// for padding the blocks. Far enough away to never be picked but small enough to not overflow.
+};
+
+//==========================================================================
+//
+// Distance of a palette component to the nearest and farthest point
+// of a cell's range along one axis.
+//
+//==========================================================================
+
+static inline int MinAxisDist(int p, int lo, int hi)
+{
+	return p < lo ? lo - p : p > hi ? p - hi : 0;
+}
+
+static inline int MaxAxisDist(int p, int lo, int hi)
+{
+	return std::max(abs(p - lo), abs(p - hi));
+}
+
+//==========================================================================
+//
+// A palette entry can only be the closest color for some point in a cell
+// if its minimum distance to the cell is not larger than the smallest
+// maximum distance of any entry. These are collected in BestColor's
+// search order so that ties are resolved the same way.
+//
+//==========================================================================
+
+void FColorMatcher::Build()
+{
+	const int first = startindex, num = 255;
+	int mindist[256], maxdist[256];
+
+	Blocks.Clear();
+	Cells.Resize(CELLSPERAXIS * CELLSPERAXIS * CELLSPERAXIS);
+
+	for (int cr = 0; cr < CELLSPERAXIS; cr++)
+	for (int cg = 0; cg < CELLSPERAXIS; cg++)
+	for (int cb = 0; cb < CELLSPERAXIS; cb++)
+	{
+		int rlo = cr * CELLSIZE, glo = cg * CELLSIZE, blo = cb * CELLSIZE;
+		int rhi = rlo + CELLSIZE - 1, ghi = glo + CELLSIZE - 1, bhi = blo + CELLSIZE - 1;
+		int limit = INT_MAX;
+
+		for (int color = first; color < num; color++)
+		{
+			auto& pe = Pal[indexmap ? indexmap[color] : color];
+			int x = MinAxisDist(pe.r, rlo, rhi), y = MinAxisDist(pe.g, glo, ghi), z = MinAxisDist(pe.b, blo, bhi);
+			mindist[color] = x*x + y*y + z*z;
+			x = MaxAxisDist(pe.r, rlo, rhi), y = MaxAxisDist(pe.g, glo, ghi), z = MaxAxisDist(pe.b, blo, bhi);
+			maxdist[color] = x*x + y*y + z*z;
+			limit = std::min(limit, maxdist[color]);
+		}
+
+		auto& cell = Cells[(cr * CELLSPERAXIS + cg) * CELLSPERAXIS + cb];
+		cell.start = Blocks.Size();
+		int slot = 4;
+		for (int color = first; color < num; color++)
+		{
+			if (mindist[color] > limit) continue;
+			if (slot == 4)
+			{
+				CandidateBlock block;
+				for (int i = 0; i < 4; i++)
+				{
+					block.rg[i * 2] = block.rg[i * 2 + 1] = block.b[i * 2] = SENTINEL;
+					block.b[i * 2 + 1] = 0;
+					block.index[i] = 0;
+				}
+				Blocks.Push(block);
+				slot = 0;
+			}
+			int co = indexmap ? indexmap[color] : color;
+			auto& block = Blocks.Last();
+			block.rg[slot * 2] = Pal[co].r;
+			block.rg[slot * 2 + 1] = Pal[co].g;
+			block.b[slot * 2] = Pal[co].b;
+			block.index[slot] = co;
+			slot++;
+		}
+		cell.count = Blocks.Size() - cell.start;
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+uint8_t FColorMatcher::PickCandidate(int r, int g, int b) const
+{
+	auto& cell = Cells[(((r >> CELLBITS) * CELLSPERAXIS) + (g >> CELLBITS)) * CELLSPERAXIS + (b >> CELLBITS)];
+	const CandidateBlock* block = &Blocks[cell.start];
+	int bestdist = INT_MAX;
+	int bestcolor = 0;
+
+#ifndef NO_SSE
+	__m128i prg = _mm_set1_epi32(r | (g << 16));
+	__m128i pb = _mm_set1_epi32(b);
+	alignas(16) int dist[4];
+#endif
+
+	for (unsigned i = 0; i < cell.count; i++, block++)
+	{
+#ifndef NO_SSE
+		__m128i drg = _mm_sub_epi16(prg, _mm_loadu_si128((const __m128i*)block->rg));
+		__m128i db = _mm_sub_epi16(pb, _mm_loadu_si128((const __m128i*)block->b));
+		_mm_store_si128((__m128i*)dist, _mm_add_epi32(_mm_madd_epi16(drg, drg), _mm_madd_epi16(db, db)));
+#endif
+		for (int j = 0; j < 4; j++)
+		{
+#ifndef NO_SSE
+			int d = dist[j];
+#else
+			int x = r - block->rg[j * 2];
+			int y = g - block->rg[j * 2 + 1];
+			int z = b - block->b[j * 2];
+			int d = x*x + y*y + z*z;
+#endif
+			if (d < bestdist)
+			{
+				bestcolor = block->index[j];
+				if (d == 0)
+					return bestcolor;
+				bestdist = d;
+			}
+		}
+	}
+	return bestcolor;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FColorMatcher::PickBatch(const PalEntry* colors, uint8_t* out, int count) const
+{
+	if (Pal == nullptr)
+	{
+		memset(out, 1, count);
+		return;
+	}
+
+	// Images tend to have runs of the same color so remember the last one.
+	uint32_t lastcolor = 0xffffffff;
+	uint8_t lastresult = 0;
+	for (int i = 0; i < count; i++)
+	{
+		uint32_t c = colors[i].d & 0xffffff;
+		if (c != lastcolor)
+		{
+			lastcolor = c;
+			lastresult = PickCandidate(colors[i].r, colors[i].g, colors[i].b);
+		}
+		out[i] = lastresult;
+	}
+}
@@ -35,12 +35,19 @@
 ** revisiting the problem. I never did, so now it's relegated to the mists
 ** of SVN history, and this is just a thin wrapper around BestColor().
 **
+** It now splits the RGB cube into 16x16x16 cells and stores for each cell
+** the palette entries that can possibly be the closest one for any color
+** inside it, in the same order BestColor checks them. Picking only needs
+** to check these few candidates and the result is always identical to
+** BestColor's.
+**
 */
 
 #ifndef __COLORMATCHER_H__
 #define __COLORMATCHER_H__
 
 #include "palutil.h"
+#include "tarray.h"
 
 int BestColor (const uint32_t *pal_in, int r, int g, int b, int first, int num, const uint8_t* indexmap);
 
@@ -48,26 +55,52 @@ class FColorMatcher
 {
 public:
 
-	void SetPalette(PalEntry* palette) { Pal = palette; }
-	void SetPalette (const uint32_t *palette) { Pal = reinterpret_cast<const PalEntry*>(palette); }
-	void SetIndexMap(const uint8_t* index) { indexmap = index; startindex = index ? 0 : 1; }
-	uint8_t Pick (int r, int g, int b)
+	// The lookup data is built right here, so picking never changes anything and is safe
+	// from multiple threads. Whoever changes the palette's contents must call SetPalette again.
+	void SetPalette(PalEntry* palette) { Pal = palette; Build(); }
+	void SetPalette (const uint32_t *palette) { Pal = reinterpret_cast<const PalEntry*>(palette); Build(); }
+	void SetIndexMap(const uint8_t* index) { indexmap = index; startindex = index ? 0 : 1; if (Pal) Build(); }
+	uint8_t Pick (int r, int g, int b) const
 	{
 		if (Pal == nullptr)
 			return 1;
 
-		return (uint8_t)BestColor ((uint32_t *)Pal, r, g, b, startindex, 255, indexmap);
+		if ((unsigned)(r | g | b) > 255)
+			return (uint8_t)BestColor ((uint32_t *)Pal, r, g, b, startindex, 255, indexmap);
+
+		return PickCandidate(r, g, b);
 	}
 	
-	uint8_t Pick (PalEntry pe)
+	uint8_t Pick (PalEntry pe) const
 	{
 		return Pick(pe.r, pe.g, pe.b);
 	}
 
+	// Converts a whole row of colors. Alpha is ignored.
+	void PickBatch(const PalEntry* colors, uint8_t* out, int count) const;
+
 private:
+	struct CandidateBlock
+	{
+		int16_t rg[8];		// red and green of 4 candidates, interleaved
+		int16_t b[8];		// blue of 4 candidates, with a 0 after each
+		uint8_t index[4];
+	};
+
+	struct Cell
+	{
+		unsigned start;
+		unsigned count;		// in blocks
+	};
+
+	void Build();
+	uint8_t PickCandidate(int r, int g, int b) const;
+
 	const PalEntry *Pal = nullptr;
 	const uint8_t* indexmap = nullptr;
 	int startindex = 1;
+	TArray<CandidateBlock> Blocks;
+	TArray<Cell> Cells;
 };
 
 extern FColorMatcher ColorMatcher;
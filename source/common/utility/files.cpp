@@ -33,11 +33,40 @@
 **
 */
 
+#include <limits.h>
+#include <mutex>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "files.h"
 #include "templates.h"	// just for 'clamp'
 #include "zstring.h"
 
 
+//==========================================================================
+//
+// FileReaderInterface
+//
+// Generic positional read for readers that can only seek.
+//
+//==========================================================================
+
+long FileReaderInterface::ReadAt(void *buffer, long len, long pos)
+{
+	long oldpos = Tell();
+	long result = Seek(pos, SEEK_SET) == 0 ? Read(buffer, len) : 0;
+	Seek(oldpos, SEEK_SET);
+	return result;
+}
+
 FILE *myfopen(const char *filename, const char *flags)
 {
 #ifndef _WIN32
@@ -63,6 +92,9 @@ class StdFileReader : public FileReaderInterface
 	FILE *File = nullptr;
 	long StartPos = 0;
 	long FilePos = 0;
+#ifdef _WIN32
+	std::mutex ReadMutex;
+#endif
 
 public:
 	StdFileReader()
@@ -131,6 +163,31 @@ public:
 		return len;
 	}
 
+	long ReadAt(void *buffer, long len, long pos) override
+	{
+		assert(len >= 0);
+		if (pos < 0 || pos >= Length || len <= 0) return 0;
+		if (pos + len > Length) len = Length - pos;
+#ifndef _WIN32
+		// pread does not touch the stdio buffer or the file position.
+		long total = 0;
+		while (total < len)
+		{
+			auto got = pread(fileno(File), (char*)buffer + total, len - total, StartPos + pos + total);
+			if (got <= 0) break;
+			total += (long)got;
+		}
+		return total;
+#else
+		// Windows has no positional read on stdio files so reposition the stream temporarily.
+		std::lock_guard<std::mutex> lock(ReadMutex);
+		if (fseek(File, StartPos + pos, SEEK_SET) != 0) return 0;
+		len = (long)fread(buffer, 1, len, File);
+		fseek(File, FilePos, SEEK_SET);
+		return len;
+#endif
+	}
+
 	char *Gets(char *strbuf, int len) override
 	{
 		if (len <= 0 || FilePos >= StartPos + Length) return NULL;
@@ -180,7 +237,6 @@ public:
 		FilePos = start;
 		StartPos = start;
 		Length = length;
-		Seek(0, SEEK_SET);
 	}
 
 	virtual long Tell() const override
@@ -188,6 +244,7 @@ public:
 		return FilePos - StartPos;
 	}
 
+	// All access to the parent is positional so that multiple redirects to the same parent can be used concurrently.
 	virtual long Seek(long offset, int origin) override
 	{
 		switch (origin)
@@ -201,16 +258,12 @@ public:
 			break;
 
 		case SEEK_CUR:
-			offset += (long)mReader->Tell();
+			offset += FilePos;
 			break;
 		}
 		if (offset < StartPos || offset > StartPos + Length) return -1;	// out of scope
-		if (mReader->Seek(offset, FileReader::SeekSet) == 0)
-		{
-			FilePos = offset;
-			return 0;
-		}
-		return -1;
+		FilePos = offset;
+		return 0;
 	}
 
 	virtual long Read(void *buffer, long len) override
@@ -221,25 +274,30 @@ public:
 		{
 			len = Length - FilePos + StartPos;
 		}
-		len = (long)mReader->Read(buffer, len);
+		len = (long)mReader->ReadAt(buffer, len, FilePos);
 		FilePos += len;
 		return len;
 	}
 
+	virtual long ReadAt(void *buffer, long len, long pos) override
+	{
+		if (pos < 0 || pos >= Length || len <= 0) return 0;
+		if (pos + len > Length) len = Length - pos;
+		return (long)mReader->ReadAt(buffer, len, StartPos + pos);
+	}
+
 	virtual char *Gets(char *strbuf, int len) override
 	{
 		if (len <= 0 || FilePos >= StartPos + Length) return NULL;
-		char *p = mReader->Gets(strbuf, len);
-		if (p != NULL)
-		{
-			int old = FilePos;
-			FilePos = (long)mReader->Tell();
-			if (FilePos - StartPos > Length)
-			{
-				strbuf[Length - old + StartPos] = 0;
-			}
-		}
-		return p;
+		long avail = std::min<long>(len - 1, StartPos + Length - FilePos);
+		avail = (long)mReader->ReadAt(strbuf, avail, FilePos);
+		if (avail <= 0) return NULL;
+
+		long i = 0;
+		while (i < avail && strbuf[i++] != '\n') {}
+		strbuf[i] = 0;
+		FilePos += i;
+		return strbuf;
 	}
 
 };
@@ -284,6 +342,14 @@ long MemoryReader::Read(void *buffer, long len)
 	return len;
 }
 
+long MemoryReader::ReadAt(void *buffer, long len, long pos)
+{
+	if (pos < 0 || pos >= Length || len <= 0) return 0;
+	if (len > Length - pos) len = Length - pos;
+	memcpy(buffer, bufptr + pos, len);
+	return len;
+}
+
 char *MemoryReader::Gets(char *strbuf, int len)
 {
 	if (len>Length - FilePos) len = Length - FilePos;
@@ -347,6 +413,86 @@ public:
 	}
 };
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// maps an entire file into memory so that uncompressed content can be
+// accessed in place. The mapping is copy-on-write because some lump types
+// get decrypted inside their cache.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+#ifdef _WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMap = nullptr;
+#endif
+
+public:
+	~MappedFileReader()
+	{
+#ifdef _WIN32
+		if (bufptr) UnmapViewOfFile(bufptr);
+		if (hMap) CloseHandle(hMap);
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+#else
+		if (bufptr) munmap((void*)bufptr, Length);
+#endif
+	}
+
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		auto widename = WideString(filename);
+		hFile = CreateFileW(widename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart <= 0 || size.QuadPart > LONG_MAX) return false;
+		hMap = CreateFileMappingW(hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (hMap == nullptr) return false;
+		bufptr = (const char*)MapViewOfFile(hMap, FILE_MAP_COPY, 0, 0, 0);
+		if (bufptr == nullptr) return false;
+		Length = (long)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 || info.st_size > LONG_MAX)
+		{
+			close(fd);
+			return false;
+		}
+		void *map = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);	// the mapping keeps the file alive.
+		if (map == MAP_FAILED) return false;
+		bufptr = (const char*)map;
+		Length = (long)info.st_size;
+#endif
+		FilePos = 0;
+		return true;
+	}
+
+	long ResidentSize() const override
+	{
+#if defined(_WIN32)
+		return -1;
+#else
+		long pagesize = sysconf(_SC_PAGESIZE);
+		TArray<unsigned char> pages((Length + pagesize - 1) / pagesize, true);
+#ifdef __linux__
+		if (mincore((void*)bufptr, Length, pages.Data()) != 0) return -1;
+#else
+		if (mincore((void*)bufptr, Length, (char*)pages.Data()) != 0) return -1;
+#endif
+		long resident = 0;
+		for (auto p : pages) if (p & 1) resident += pagesize;
+		return std::min(resident, Length);
+#endif
+	}
+};
+
 
 
 //==========================================================================
@@ -370,6 +516,19 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenFileMapped(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return false;
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
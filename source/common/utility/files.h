@@ -69,8 +69,12 @@ public:
 	virtual long Tell () const = 0;
 	virtual long Seek (long offset, int origin) = 0;
 	virtual long Read (void *buffer, long len) = 0;
+	// Reads from the given position without moving the read position. This is safe to
+	// call from multiple threads for file and memory readers. Other readers emulate it.
+	virtual long ReadAt (void *buffer, long len, long pos);
 	virtual char *Gets(char *strbuf, int len) = 0;
 	virtual const char *GetBuffer() const { return nullptr; }
+	virtual long ResidentSize() const { return GetBuffer() ? Length : 0; }	// -1 if unknown
 	long GetLength () const { return Length; }
 };
 
@@ -94,6 +98,7 @@ public:
 	long Tell() const override;
 	long Seek(long offset, int origin) override;
 	long Read(void *buffer, long len) override;
+	long ReadAt(void *buffer, long len, long pos) override;
 	char *Gets(char *strbuf, int len) override;
 	virtual const char *GetBuffer() const override { return bufptr; }
 };
@@ -168,6 +173,7 @@ public:
 	}
 
 	bool OpenFile(const char *filename, Size start = 0, Size length = -1);
+	bool OpenFileMapped(const char *filename);	// maps the entire file into memory, if possible
 	bool OpenFilePart(FileReader &parent, Size start, Size length);
 	bool OpenMemory(const void *mem, Size length);	// read directly from the buffer
 	bool OpenMemoryArray(const void *mem, Size length);	// read from a copy of the buffer.
@@ -189,6 +195,11 @@ public:
 		return mReader->Read(buffer, (long)len);
 	}
 
+	Size ReadAt(void *buffer, Size len, Size pos)
+	{
+		return mReader->ReadAt(buffer, (long)len, (long)pos);
+	}
+
 	TArray<uint8_t> Read(size_t len)
 	{
 		TArray<uint8_t> buffer((int)len, true);
@@ -224,6 +235,11 @@ public:
 		return mReader->GetBuffer();
 	}
 
+	Size GetResidentSize() const
+	{
+		return mReader->ResidentSize();
+	}
+
 	Size GetLength() const
 	{
 		return mReader->GetLength();
@@ -47,7 +47,7 @@ FNullStringData FString::NullString =
 {
 	0,			// Length of string
 	2,			// Size of character buffer
-	2,			// RefCount; it must never be modified, so keep it above 1 user at all times
+	2,			// RefCount; it is never modified and stays above 1 so that nobody treats it as their own buffer
 	"\0"
 };
 
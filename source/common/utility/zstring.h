@@ -86,7 +86,7 @@ struct FStringData
 		}
 		else
 		{
-			RefCount++;
+			if (!IsNullString()) RefCount++;
 			return (char *)(this + 1);
 		}
 	}
@@ -95,12 +95,14 @@ struct FStringData
 	{
 		assert (RefCount != 0);
 
-		if (--RefCount <= 0)
+		if (!IsNullString() && --RefCount <= 0)
 		{
 			Dealloc();
 		}
 	}
 
+	// The shared empty string is never written to, so that strings can be created and destroyed on any thread.
+	inline bool IsNullString() const;
 	FStringData *MakeCopy();
 
 	static FStringData *Alloc (size_t strlen);
@@ -356,7 +358,6 @@ protected:
 
 	void ResetToNull()
 	{
-		NullString.RefCount++;
 		Chars = &NullString.Nothing[0];
 	}
 
@@ -416,6 +417,11 @@ public:
 private:
 };
 
+inline bool FStringData::IsNullString() const
+{
+	return (const void *)this == (const void *)&FString::NullString;
+}
+
 // These are also needed to block the default char * conversion operator from making a mess.
 bool operator == (const char *, const FString &) = delete;
 bool operator != (const char *, const FString &) = delete;
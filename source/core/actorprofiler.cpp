@@ -0,0 +1,250 @@
+/*
+** actorprofiler.cpp
+**
+** per actor type timing of the game logic
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 agent
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "actorprofiler.h"
+#include "tarray.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "stats.h"
+#include "files.h"
+#include "i_time.h"
+#include <algorithm>
+
+bool actorProfiling;
+
+struct ActorProfileEntry
+{
+	uint64_t calls;
+	int64_t time;
+	int64_t maxtime;
+};
+
+using ActorProfileMap = TMap<uint32_t, ActorProfileEntry>;
+
+static ActorProfileMap current;		// the tic currently running
+static ActorProfileMap window;		// sum of all tics in the ring
+static ActorProfileMap total;		// everything since the last reset
+static TArray<ActorProfileMap> ring;
+static TArray<int64_t> ringtime;
+static unsigned ringpos;
+static unsigned ringfill;
+static int64_t childtime;
+static int64_t currenttime;
+static uint64_t totaltics;
+
+static uint32_t MakeKey(int type, int statnum)
+{
+	return (uint32_t(statnum) << 16) | uint16_t(type);
+}
+
+static int KeyType(uint32_t key) { return int16_t(key & 0xffff); }
+static int KeyStat(uint32_t key) { return int16_t(key >> 16); }
+
+//==========================================================================
+//
+// The time of nested scopes is accumulated in childtime and subtracted
+// from the enclosing one when it leaves.
+//
+//==========================================================================
+
+void ActorProfileEnter(int64_t& start, int64_t& parentchild)
+{
+	parentchild = childtime;
+	childtime = 0;
+	start = I_nsTime();
+}
+
+void ActorProfileLeave(int type, int statnum, int64_t start, int64_t parentchild)
+{
+	int64_t elapsed = I_nsTime() - start;
+	int64_t self = elapsed - childtime;
+	childtime = parentchild + elapsed;
+
+	auto& entry = current[MakeKey(type, statnum)];
+	entry.calls++;
+	entry.time += self;
+	entry.maxtime = max(entry.maxtime, self);
+	currenttime += self;
+}
+
+//==========================================================================
+//
+// Called once per game tic. Moves the data of the finished tic into
+// the rolling window and the overall totals.
+//
+//==========================================================================
+
+static void Accumulate(ActorProfileMap& dest, ActorProfileMap& source, int sign)
+{
+	ActorProfileMap::Iterator it(source);
+	ActorProfileMap::Pair* pair;
+	while (it.NextPair(pair))
+	{
+		auto& entry = dest[pair->Key];
+		entry.calls += sign * pair->Value.calls;
+		entry.time += sign * pair->Value.time;
+		if (sign > 0) entry.maxtime = max(entry.maxtime, pair->Value.maxtime);
+		else if (entry.calls == 0) dest.Remove(pair->Key);
+	}
+}
+
+static void ResetActorProfile()
+{
+	current.Clear();
+	window.Clear();
+	total.Clear();
+	ring.Clear();
+	ring.Resize(max(GameTicRate, 1));
+	ringtime.Resize(ring.Size());
+	for (auto& t : ringtime) t = 0;
+	ringpos = ringfill = 0;
+	childtime = currenttime = 0;
+	totaltics = 0;
+}
+
+void ActorProfileTicker()
+{
+	if (!actorProfiling || ring.Size() == 0) return;
+
+	// The window's maxtime is not reduced when old tics drop out, so it is the worst case since the reset.
+	Accumulate(window, ring[ringpos], -1);
+	Accumulate(window, current, 1);
+	Accumulate(total, current, 1);
+	ring[ringpos] = std::move(current);
+	ringtime[ringpos] = currenttime;
+	current.Clear();
+	currenttime = 0;
+	ringpos = (ringpos + 1) % ring.Size();
+	if (ringfill < ring.Size()) ringfill++;
+	totaltics++;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static TArray<uint32_t> SortedKeys(ActorProfileMap& map)
+{
+	TArray<uint32_t> keys;
+	ActorProfileMap::Iterator it(map);
+	ActorProfileMap::Pair* pair;
+	while (it.NextPair(pair)) keys.Push(pair->Key);
+	std::sort(keys.begin(), keys.end(), [&](uint32_t a, uint32_t b) { return map[a].time > map[b].time; });
+	return keys;
+}
+
+ADD_STAT(actors)
+{
+	FString out;
+	if (!actorProfiling)
+	{
+		out = "Actor profiling is off, use 'actorprofile start'";
+		return out;
+	}
+	if (ringfill == 0) return out;
+
+	int64_t sum = 0, worst = 0;
+	for (unsigned i = 0; i < ringfill; i++)
+	{
+		sum += ringtime[i];
+		worst = max(worst, ringtime[i]);
+	}
+	out.AppendFormat("Actors over %u tics: %.3f ms/tic, worst tic %.3f ms\n", ringfill, sum * 1e-6 / ringfill, worst * 1e-6);
+	out.AppendFormat("%6s %5s %9s %9s %9s %6s\n", "type", "stat", "calls/tic", "us/tic", "max us", "%");
+
+	auto keys = SortedKeys(window);
+	for (unsigned i = 0; i < keys.Size() && i < 16; i++)
+	{
+		auto& e = window[keys[i]];
+		out.AppendFormat("%6d %5d %9.1f %9.1f %9.1f %6.2f\n", KeyType(keys[i]), KeyStat(keys[i]),
+			double(e.calls) / ringfill, e.time * 1e-3 / ringfill, e.maxtime * 1e-3, e.time * 100. / max<int64_t>(sum, 1));
+	}
+	return out;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void DumpActorProfile(const char* filename)
+{
+	auto fw = FileWriter::Open(filename);
+	if (!fw)
+	{
+		Printf("Unable to open %s\n", filename);
+		return;
+	}
+	fw->Printf("type,statnum,calls,total_ms,avg_us,max_us,calls_per_tic,us_per_tic\n");
+	auto keys = SortedKeys(total);
+	double tics = double(max<uint64_t>(totaltics, 1));
+	for (auto key : keys)
+	{
+		auto& e = total[key];
+		fw->Printf("%d,%d,%llu,%.4f,%.3f,%.3f,%.3f,%.3f\n", KeyType(key), KeyStat(key), (unsigned long long)e.calls,
+			e.time * 1e-6, e.time * 1e-3 / max<uint64_t>(e.calls, 1), e.maxtime * 1e-3, e.calls / tics, e.time * 1e-3 / tics);
+	}
+	delete fw;
+	Printf("%u actor types over %llu tics written to %s\n", keys.Size(), (unsigned long long)totaltics, filename);
+}
+
+CCMD(actorprofile)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: actorprofile start|stop|reset|dump [filename]\n");
+		return;
+	}
+	if (!stricmp(argv[1], "start"))
+	{
+		if (ring.Size() == 0) ResetActorProfile();
+		actorProfiling = true;
+	}
+	else if (!stricmp(argv[1], "stop"))
+	{
+		actorProfiling = false;
+	}
+	else if (!stricmp(argv[1], "reset"))
+	{
+		ResetActorProfile();
+	}
+	else if (!stricmp(argv[1], "dump"))
+	{
+		DumpActorProfile(argv.argc() > 2 ? argv[2] : "actorprofile.csv");
+	}
+}
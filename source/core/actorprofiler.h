@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+//==========================================================================
+//
+// Opt-in per actor type timing of the game logic.
+//
+// Each game wraps the code that runs one actor for one tic in an
+// ActorProfileScope, keyed by actor type and status list. What 'type'
+// means is up to the game: Duke and SW use the picnum, Blood the sprite
+// type and Exhumed the index of the runlist function, with the message
+// number in place of the status list.
+// Scopes may nest, the time of inner scopes is not counted for the outer one.
+//
+// Unless enabled with 'actorprofile start' a scope costs one branch.
+//
+//==========================================================================
+
+extern bool actorProfiling;
+
+void ActorProfileEnter(int64_t& start, int64_t& parentchild);
+void ActorProfileLeave(int type, int statnum, int64_t start, int64_t parentchild);
+void ActorProfileTicker();
+
+class ActorProfileScope
+{
+	int type, statnum;
+	int64_t start, parentchild;
+
+public:
+	ActorProfileScope(int type_, int statnum_)
+	{
+		type = type_;
+		statnum = statnum_;
+		start = -1;
+		if (actorProfiling) ActorProfileEnter(start, parentchild);
+	}
+
+	~ActorProfileScope()
+	{
+		if (start >= 0) ActorProfileLeave(type, statnum, start, parentchild);
+	}
+};
@@ -68,13 +68,13 @@
 #include "d_ticcmd.h"
 #include "m_random.h"
 #include "cheats.h"
+#include "demo.h"
 
 extern bool pauseext;
 extern int gametic;
 
 // Placeholders to make it compile.
 FILE* debugfile;
-bool demoplayback;
 int Net_Arbitrator;
 bool playeringame[MAXPLAYERS] = { true }; // as long as network isn't working - true for the first player, false for all others.
 bool singletics;
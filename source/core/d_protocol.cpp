@@ -37,6 +37,7 @@
 #include "d_net.h"
 #include "cmdlib.h"
 #include "serializer.h"
+#include "demo.h"
 
 extern int gametic;
 
@@ -376,9 +377,7 @@ void RunNetSpecs (int player, int buf)
 				int type = ReadByte (&stream);
 				Net_DoCommand (type, &stream, player);
 			}
-#if 0
 			if (!demorecording)
-#endif
 				NetSpecs[player][buf].SetData (NULL, 0);
 		}
 	}
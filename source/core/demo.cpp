@@ -0,0 +1,573 @@
+/*
+** demo.cpp
+**
+** demo recording and playback
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 agent
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The file is an IFF FORM of type RDEM with two chunks:
+**
+** RZHD: version (word), game filter (string), map label (string),
+**       map file (string), skill (byte), randomseed (long),
+**       number of values (word) and values (long) of the game's own
+**       random number generators
+** BODY: one record per tic: the special commands and the user command,
+**       encoded like in network packets, then the pause state (byte)
+**       and the sync checksum (word).
+**
+*/
+
+#include "demo.h"
+#include "d_net.h"
+#include "d_protocol.h"
+#include "c_dispatch.h"
+#include "c_console.h"
+#include "cmdlib.h"
+#include "m_argv.h"
+#include "files.h"
+#include "printf.h"
+#include "i_time.h"
+#include "engineerrors.h"
+#include "gamestate.h"
+#include "gamecontrol.h"
+#include "mapinfo.h"
+#include "build.h"
+#include "gamestruct.h"
+
+bool demorecording;
+bool demoplayback;
+bool singledemo;
+bool timingdemo;
+bool nodrawers;
+extern bool singletics;
+extern int gametic;
+
+enum
+{
+	DEMOVERSION = 2,
+	DS_None = 0,
+	DS_Record,
+	DS_Play,
+};
+
+static int demostart;
+static FString demoname;
+static FString demomap, demomapfile;
+static int demoskill;
+static int demoseed;
+static TArray<int32_t> demorandom;
+static TArray<uint8_t> demobody;
+static unsigned demopos;
+static InputPacket demolastcmd[MAXPLAYERS];
+
+// playback statistics.
+static uint64_t demostarttime;
+static int demotics, demotimedtics, demodesyncs, demoworsttic;
+static double demotictotal, demoticworst;
+
+//==========================================================================
+//
+// A cheap hash of the state of all sprites. The games keep all their
+// actors in the sprite array so this catches almost every desync.
+//
+//==========================================================================
+
+static uint16_t DemoChecksum()
+{
+	static TArray<int32_t> state;
+	state.Clear();
+	gi->GetRandomState(state);
+
+	uint32_t sum = randomseed;
+	for (auto v : state) sum = sum * 31 + v;
+	for (int i = 0; i < MAXSPRITES; i++)
+	{
+		auto spr = &sprite[i];
+		if (spr->statnum == MAXSTATUS) continue;
+		sum = sum * 31 + spr->x;
+		sum = sum * 31 + spr->y;
+		sum = sum * 31 + spr->z;
+		sum = sum * 31 + (spr->ang | (spr->sectnum << 16));
+		sum = sum * 31 + (spr->picnum | (spr->statnum << 16));
+	}
+	return uint16_t(sum ^ (sum >> 16));
+}
+
+//==========================================================================
+//
+// Makes sure that the next 'size' bytes can be written to the body.
+//
+//==========================================================================
+
+static uint8_t* DemoWritePos(unsigned size)
+{
+	unsigned pos = demobody.Size();
+	demobody.Resize(pos + size);
+	return &demobody[pos];
+}
+
+static void DemoWriteDone(uint8_t* end)
+{
+	demobody.Clamp(unsigned(end - demobody.Data()));
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static FString DemoFileName(const char* name)
+{
+	FString filename = name;
+	DefaultExtension(filename, ".dmo");
+	if (filename.IndexOfAny("/\\:") < 0)
+	{
+		filename = G_GetDemoPath() + filename;
+	}
+	return filename;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void G_RecordDemo(const char* name, MapRecord* map, int skill)
+{
+	G_CheckDemoStatus();
+	demoname = DemoFileName(name);
+	demostart = DS_Record;
+	DeferredStartGame(map, skill);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void G_DeferedPlayDemo(const char* name)
+{
+	G_CheckDemoStatus();
+
+	FString filename = DemoFileName(name);
+	FileReader fr;
+	if (!fr.OpenFile(filename) && !fr.OpenFile(name))
+	{
+		Printf(TEXTCOLOR_RED "%s: unable to open demo\n", filename.GetChars());
+		return;
+	}
+	auto data = fr.ReadPadded(64);	// the padding protects the reader against truncated files.
+	unsigned size = data.Size() - 64;
+	uint8_t* p = data.Data();
+
+	if (size < 12 || ReadLong(&p) != FORM_ID || (ReadLong(&p), ReadLong(&p) != ZDEM_ID))
+	{
+		Printf(TEXTCOLOR_RED "%s is not a demo file\n", name);
+		return;
+	}
+
+	bool header = false;
+	demobody.Clear();
+	while (p + 8 <= data.Data() + size)
+	{
+		int id = ReadLong(&p);
+		int len = ReadLong(&p);
+		uint8_t* next = p + len + (len & 1);
+		if (len < 0 || p + len > data.Data() + size)
+		{
+			Printf(TEXTCOLOR_RED "%s: demo is truncated\n", name);
+			return;
+		}
+
+		if (id == ZDHD_ID)
+		{
+			if (ReadShort(&p) != DEMOVERSION)
+			{
+				Printf(TEXTCOLOR_RED "%s: unsupported demo version\n", name);
+				return;
+			}
+			FString filter = ReadStringConst(&p);
+			if (filter.CompareNoCase(LumpFilter) != 0)
+			{
+				Printf(TEXTCOLOR_RED "%s: demo was recorded for %s\n", name, filter.GetChars());
+				return;
+			}
+			demomap = ReadStringConst(&p);
+			demomapfile = ReadStringConst(&p);
+			demoskill = (int8_t)ReadByte(&p);
+			demoseed = ReadLong(&p);
+			int count = (uint16_t)ReadShort(&p);
+			if (p + count * 4 > next)
+			{
+				Printf(TEXTCOLOR_RED "%s: demo header is truncated\n", name);
+				return;
+			}
+			demorandom.Resize(count);
+			for (auto& v : demorandom) v = ReadLong(&p);
+			header = true;
+		}
+		else if (id == BODY_ID)
+		{
+			// keep the padding for the same reason as above.
+			demobody.Resize(len + 64);
+			memcpy(demobody.Data(), p, len + 64);
+			demobody.Clamp(len);
+		}
+		p = next;
+	}
+	if (!header)
+	{
+		Printf(TEXTCOLOR_RED "%s: demo has no header\n", name);
+		return;
+	}
+
+	auto map = FindMapByName(demomap);
+	if (map == nullptr) map = SetupUserMap(demomapfile);
+	if (map == nullptr)
+	{
+		Printf(TEXTCOLOR_RED "%s: map %s not found\n", name, demomap.GetChars());
+		return;
+	}
+	demoname = filename;
+	demostart = DS_Play;
+	DeferredStartGame(map, demoskill);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void G_TimeDemo(const char* name)
+{
+	nodrawers = !!Args->CheckParm("-nodraw");
+	singletics = true;
+	timingdemo = true;
+	G_DeferedPlayDemo(name);
+	if (demostart != DS_Play)
+	{
+		singletics = timingdemo = false;
+	}
+}
+
+//==========================================================================
+//
+// Demos always start at the first tic of the level, skipping any
+// cutscene before it.
+//
+//==========================================================================
+
+bool G_DemoStartPending()
+{
+	return demostart != DS_None;
+}
+
+void G_BeginDemo()
+{
+	if (demostart == DS_None || currentLevel == nullptr) return;
+
+	for (auto& c : demolastcmd) c = {};
+	if (demostart == DS_Record)
+	{
+		demomap = currentLevel->labelName;
+		demomapfile = currentLevel->fileName;
+		demoskill = g_nextskill;
+		demoseed = randomseed;
+		// also applied when recording, so that games can derive other generators from it the same way on both ends.
+		demorandom.Clear();
+		gi->GetRandomState(demorandom);
+		gi->SetRandomState(demorandom);
+		demobody.Clear();
+		demorecording = true;
+		Printf("Recording %s\n", demoname.GetChars());
+	}
+	else
+	{
+		randomseed = demoseed;
+		gi->SetRandomState(demorandom);
+		demopos = 0;
+		for (auto& cmd : playercmds) cmd = {};
+		demotics = demotimedtics = demodesyncs = 0;
+		demotictotal = demoticworst = 0;
+		demoworsttic = 0;
+		demostarttime = I_nsTime();
+		demoplayback = true;
+	}
+	demostart = DS_None;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void G_WriteDemoTiccmd(ticcmd_t* cmd, int player, int buf)
+{
+	int speclen = 0;
+	uint8_t* specdata = NetSpecs[player][buf].GetData(&speclen);
+	uint8_t* p = DemoWritePos(speclen + 32);
+
+	// Record the special commands first, they get executed before the user command.
+	if (specdata && gametic % ticdup == 0)
+	{
+		memcpy(p, specdata, speclen);
+		p += speclen;
+		NetSpecs[player][buf].SetData(nullptr, 0);
+	}
+	WriteUserCmdMessage(&cmd->ucmd, &demolastcmd[player], &p);
+	demolastcmd[player] = cmd->ucmd;
+	DemoWriteDone(p);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void G_EndDemo()
+{
+	G_CheckDemoStatus();
+	if (singledemo) throw CExitEvent(0);
+	gameaction = ga_mainmenu;
+}
+
+void G_ReadDemoTiccmd(ticcmd_t* cmd, int player)
+{
+	int id = DEM_BAD;
+
+	while (id != DEM_USERCMD && id != DEM_EMPTYUSERCMD)
+	{
+		if (demopos >= demobody.Size())
+		{
+			G_EndDemo();
+			return;
+		}
+		uint8_t* p = &demobody[demopos];
+		id = ReadByte(&p);
+
+		if (id == DEM_USERCMD)
+		{
+			UnpackUserCmd(&cmd->ucmd, &cmd->ucmd, &p);
+		}
+		else if (id != DEM_EMPTYUSERCMD)
+		{
+			Net_DoCommand(id, &p, player);
+		}
+		demopos = unsigned(p - demobody.Data());
+	}
+}
+
+//==========================================================================
+//
+// Called once per tic after the pause state has been determined
+// and before the game logic runs.
+//
+//==========================================================================
+
+void G_DemoSync()
+{
+	if (demorecording)
+	{
+		uint8_t* p = DemoWritePos(3);
+		WriteByte(paused, &p);
+		WriteWord(DemoChecksum(), &p);
+	}
+	else if (demoplayback)
+	{
+		if (demopos + 3 > demobody.Size())
+		{
+			G_EndDemo();
+			return;
+		}
+		uint8_t* p = &demobody[demopos];
+		paused = ReadByte(&p);
+		uint16_t sync = ReadShort(&p);
+		demopos += 3;
+		demotics++;
+
+		if (sync != DemoChecksum())
+		{
+			if (demodesyncs++ == 0) Printf(TEXTCOLOR_RED "Demo desynchronized at tic %d\n", demotics);
+		}
+	}
+}
+
+void G_DemoTicTime(double ms)
+{
+	if (!demoplayback) return;
+	demotimedtics++;
+	demotictotal += ms;
+	if (ms > demoticworst)
+	{
+		demoticworst = ms;
+		demoworsttic = demotics;
+	}
+}
+
+//==========================================================================
+//
+// Ends playback or recording. Returns true if a demo was active.
+//
+//==========================================================================
+
+bool G_CheckDemoStatus()
+{
+	demostart = DS_None;
+
+	if (demoplayback)
+	{
+		demoplayback = false;
+		demobody.Reset();
+		if (timingdemo)
+		{
+			double seconds = (I_nsTime() - demostarttime) * 1e-9;
+			Printf(PRINT_BOLD, "%s: %d tics in %.3f seconds, %.1f tics/sec\n", demoname.GetChars(), demotics, seconds, demotics / max(seconds, 0.001));
+			if (demotimedtics > 0)
+				Printf(PRINT_BOLD, "game logic per tic: average %.3f ms, worst %.3f ms (tic %d)\n", demotictotal / demotimedtics, demoticworst, demoworsttic);
+			timingdemo = singletics = nodrawers = false;
+		}
+		if (demodesyncs) Printf(TEXTCOLOR_RED "%d of %d tics were out of sync\n", demodesyncs, demotics);
+		return true;
+	}
+
+	if (demorecording)
+	{
+		demorecording = false;
+
+		TArray<uint8_t> header(1024 + demorandom.Size() * 4, true);
+		uint8_t* p = header.Data();
+		WriteLong(FORM_ID, &p);
+		uint8_t* formlen = p;
+		p += 4;
+		WriteLong(ZDEM_ID, &p);
+		StartChunk(ZDHD_ID, &p);
+		WriteWord(DEMOVERSION, &p);
+		WriteString(LumpFilter.Left(200), &p);
+		WriteString(demomap.Left(200), &p);
+		WriteString(demomapfile.Left(400), &p);
+		WriteByte(demoskill, &p);
+		WriteLong(demoseed, &p);
+		WriteWord(demorandom.Size(), &p);
+		for (auto v : demorandom) WriteLong(v, &p);
+		FinishChunk(&p);
+		WriteLong(BODY_ID, &p);
+		WriteLong(demobody.Size(), &p);
+		if (demobody.Size() & 1) demobody.Push(0);
+		WriteLong(int(p - header.Data() - 8 + demobody.Size()), &formlen);
+
+		auto fw = FileWriter::Open(demoname);
+		if (fw == nullptr)
+		{
+			Printf(TEXTCOLOR_RED "%s: unable to write demo\n", demoname.GetChars());
+		}
+		else
+		{
+			fw->Write(header.Data(), p - header.Data());
+			fw->Write(demobody.Data(), demobody.Size());
+			delete fw;
+			Printf("Demo %s recorded\n", demoname.GetChars());
+		}
+		demobody.Reset();
+		return true;
+	}
+	return false;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(record)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: record <demo name> [map]\n");
+		return;
+	}
+	if (netgame)
+	{
+		Printf("Demos cannot be recorded in network games\n");
+		return;
+	}
+	MapRecord* map = currentLevel;
+	if (argv.argc() > 2)
+	{
+		map = FindMapByName(argv[2]);
+		if (map == nullptr)
+		{
+			FString mapfilename = argv[2];
+			DefaultExtension(mapfilename, ".map");
+			map = SetupUserMap(mapfilename);
+		}
+	}
+	if (map == nullptr)
+	{
+		Printf("No map to record\n");
+		return;
+	}
+	G_RecordDemo(argv[1], map, g_nextskill);
+}
+
+CCMD(stop)
+{
+	if (!demorecording)
+	{
+		Printf("Not recording a demo\n");
+		return;
+	}
+	G_CheckDemoStatus();
+}
+
+CCMD(playdemo)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: playdemo <demo name>\n");
+		return;
+	}
+	G_DeferedPlayDemo(argv[1]);
+}
+
+CCMD(timedemo)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: timedemo <demo name>\n");
+		return;
+	}
+	G_TimeDemo(argv[1]);
+}
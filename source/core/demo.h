@@ -0,0 +1,36 @@
+#pragma once
+
+#include "d_ticcmd.h"
+
+//==========================================================================
+//
+// Demo recording and playback.
+//
+// A demo stores the start map and skill, the engine's RNG seed and the
+// command stream of every tic from the moment the level is entered.
+// All games reseed their own RNGs at level start so this is enough to
+// replay a session as long as the game logic is deterministic.
+// Each tic also stores the pause state and a checksum of the sprite state
+// so that desyncs are detected during playback.
+//
+//==========================================================================
+
+struct MapRecord;
+
+extern bool demorecording;
+extern bool demoplayback;
+extern bool singledemo;		// quit after playback ends
+extern bool timingdemo;		// play back as fast as possible and report the results
+extern bool nodrawers;		// do not render anything while timing a demo
+
+void G_RecordDemo(const char* name, MapRecord* map, int skill);
+void G_DeferedPlayDemo(const char* name);
+void G_TimeDemo(const char* name);
+bool G_CheckDemoStatus();
+
+bool G_DemoStartPending();
+void G_BeginDemo();
+void G_WriteDemoTiccmd(ticcmd_t* cmd, int player, int buf);
+void G_ReadDemoTiccmd(ticcmd_t* cmd, int player);
+void G_DemoSync();
+void G_DemoTicTime(double ms);
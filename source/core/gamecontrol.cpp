@@ -78,6 +78,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "hw_voxels.h"
 #include "hw_palmanager.h"
 #include "razefont.h"
+#include "demo.h"
 
 CVAR(Bool, autoloadlights, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Bool, autoloadbrightmaps, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
@@ -579,6 +580,7 @@ int GameMain()
 		I_ShowFatalError(err.what());
 		r = -1;
 	}
+	G_CheckDemoStatus();	// save any demo that is still being recorded.
 	//DeleteScreenJob();
 	DeinitMenus();
 	if (StatusBar) StatusBar->Destroy();
@@ -597,6 +599,7 @@ int GameMain()
 	V_ClearFonts();
 	voxClear();
 	ClearPalManager();
+	FlushUpscaleCache();
 	TexMan.DeleteAll();
 	TileFiles.CloseAll();	// delete the texture data before shutting down graphics.
 	I_ShutdownGraphics();
@@ -1379,6 +1382,7 @@ void GameInterface::FreeLevelData()
 	// Make sure that there is no more level to toy around with.
 	initspritelists();
 	numsectors = numwalls = 0;
+	clearMapArrays();
 	currentLevel = nullptr;
 }
 
@@ -60,6 +60,13 @@ struct GeoEffect
 
 };
 
+// A light that casts shadows through the shadow map, in renderer coordinates.
+struct ShadowLight
+{
+	float x, y, z;
+	float radius;
+};
+
 struct GameInterface
 {
 	virtual const char* Name() { return "$"; }
@@ -84,6 +91,9 @@ struct GameInterface
 	virtual FSavegameInfo GetSaveSig() { return { "", 0, 0}; }
 	virtual double SmallFontScale() { return 1; }
 	virtual void SerializeGameState(FSerializer& arc) {}
+	// The game's own random number generators. randomseed is handled by the engine.
+	virtual void GetRandomState(TArray<int32_t>& state) {}
+	virtual void SetRandomState(const TArray<int32_t>& state) {}
 	virtual void DrawPlayerSprite(const DVector2& origin, bool onteam) {}
 	virtual void SetAmbience(bool on) {}
 	virtual FString GetCoordString() { return "'stat coord' not implemented"; }
@@ -119,6 +129,7 @@ struct GameInterface
 	virtual void EnterPortal(spritetype* viewer, int type) {}
 	virtual void LeavePortal(spritetype* viewer, int type) {}
 	virtual bool GetGeoEffect(GeoEffect* eff, int viewsector) { return false; }
+	virtual void GetShadowLights(TArray<ShadowLight>& lights) {}
 	virtual int Voxelize(int sprnum) { return -1; }
 	virtual void AddExcludedEpisode(FString episode) {}
 	virtual int GetCurrentSkill() { return -1; }
@@ -12,6 +12,7 @@
 #include "m_joy.h"
 #include "gamecvars.h"
 #include "packet.h"
+#include "demo.h"
 
 
 struct ControlInfo
@@ -109,7 +110,7 @@ extern bool gamesetinput;
 
 inline bool SyncInput()
 {
-	return gamesetinput || cl_syncinput;
+	return gamesetinput || cl_syncinput || demorecording || demoplayback;
 }
 
 //---------------------------------------------------------------------------
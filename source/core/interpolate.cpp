@@ -22,159 +22,271 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "build.h"
 #include "interpolate.h"
+#include "sectorgeometry.h"
 #include "xs_Float.h"
 #include "serializer.h"
 #include "gamecvars.h"
 
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
 
-struct Interpolation
+
+//==========================================================================
+//
+// Interpolations are stored per type, as parallel arrays of indices and
+// values, so that all the per-frame work is done in tight loops over
+// one group at a time instead of dispatching on the type for each entry.
+//
+//==========================================================================
+
+struct InterpolationGroup
 {
-	double old, bak;
-	int index;
-	int type;
+	TArray<int> index;
+	TArray<double> old;
 };
 
-static TArray<Interpolation> interpolations;
+static InterpolationGroup interpolations[Interp_Count];
+
+//==========================================================================
+//
+// The render snapshot.
+//
+// At the end of each tic the interpolated values are copied into a
+// self-contained list that contains both ends of the interpolation.
+// The frame code only works off this list and never looks at the live
+// values, so it does not depend on the playsim's state after the tic has
+// ended. Tics are never run while a frame is being rendered, so a single
+// snapshot is all that is needed.
+//
+// For the panning types 'to' is adjusted at snapshot time so that the
+// interpolation always takes the shorter way around the 256 unit range.
+// 'bak' holds the actual value that gets restored after rendering.
+//
+//==========================================================================
 
-double Get(int index, int type)
+struct SnapshotGroup
 {
-	switch(type)
+	TArray<int> index;
+	TArray<double> from, to, bak, cur;
+};
+
+static SnapshotGroup snapshot[Interp_Count];
+
+//==========================================================================
+//
+// Calls 'op' with an accessor that returns a reference to the
+// interpolated field of the given map element.
+//
+//==========================================================================
+
+template<class Op>
+static void WithAccessor(int type, Op&& op)
+{
+	switch (type)
 	{
-	case Interp_Sect_Floorz:			return sector[index].floorz;
-	case Interp_Sect_Ceilingz:			return sector[index].ceilingz;
-	case Interp_Sect_Floorheinum:		return sector[index].floorheinum;
-	case Interp_Sect_Ceilingheinum:		return sector[index].ceilingheinum;
-	case Interp_Sect_FloorPanX:			return sector[index].floorxpan_;
-	case Interp_Sect_FloorPanY:			return sector[index].floorypan_;
-	case Interp_Sect_CeilingPanX:		return sector[index].ceilingxpan_;
-	case Interp_Sect_CeilingPanY:		return sector[index].ceilingypan_;
-
-	case Interp_Wall_X:					return wall[index].x;
-	case Interp_Wall_Y:					return wall[index].y;
-	case Interp_Wall_PanX:				return wall[index].xpan_;
-	case Interp_Wall_PanY:				return wall[index].ypan_;
-
-	case Interp_Sprite_Z:				return sprite[index].z;
-	default: return 0;
+	case Interp_Sect_Floorz:			op([](int n) -> auto& { return sector[n].floorz; }); break;
+	case Interp_Sect_Ceilingz:			op([](int n) -> auto& { return sector[n].ceilingz; }); break;
+	case Interp_Sect_Floorheinum:		op([](int n) -> auto& { return sector[n].floorheinum; }); break;
+	case Interp_Sect_Ceilingheinum:		op([](int n) -> auto& { return sector[n].ceilingheinum; }); break;
+	case Interp_Sect_FloorPanX:			op([](int n) -> auto& { return sector[n].floorxpan_; }); break;
+	case Interp_Sect_FloorPanY:			op([](int n) -> auto& { return sector[n].floorypan_; }); break;
+	case Interp_Sect_CeilingPanX:		op([](int n) -> auto& { return sector[n].ceilingxpan_; }); break;
+	case Interp_Sect_CeilingPanY:		op([](int n) -> auto& { return sector[n].ceilingypan_; }); break;
+
+	case Interp_Wall_X:					op([](int n) -> auto& { return wall[n].x; }); break;
+	case Interp_Wall_Y:					op([](int n) -> auto& { return wall[n].y; }); break;
+	case Interp_Wall_PanX:				op([](int n) -> auto& { return wall[n].xpan_; }); break;
+	case Interp_Wall_PanY:				op([](int n) -> auto& { return wall[n].ypan_; }); break;
+
+	case Interp_Sprite_Z:				op([](int n) -> auto& { return sprite[n].z; }); break;
 	}
 }
 
-void Set(int index, int type, double val)
+template<class T> static inline T ConvertInterpolation(double val) { return T(xs_CRoundToInt(val)); }
+template<> inline float ConvertInterpolation<float>(double val) { return float(val); }
+
+static void Gather(int type, const int* index, double* out, unsigned count)
+{
+	WithAccessor(type, [=](auto get)
+	{
+		for (unsigned i = 0; i < count; i++) out[i] = get(index[i]);
+	});
+}
+
+static void Scatter(int type, const int* index, const double* val, unsigned count)
 {
-	int old;
-	switch(type)
+	WithAccessor(type, [=](auto get)
 	{
-	case Interp_Sect_Floorz:			sector[index].floorz = xs_CRoundToInt(val); break;
-	case Interp_Sect_Ceilingz:          sector[index].ceilingz = xs_CRoundToInt(val); break;
-	case Interp_Sect_Floorheinum:       sector[index].floorheinum = (short)xs_CRoundToInt(val); break;
-	case Interp_Sect_Ceilingheinum:     sector[index].ceilingheinum = (short)xs_CRoundToInt(val); break;
-	case Interp_Sect_FloorPanX:         sector[index].floorxpan_ = float(val); break;
-	case Interp_Sect_FloorPanY:	        sector[index].floorypan_ = float(val); break;
-	case Interp_Sect_CeilingPanX:       sector[index].ceilingxpan_ = float(val); break;
-	case Interp_Sect_CeilingPanY:       sector[index].ceilingypan_ = float(val); break;
-                                        
-	case Interp_Wall_X:                 old = wall[index].x; wall[index].x = xs_CRoundToInt(val); if (wall[index].x != old) sector[wall[index].sector].dirty = 255; break;
-	case Interp_Wall_Y:                 old = wall[index].y; wall[index].y = xs_CRoundToInt(val); if (wall[index].y != old) sector[wall[index].sector].dirty = 255; break;
-	case Interp_Wall_PanX:              wall[index].xpan_ = float(val);  break;
-	case Interp_Wall_PanY:              wall[index].ypan_ = float(val);  break;
-                                        
-	case Interp_Sprite_Z:               sprite[index].z = xs_CRoundToInt(val); break;
+		using T = std::remove_reference_t<decltype(get(0))>;
+		if (type == Interp_Wall_X || type == Interp_Wall_Y)
+		{
+			// moving a wall requires the sector's geometry to be rebuilt.
+			for (unsigned i = 0; i < count; i++)
+			{
+				auto& ref = get(index[i]);
+				T v = ConvertInterpolation<T>(val[i]);
+				if (ref != v)
+				{
+					ref = v;
+					sectorGeometry.MarkDirty(wall[index[i]].sector);
+				}
+			}
+		}
+		else
+		{
+			for (unsigned i = 0; i < count; i++) get(index[i]) = ConvertInterpolation<T>(val[i]);
+		}
+	});
+}
+
+static double Get(int index, int type)
+{
+	double val = 0;
+	Gather(type, &index, &val, 1);
+	return val;
+}
+
+//==========================================================================
+//
+// out = from + (to - from) * t
+//
+//==========================================================================
+
+static void Lerp(const double* from, const double* to, double* out, unsigned count, double t)
+{
+	unsigned i = 0;
+#ifndef NO_SSE
+	__m128d mt = _mm_set1_pd(t);
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128d a = _mm_loadu_pd(from + i);
+		__m128d b = _mm_loadu_pd(to + i);
+		_mm_storeu_pd(out + i, _mm_add_pd(a, _mm_mul_pd(_mm_sub_pd(b, a), mt)));
 	}
+#endif
+	for (; i < count; i++) out[i] = from[i] + (to[i] - from[i]) * t;
 }
 
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 void StartInterpolation(int index, int type)
 {
-    for (unsigned i = 0; i < interpolations.Size(); i++)
-    {
-        if (interpolations[i].index == index && interpolations[i].type == type)
-            return;
-    }
-	int n = interpolations.Reserve(1);
-
-    interpolations[n].index = index;
-    interpolations[n].type = type;
-    interpolations[n].old = Get(index, type);
+	auto& group = interpolations[type];
+	if (group.index.Find(index) < group.index.Size()) return;
+	group.index.Push(index);
+	group.old.Push(Get(index, type));
 }
 
 void StopInterpolation(int index, int type)
 {
-    for (unsigned i = 0; i < interpolations.Size(); i++)
-    {
-        if (interpolations[i].index == index && interpolations[i].type == type)
+	auto& group = interpolations[type];
+	unsigned i = group.index.Find(index);
+	if (i < group.index.Size())
+	{
+		group.index[i] = group.index.Last();
+		group.old[i] = group.old.Last();
+		group.index.Pop();
+		group.old.Pop();
+	}
+}
+
+void UpdateInterpolations()
+{
+	for (int type = 0; type < Interp_Count; type++)
+	{
+		auto& group = interpolations[type];
+		Gather(type, group.index.Data(), group.old.Data(), group.index.Size());
+	}
+}
+
+//==========================================================================
+//
+// Called at the end of each tic.
+//
+//==========================================================================
+
+void SnapshotInterpolations()
+{
+	for (int type = 0; type < Interp_Count; type++)
+	{
+		auto& group = interpolations[type];
+		auto& sg = snapshot[type];
+		unsigned count = group.index.Size();
+		sg.index = group.index;
+		sg.from = group.old;
+		sg.to.Resize(count);
+		sg.cur.Resize(count);
+		Gather(type, sg.index.Data(), sg.to.Data(), count);
+		sg.bak = sg.to;
+
+		if (type >= Interp_Pan_First)
 		{
-            interpolations[i] = interpolations.Last();
-			interpolations.Pop();
-			return;
+			// with the panning types we need to take the shorter way around.
+			for (unsigned i = 0; i < count; i++)
+			{
+				double delta = sg.to[i] - sg.from[i];
+				sg.to[i] = sg.from[i] + delta - 256. * floor(delta * (1. / 256.) + 0.5);
+			}
 		}
-    }
+	}
 }
 
-void UpdateInterpolations()
+static void InvalidateSnapshot()
 {
-    for (unsigned i = 0; i < interpolations.Size(); i++)
-    {
-		interpolations[i].old = Get(interpolations[i].index, interpolations[i].type);
-	}		
+	// Anything that changes the map outside of a tic must discard the snapshot so that no outdated values get written back.
+	for (auto& sg : snapshot) sg.index.Clear();
 }
 
 void DoInterpolations(double smoothratio)
 {
 	if (!cl_interpolate) return;
-    for (unsigned i = 0; i < interpolations.Size(); i++)
-    {
-		double bak;
-		interpolations[i].bak = bak = Get(interpolations[i].index, interpolations[i].type);
-		double old = interpolations[i].old;
-		if (interpolations[i].type < Interp_Pan_First || fabs(bak-old) < 128.)
-		{
-			Set(interpolations[i].index, interpolations[i].type, old + (bak - old) * smoothratio);
-		}
-		else
+	for (int type = 0; type < Interp_Count; type++)
+	{
+		auto& sg = snapshot[type];
+		unsigned count = sg.index.Size();
+		if (count == 0) continue;
+		Lerp(sg.from.Data(), sg.to.Data(), sg.cur.Data(), count, smoothratio);
+		if (type >= Interp_Pan_First)
 		{
-			// with the panning types we need to check for potential wraparound.
-			if (bak < old) bak += 256.;
-			else old += 256;
-			double cur = old + (bak - old) * smoothratio;
-			if (cur >= 256.) cur -= 256.;
-			Set(interpolations[i].index, interpolations[i].type, cur);
+			for (unsigned i = 0; i < count; i++) sg.cur[i] -= 256. * floor(sg.cur[i] * (1. / 256.));
 		}
+		Scatter(type, sg.index.Data(), sg.cur.Data(), count);
 	}
 }
 
 void RestoreInterpolations()
 {
 	if (!cl_interpolate) return;
-	for (unsigned i = 0; i < interpolations.Size(); i++)
-    {
-		Set(interpolations[i].index, interpolations[i].type, interpolations[i].bak);
-	}		
+	for (int type = 0; type < Interp_Count; type++)
+	{
+		auto& sg = snapshot[type];
+		Scatter(type, sg.index.Data(), sg.bak.Data(), sg.index.Size());
+	}
 }
 
 void ClearInterpolations()
 {
-	interpolations.Clear();
+	for (auto& group : interpolations)
+	{
+		group.index.Clear();
+		group.old.Clear();
+	}
+	InvalidateSnapshot();
 }
 
 void ClearMovementInterpolations()
 {
 	// This clears all movement interpolations. Needed for Blood which destroys its interpolations each frame.
-	for (unsigned i = 0; i < interpolations.Size();)
+	static const int movementtypes[] = { Interp_Sect_Floorz, Interp_Sect_Ceilingz, Interp_Sect_Floorheinum, Interp_Sect_Ceilingheinum, Interp_Wall_X, Interp_Wall_Y };
+	for (int type : movementtypes)
 	{
-		switch (interpolations[i].type)
-		{
-		case Interp_Sect_Floorz:
-		case Interp_Sect_Ceilingz:
-		case Interp_Sect_Floorheinum:
-		case Interp_Sect_Ceilingheinum:
-		case Interp_Wall_X:
-		case Interp_Wall_Y:
-			interpolations[i] = interpolations.Last();
-			interpolations.Pop();
-			break;
-		default:
-			i++;
-			break;
-		}
+		interpolations[type].index.Clear();
+		interpolations[type].old.Clear();
 	}
 }
 
@@ -221,7 +333,13 @@ void clearsectinterpolate(int sectnum)
 	}
 }
 
-FSerializer& Serialize(FSerializer& arc, const char* keyname, Interpolation& w, Interpolation* def)
+struct InterpolationRecord
+{
+	int index;
+	int type;
+};
+
+FSerializer& Serialize(FSerializer& arc, const char* keyname, InterpolationRecord& w, InterpolationRecord* def)
 {
     if (arc.BeginObject(keyname))
     {
@@ -229,14 +347,27 @@ FSerializer& Serialize(FSerializer& arc, const char* keyname, Interpolation& w,
             ("type", w.type)
             .EndObject();
     }
-	if (arc.isReading())
-	{
-		w.old = Get(w.index, w.type);
-	}
     return arc;
 }
 
 void SerializeInterpolations(FSerializer& arc)
 {
-	arc("interpolations", interpolations);
+	// The savegame format is a flat list of all interpolations.
+	TArray<InterpolationRecord> records;
+	if (arc.isWriting())
+	{
+		for (int type = 0; type < Interp_Count; type++)
+		{
+			for (int index : interpolations[type].index) records.Push({ index, type });
+		}
+	}
+	arc("interpolations", records);
+	if (arc.isReading())
+	{
+		ClearInterpolations();
+		for (auto& rec : records)
+		{
+			if (rec.type >= 0 && rec.type < Interp_Count) StartInterpolation(rec.index, rec.type);
+		}
+	}
 }
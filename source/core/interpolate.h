@@ -20,6 +20,8 @@ enum EInterpolationType
 	Interp_Sect_CeilingPanY,
 	Interp_Wall_PanX,
 	Interp_Wall_PanY,
+
+	Interp_Count
 };
 
 void StartInterpolation(int index, int type);
@@ -27,6 +29,7 @@ void StopInterpolation(int index, int type);
 void UpdateInterpolations();
 void ClearInterpolations();
 void ClearMovementInterpolations();
+void SnapshotInterpolations();
 void DoInterpolations(double smoothratio);
 void RestoreInterpolations();
 void SerializeInterpolations(FSerializer& arc);
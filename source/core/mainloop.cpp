@@ -63,6 +63,7 @@
 #include <chrono>
 #include <thread>
 #include "c_cvars.h"
+#include "m_argv.h"
 #include "i_time.h"
 #include "d_net.h"
 #include "gamecontrol.h"
@@ -88,6 +89,9 @@
 #include "savegamehelp.h"
 #include "v_draw.h"
 #include "gamehud.h"
+#include "actorprofiler.h"
+#include "demo.h"
+#include "interpolate.h"
 
 CVAR(Bool, vid_activeinbackground, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 CVAR(Bool, r_ticstability, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
@@ -109,6 +113,8 @@ FString savename;
 FString BackupSaveGame;
 
 void DoLoadGame(const char* name);
+void CheckRenderBench();
+extern bool singletics;
 
 bool sendsave;
 FString	savedescription;
@@ -147,6 +153,13 @@ bool newGameStarted;
 void NewGame(MapRecord* map, int skill, bool ns = false)
 {
 	newGameStarted = true;
+	if (G_DemoStartPending())
+	{
+		// demos start directly in the level, any cutscene before it would only get in the way.
+		gi->NewGame(map, skill, ns);
+		ResetStatusBar();
+		return;
+	}
 	ShowIntermission(nullptr, map, nullptr, [=](bool) { 
 		gi->NewGame(map, skill, ns); 
 		ResetStatusBar();
@@ -273,6 +286,7 @@ static void GameTicker()
 
 		case ga_level:
 			gamestate = GS_LEVEL;
+			G_BeginDemo();
 			break;
 
 		case ga_intro:
@@ -313,11 +327,10 @@ static void GameTicker()
 			ticcmd_t* cmd = &playercmds[i];
 			ticcmd_t* newcmd = &netcmds[i][buf];
 
-			if ((gametic % ticdup) == 0)
+			if ((gametic % ticdup) == 0 && !demoplayback)
 			{
 				RunNetSpecs(i, buf);
 			}
-#if 0
 			if (demorecording)
 			{
 				G_WriteDemoTiccmd(newcmd, i, buf);
@@ -327,7 +340,6 @@ static void GameTicker()
 				G_ReadDemoTiccmd(cmd, i);
 			}
 			else
-#endif
 			{
 				*cmd = *newcmd;
 			}
@@ -349,6 +361,7 @@ static void GameTicker()
 
 	C_RunDelayedCommands();
 	updatePauseStatus();
+	G_DemoSync();
 
 	switch (gamestate)
 	{
@@ -362,9 +375,11 @@ static void GameTicker()
 		gameupdatetime.Reset();
 		gameupdatetime.Clock();
 		gi->Ticker();
+		ActorProfileTicker();
 		TickStatusBar();
 		levelTextTime--;
 		gameupdatetime.Unclock();
+		G_DemoTicTime(gameupdatetime.TimeMS());
 		break;
 
 	case GS_MENUSCREEN:
@@ -380,6 +395,8 @@ static void GameTicker()
 		break;
 
 	}
+	// Everything the frame interpolates must be taken from the state at the end of the tic.
+	SnapshotInterpolations();
 }
 
 
@@ -665,6 +682,27 @@ void TryRunTics (void)
 }
 
 
+//==========================================================================
+//
+// Runs exactly one tic without waiting for the timer. Used for timing demos.
+//
+//==========================================================================
+
+static void RunSingleTic()
+{
+	I_StartTic();
+	D_ProcessEvents();
+	G_BuildTiccmd(&netcmds[myconnectindex][maketic % BACKUPTICS]);
+	C_Ticker();
+	M_Ticker();
+	GameTicker();
+	gametic++;
+	maketic++;
+	Net_NewMakeTic();
+	gi->UpdateSounds();
+	soundEngine->UpdateSounds(I_GetTime());
+}
+
 //==========================================================================
 //
 // MainLoop - will never return aside from exceptions being thrown.
@@ -688,9 +726,22 @@ void MainLoop ()
 		userConfig.CommandMap = "";
 		if (maprecord)
 		{
-			DeferredStartGame(maprecord, g_nextskill);
+			const char* demoname = Args->CheckValue("-record");
+			if (demoname) G_RecordDemo(demoname, maprecord, g_nextskill);
+			else DeferredStartGame(maprecord, g_nextskill);
 		}
 	}
+	if (const char* timedemo = Args->CheckValue("-timedemo"))
+	{
+		singledemo = true;
+		G_TimeDemo(timedemo);
+	}
+	else if (userConfig.CommandDemo.IsNotEmpty())
+	{
+		singledemo = true;
+		G_DeferedPlayDemo(userConfig.CommandDemo);
+	}
+	userConfig.CommandDemo = "";
 
 	for (;;)
 	{
@@ -704,11 +755,13 @@ void MainLoop ()
 			}
 			I_SetFrameTime();
 
-			TryRunTics (); // will run at least one tic
+			if (singletics) RunSingleTic();
+			else TryRunTics (); // will run at least one tic
 			// Update display, next frame, with current state.
 			I_StartTic();
 
-			Display();
+			if (!nodrawers) Display();
+			CheckRenderBench();
 			Mus_UpdateMusic();		// must be at the end.
 		}
 		catch (CRecoverableError &error)
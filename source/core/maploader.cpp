@@ -43,154 +43,305 @@
 #include "gamecontrol.h"
 #include "gamefuncs.h"
 #include "sectorgeometry.h"
+#include "sectorgrid.h"
+#include "hw_levelaabbtree.h"
 #include "render.h"
 #include "hw_sections.h"
+#include "i_time.h"
 
-static void ReadSectorV7(FileReader& fr, sectortype& sect)
+//==========================================================================
+//
+// On-disk record layouts. All values are little endian.
+//
+//==========================================================================
+
+#pragma pack(1)
+
+struct sectortypev7
+{
+	int16_t wallptr, wallnum;
+	int32_t ceilingz, floorz;
+	uint16_t ceilingstat, floorstat;
+	int16_t ceilingpicnum, ceilingheinum;
+	int8_t ceilingshade;
+	uint8_t ceilingpal, ceilingxpan, ceilingypan;
+	int16_t floorpicnum, floorheinum;
+	int8_t floorshade;
+	uint8_t floorpal, floorxpan, floorypan;
+	uint8_t visibility, fogpal;
+	int16_t lotag, hitag, extra;
+} FORCE_PACKED;
+
+// v5 and v6 use the same sector layout.
+struct sectortypev6
+{
+	uint16_t wallptr, wallnum;
+	int16_t ceilingpicnum, floorpicnum;
+	int16_t ceilingheinum, floorheinum;
+	int32_t ceilingz, floorz;
+	int8_t ceilingshade, floorshade;
+	uint8_t ceilingxpan, floorxpan, ceilingypan, floorypan;
+	uint8_t ceilingstat, floorstat, ceilingpal, floorpal;
+	uint8_t visibility;
+	int16_t lotag, hitag, extra;
+} FORCE_PACKED;
+
+struct walltypev7
+{
+	int32_t x, y;
+	int16_t point2, nextwall, nextsector;
+	uint16_t cstat;
+	int16_t picnum, overpicnum;
+	int8_t shade;
+	uint8_t pal, xrepeat, yrepeat, xpan, ypan;
+	int16_t lotag, hitag, extra;
+} FORCE_PACKED;
+
+struct walltypev6
+{
+	int32_t x, y;
+	int16_t point2, nextsector, nextwall;
+	int16_t picnum, overpicnum;
+	int8_t shade;
+	uint8_t pal;
+	uint16_t cstat;
+	uint8_t xrepeat, yrepeat, xpan, ypan;
+	int16_t lotag, hitag, extra;
+} FORCE_PACKED;
+
+struct walltypev5
+{
+	int32_t x, y;
+	int16_t point2, picnum, overpicnum;
+	int8_t shade;
+	uint16_t cstat;
+	uint8_t xrepeat, yrepeat, xpan, ypan;
+	int16_t nextsector, nextwall;
+	int16_t nextsector2, nextwall2;	// unused
+	int16_t lotag, hitag, extra;
+} FORCE_PACKED;
+
+struct spritetypev7
+{
+	int32_t x, y, z;
+	uint16_t cstat;
+	int16_t picnum;
+	int8_t shade;
+	uint8_t pal, clipdist, blend, xrepeat, yrepeat;
+	int8_t xoffset, yoffset;
+	int16_t sectnum, statnum, ang, owner, xvel, yvel, zvel;
+	int16_t lotag, hitag, extra;
+} FORCE_PACKED;
+
+struct spritetypev6
+{
+	int32_t x, y, z;
+	uint16_t cstat;
+	int8_t shade;
+	uint8_t pal, clipdist, xrepeat, yrepeat;
+	int8_t xoffset, yoffset;
+	int16_t picnum, ang, xvel, yvel, zvel, owner, sectnum, statnum;
+	int16_t lotag, hitag, extra;
+} FORCE_PACKED;
+
+struct spritetypev5
+{
+	int32_t x, y, z;
+	uint16_t cstat;
+	int8_t shade;
+	uint8_t xrepeat, yrepeat;
+	int16_t picnum, ang, xvel, yvel, zvel, owner, sectnum, statnum;
+	int16_t lotag, hitag, extra;
+} FORCE_PACKED;
+
+#pragma pack()
+
+static_assert(sizeof(sectortypev7) == 40 && sizeof(sectortypev6) == 37, "bad sector layout");
+static_assert(sizeof(walltypev7) == 32 && sizeof(walltypev6) == 32 && sizeof(walltypev5) == 35, "bad wall layout");
+static_assert(sizeof(spritetypev7) == 44 && sizeof(spritetypev6) == 43 && sizeof(spritetypev5) == 39, "bad sprite layout");
+
+//==========================================================================
+//
+// Returns the next count records from the map buffer.
+// A truncated map gets padded with zeros, like reading past the end of
+// a file would have done.
+//
+//==========================================================================
+
+template<class T>
+static const T* GetMapRecords(TArray<uint8_t>& buffer, unsigned& pos, unsigned count)
+{
+	unsigned size = sizeof(T) * count;
+	if (pos + size > buffer.Size())
+	{
+		unsigned oldsize = buffer.Size();
+		buffer.Resize(pos + size);
+		memset(&buffer[oldsize], 0, buffer.Size() - oldsize);
+	}
+	auto records = reinterpret_cast<const T*>(buffer.Data() + pos);
+	pos += size;
+	return records;
+}
+
+// The header fields are not aligned, so they get copied out byte-wise.
+static int ReadMapInt16(TArray<uint8_t>& buffer, unsigned& pos)
 {
-	sect.wallptr = fr.ReadInt16();
-	sect.wallnum = fr.ReadInt16();
-	sect.ceilingz = fr.ReadInt32();
-	sect.floorz = fr.ReadInt32();
-	sect.ceilingstat = fr.ReadUInt16();
-	sect.floorstat = fr.ReadUInt16();
-	sect.ceilingpicnum = fr.ReadUInt16();
-	sect.ceilingheinum = fr.ReadInt16();
-	sect.ceilingshade = fr.ReadInt8();
-	sect.ceilingpal = fr.ReadUInt8();
-	sect.ceilingxpan_ = fr.ReadUInt8();
-	sect.ceilingypan_ = fr.ReadUInt8();
-	sect.floorpicnum = fr.ReadUInt16();
-	sect.floorheinum = fr.ReadInt16();
-	sect.floorshade = fr.ReadInt8();
-	sect.floorpal = fr.ReadUInt8();
-	sect.floorxpan_ = fr.ReadUInt8();
-	sect.floorypan_ = fr.ReadUInt8();
-	sect.visibility = fr.ReadUInt8();
-	sect.fogpal = fr.ReadUInt8(); // note: currently unused, except for Blood.
-	sect.lotag = fr.ReadInt16();
-	sect.hitag = fr.ReadInt16();
-	sect.extra = fr.ReadInt16();
+	int16_t value;
+	memcpy(&value, GetMapRecords<uint8_t>(buffer, pos, sizeof(value)), sizeof(value));
+	return LittleShort(value);
 }
 
-static void ReadSectorV6(FileReader& fr, sectortype& sect)
+static int ReadMapInt32(TArray<uint8_t>& buffer, unsigned& pos)
 {
-	sect.wallptr = fr.ReadUInt16();
-	sect.wallnum = fr.ReadUInt16();
-	sect.ceilingpicnum = fr.ReadUInt16();
-	sect.floorpicnum = fr.ReadUInt16();
-	sect.ceilingheinum = clamp(fr.ReadInt16() << 5, -32768, 32767);
-	sect.floorheinum = clamp(fr.ReadInt16() << 5, -32768, 32767);
-	sect.ceilingz = fr.ReadInt32();
-	sect.floorz = fr.ReadInt32();
-	sect.ceilingshade = fr.ReadInt8();
-	sect.floorshade = fr.ReadInt8();
-	sect.ceilingxpan_ = fr.ReadUInt8();
-	sect.floorxpan_ = fr.ReadUInt8();
-	sect.ceilingypan_ = fr.ReadUInt8();
-	sect.floorypan_ = fr.ReadUInt8();
-	sect.ceilingstat = fr.ReadUInt8();
-	sect.floorstat = fr.ReadUInt8();
-	sect.ceilingpal = fr.ReadUInt8();
-	sect.floorpal = fr.ReadUInt8();
-	sect.visibility = fr.ReadUInt8();
-	sect.lotag = fr.ReadInt16();
-	sect.hitag = fr.ReadInt16();
-	sect.extra = fr.ReadInt16();
+	int32_t value;
+	memcpy(&value, GetMapRecords<uint8_t>(buffer, pos, sizeof(value)), sizeof(value));
+	return LittleLong(value);
 }
 
+//==========================================================================
+//
+//
+//
+//==========================================================================
 
-static void ReadSectorV5(FileReader& fr, sectortype& sect)
+static void DecodeSectorsV7(const sectortypev7* rec, int count)
 {
-	sect.wallptr = fr.ReadInt16();
-	sect.wallnum = fr.ReadInt16();
-	sect.ceilingpicnum = fr.ReadUInt16();
-	sect.floorpicnum = fr.ReadUInt16();
-	sect.ceilingheinum = clamp(fr.ReadInt16() << 5, -32768, 32767);
-	sect.floorheinum = clamp(fr.ReadInt16() << 5, -32768, 32767);
-	sect.ceilingz = fr.ReadInt32();
-	sect.floorz = fr.ReadInt32();
-	sect.ceilingshade = fr.ReadInt8();
-	sect.floorshade = fr.ReadInt8();
-	sect.ceilingxpan_ = fr.ReadUInt8();
-	sect.floorxpan_ = fr.ReadUInt8();
-	sect.ceilingypan_ = fr.ReadUInt8();
-	sect.floorypan_ = fr.ReadUInt8();
-	sect.ceilingstat = fr.ReadUInt8();
-	sect.floorstat = fr.ReadUInt8();
-	sect.ceilingpal = fr.ReadUInt8();
-	sect.floorpal = fr.ReadUInt8();
-	sect.visibility = fr.ReadUInt8();
-	sect.lotag = fr.ReadInt16();
-	sect.hitag = fr.ReadInt16();
-	sect.extra = fr.ReadInt16();
-	if ((sect.ceilingstat & 2) == 0) sect.ceilingheinum = 0;
-	if ((sect.floorstat & 2) == 0) sect.floorheinum = 0;
+	for (int i = 0; i < count; i++, rec++)
+	{
+		auto& sect = sector[i];
+		sect.wallptr = LittleShort(rec->wallptr);
+		sect.wallnum = LittleShort(rec->wallnum);
+		sect.ceilingz = LittleLong(rec->ceilingz);
+		sect.floorz = LittleLong(rec->floorz);
+		sect.ceilingstat = LittleShort(rec->ceilingstat);
+		sect.floorstat = LittleShort(rec->floorstat);
+		sect.ceilingpicnum = LittleShort(rec->ceilingpicnum);
+		sect.ceilingheinum = LittleShort(rec->ceilingheinum);
+		sect.ceilingshade = rec->ceilingshade;
+		sect.ceilingpal = rec->ceilingpal;
+		sect.ceilingxpan_ = rec->ceilingxpan;
+		sect.ceilingypan_ = rec->ceilingypan;
+		sect.floorpicnum = LittleShort(rec->floorpicnum);
+		sect.floorheinum = LittleShort(rec->floorheinum);
+		sect.floorshade = rec->floorshade;
+		sect.floorpal = rec->floorpal;
+		sect.floorxpan_ = rec->floorxpan;
+		sect.floorypan_ = rec->floorypan;
+		sect.visibility = rec->visibility;
+		sect.fogpal = rec->fogpal; // note: currently unused, except for Blood.
+		sect.lotag = LittleShort(rec->lotag);
+		sect.hitag = LittleShort(rec->hitag);
+		sect.extra = LittleShort(rec->extra);
+	}
+}
+
+static void DecodeSectorsV6(const sectortypev6* rec, int count, bool v5)
+{
+	for (int i = 0; i < count; i++, rec++)
+	{
+		auto& sect = sector[i];
+		sect.wallptr = LittleShort(rec->wallptr);
+		sect.wallnum = LittleShort(rec->wallnum);
+		sect.ceilingpicnum = LittleShort(rec->ceilingpicnum);
+		sect.floorpicnum = LittleShort(rec->floorpicnum);
+		sect.ceilingheinum = clamp(LittleShort(rec->ceilingheinum) << 5, -32768, 32767);
+		sect.floorheinum = clamp(LittleShort(rec->floorheinum) << 5, -32768, 32767);
+		sect.ceilingz = LittleLong(rec->ceilingz);
+		sect.floorz = LittleLong(rec->floorz);
+		sect.ceilingshade = rec->ceilingshade;
+		sect.floorshade = rec->floorshade;
+		sect.ceilingxpan_ = rec->ceilingxpan;
+		sect.floorxpan_ = rec->floorxpan;
+		sect.ceilingypan_ = rec->ceilingypan;
+		sect.floorypan_ = rec->floorypan;
+		sect.ceilingstat = rec->ceilingstat;
+		sect.floorstat = rec->floorstat;
+		sect.ceilingpal = rec->ceilingpal;
+		sect.floorpal = rec->floorpal;
+		sect.visibility = rec->visibility;
+		sect.lotag = LittleShort(rec->lotag);
+		sect.hitag = LittleShort(rec->hitag);
+		sect.extra = LittleShort(rec->extra);
+		if (v5)
+		{
+			if ((sect.ceilingstat & 2) == 0) sect.ceilingheinum = 0;
+			if ((sect.floorstat & 2) == 0) sect.floorheinum = 0;
+		}
+	}
 }
 
-static void ReadWallV7(FileReader& fr, walltype& wall)
+static void DecodeWallsV7(const walltypev7* rec, int count)
 {
-	wall.pos.x = fr.ReadInt32();
-	wall.pos.y = fr.ReadInt32();
-	wall.point2 = fr.ReadInt16();
-	wall.nextwall = fr.ReadInt16();
-	wall.nextsector = fr.ReadInt16();
-	wall.cstat = fr.ReadUInt16();
-	wall.picnum = fr.ReadInt16();
-	wall.overpicnum = fr.ReadInt16();
-	wall.shade = fr.ReadInt8();
-	wall.pal = fr.ReadUInt8();
-	wall.xrepeat = fr.ReadUInt8();
-	wall.yrepeat = fr.ReadUInt8();
-	wall.xpan_ = fr.ReadUInt8();
-	wall.ypan_ = fr.ReadUInt8();
-	wall.lotag = fr.ReadInt16();
-	wall.hitag = fr.ReadInt16();
-	wall.extra = fr.ReadInt16();
+	for (int i = 0; i < count; i++, rec++)
+	{
+		auto& wal = wall[i];
+		wal.pos.x = LittleLong(rec->x);
+		wal.pos.y = LittleLong(rec->y);
+		wal.point2 = LittleShort(rec->point2);
+		wal.nextwall = LittleShort(rec->nextwall);
+		wal.nextsector = LittleShort(rec->nextsector);
+		wal.cstat = LittleShort(rec->cstat);
+		wal.picnum = LittleShort(rec->picnum);
+		wal.overpicnum = LittleShort(rec->overpicnum);
+		wal.shade = rec->shade;
+		wal.pal = rec->pal;
+		wal.xrepeat = rec->xrepeat;
+		wal.yrepeat = rec->yrepeat;
+		wal.xpan_ = rec->xpan;
+		wal.ypan_ = rec->ypan;
+		wal.lotag = LittleShort(rec->lotag);
+		wal.hitag = LittleShort(rec->hitag);
+		wal.extra = LittleShort(rec->extra);
+	}
 }
 
-static void ReadWallV6(FileReader& fr, walltype& wall)
+static void DecodeWallsV6(const walltypev6* rec, int count)
 {
-	wall.pos.x = fr.ReadInt32();
-	wall.pos.y = fr.ReadInt32();
-	wall.point2 = fr.ReadInt16();
-	wall.nextsector = fr.ReadInt16();
-	wall.nextwall = fr.ReadInt16();
-	wall.picnum = fr.ReadInt16();
-	wall.overpicnum = fr.ReadInt16();
-	wall.shade = fr.ReadInt8();
-	wall.pal = fr.ReadUInt8();
-	wall.cstat = fr.ReadUInt16();
-	wall.xrepeat = fr.ReadUInt8();
-	wall.yrepeat = fr.ReadUInt8();
-	wall.xpan_ = fr.ReadUInt8();
-	wall.ypan_ = fr.ReadUInt8();
-	wall.lotag = fr.ReadInt16();
-	wall.hitag = fr.ReadInt16();
-	wall.extra = fr.ReadInt16();
+	for (int i = 0; i < count; i++, rec++)
+	{
+		auto& wal = wall[i];
+		wal.pos.x = LittleLong(rec->x);
+		wal.pos.y = LittleLong(rec->y);
+		wal.point2 = LittleShort(rec->point2);
+		wal.nextsector = LittleShort(rec->nextsector);
+		wal.nextwall = LittleShort(rec->nextwall);
+		wal.picnum = LittleShort(rec->picnum);
+		wal.overpicnum = LittleShort(rec->overpicnum);
+		wal.shade = rec->shade;
+		wal.pal = rec->pal;
+		wal.cstat = LittleShort(rec->cstat);
+		wal.xrepeat = rec->xrepeat;
+		wal.yrepeat = rec->yrepeat;
+		wal.xpan_ = rec->xpan;
+		wal.ypan_ = rec->ypan;
+		wal.lotag = LittleShort(rec->lotag);
+		wal.hitag = LittleShort(rec->hitag);
+		wal.extra = LittleShort(rec->extra);
+	}
 }
 
-static void ReadWallV5(FileReader& fr, walltype& wall)
+static void DecodeWallsV5(const walltypev5* rec, int count)
 {
-	wall.pos.x = fr.ReadInt32();
-	wall.pos.y = fr.ReadInt32();
-	wall.point2 = fr.ReadInt16();
-	wall.picnum = fr.ReadInt16();
-	wall.overpicnum = fr.ReadInt16();
-	wall.shade = fr.ReadInt8();
-	wall.cstat = fr.ReadUInt16();
-	wall.xrepeat = fr.ReadUInt8();
-	wall.yrepeat = fr.ReadUInt8();
-	wall.xpan_ = fr.ReadUInt8();
-	wall.ypan_ = fr.ReadUInt8();
-
-	wall.nextsector = fr.ReadInt16();
-	wall.nextwall = fr.ReadInt16();
-	fr.Seek(4, FileReader::SeekSet); // skip over 2 unused 16 bit values
-
-	wall.lotag = fr.ReadInt16();
-	wall.hitag = fr.ReadInt16();
-	wall.extra = fr.ReadInt16();
+	for (int i = 0; i < count; i++, rec++)
+	{
+		auto& wal = wall[i];
+		wal.pos.x = LittleLong(rec->x);
+		wal.pos.y = LittleLong(rec->y);
+		wal.point2 = LittleShort(rec->point2);
+		wal.picnum = LittleShort(rec->picnum);
+		wal.overpicnum = LittleShort(rec->overpicnum);
+		wal.shade = rec->shade;
+		wal.cstat = LittleShort(rec->cstat);
+		wal.xrepeat = rec->xrepeat;
+		wal.yrepeat = rec->yrepeat;
+		wal.xpan_ = rec->xpan;
+		wal.ypan_ = rec->ypan;
+		wal.nextsector = LittleShort(rec->nextsector);
+		wal.nextwall = LittleShort(rec->nextwall);
+		wal.lotag = LittleShort(rec->lotag);
+		wal.hitag = LittleShort(rec->hitag);
+		wal.extra = LittleShort(rec->extra);
+	}
 }
 
 static void SetWallPalV5()
@@ -238,97 +389,109 @@ static void ValidateSprite(spritetype& spr)
 	}
 }
 
-static void ReadSpriteV7(FileReader& fr, spritetype& spr)
+static void DecodeSpritesV7(const spritetypev7* rec, int count)
 {
-	spr.pos.x = fr.ReadInt32();
-	spr.pos.y = fr.ReadInt32();
-	spr.pos.z = fr.ReadInt32();
-	spr.cstat = fr.ReadUInt16();
-	spr.picnum = fr.ReadInt16();
-	spr.shade = fr.ReadInt8();
-	spr.pal = fr.ReadUInt8();
-	spr.clipdist = fr.ReadUInt8();
-	spr.blend = fr.ReadUInt8();
-	spr.xrepeat = fr.ReadUInt8();
-	spr.yrepeat = fr.ReadUInt8();
-	spr.xoffset = fr.ReadInt8();
-	spr.yoffset = fr.ReadInt8();
-	spr.sectnum = fr.ReadInt16();
-	spr.statnum = fr.ReadInt16();
-	spr.ang = fr.ReadInt16();
-	spr.owner = fr.ReadInt16();
-	spr.xvel = fr.ReadInt16();
-	spr.yvel = fr.ReadInt16();
-	spr.zvel = fr.ReadInt16();
-	spr.lotag = fr.ReadInt16();
-	spr.hitag = fr.ReadInt16();
-	spr.extra = fr.ReadInt16();
-	spr.detail = 0;
-	ValidateSprite(spr);
+	for (int i = 0; i < count; i++, rec++)
+	{
+		auto& spr = sprite[i];
+		spr.pos.x = LittleLong(rec->x);
+		spr.pos.y = LittleLong(rec->y);
+		spr.pos.z = LittleLong(rec->z);
+		spr.cstat = LittleShort(rec->cstat);
+		spr.picnum = LittleShort(rec->picnum);
+		spr.shade = rec->shade;
+		spr.pal = rec->pal;
+		spr.clipdist = rec->clipdist;
+		spr.blend = rec->blend;
+		spr.xrepeat = rec->xrepeat;
+		spr.yrepeat = rec->yrepeat;
+		spr.xoffset = rec->xoffset;
+		spr.yoffset = rec->yoffset;
+		spr.sectnum = LittleShort(rec->sectnum);
+		spr.statnum = LittleShort(rec->statnum);
+		spr.ang = LittleShort(rec->ang);
+		spr.owner = LittleShort(rec->owner);
+		spr.xvel = LittleShort(rec->xvel);
+		spr.yvel = LittleShort(rec->yvel);
+		spr.zvel = LittleShort(rec->zvel);
+		spr.lotag = LittleShort(rec->lotag);
+		spr.hitag = LittleShort(rec->hitag);
+		spr.extra = LittleShort(rec->extra);
+		spr.detail = 0;
+		ValidateSprite(spr);
+	}
 }
 
-static void ReadSpriteV6(FileReader& fr, spritetype& spr)
+static void DecodeSpritesV6(const spritetypev6* rec, int count)
 {
-	spr.pos.x = fr.ReadInt32();
-	spr.pos.y = fr.ReadInt32();
-	spr.pos.z = fr.ReadInt32();
-	spr.cstat = fr.ReadUInt16();
-	spr.shade = fr.ReadInt8();
-	spr.pal = fr.ReadUInt8();
-	spr.clipdist = fr.ReadUInt8();
-	spr.xrepeat = fr.ReadUInt8();
-	spr.yrepeat = fr.ReadUInt8();
-	spr.xoffset = fr.ReadInt8();
-	spr.yoffset = fr.ReadInt8();
-	spr.picnum = fr.ReadInt16();
-	spr.ang = fr.ReadInt16();
-	spr.xvel = fr.ReadInt16();
-	spr.yvel = fr.ReadInt16();
-	spr.zvel = fr.ReadInt16();
-	spr.owner = fr.ReadInt16();
-	spr.sectnum = fr.ReadInt16();
-	spr.statnum = fr.ReadInt16();
-	spr.lotag = fr.ReadInt16();
-	spr.hitag = fr.ReadInt16();
-	spr.extra = fr.ReadInt16();
-	spr.blend = 0;
-	spr.detail = 0;
-	ValidateSprite(spr);
+	for (int i = 0; i < count; i++, rec++)
+	{
+		auto& spr = sprite[i];
+		spr.pos.x = LittleLong(rec->x);
+		spr.pos.y = LittleLong(rec->y);
+		spr.pos.z = LittleLong(rec->z);
+		spr.cstat = LittleShort(rec->cstat);
+		spr.shade = rec->shade;
+		spr.pal = rec->pal;
+		spr.clipdist = rec->clipdist;
+		spr.xrepeat = rec->xrepeat;
+		spr.yrepeat = rec->yrepeat;
+		spr.xoffset = rec->xoffset;
+		spr.yoffset = rec->yoffset;
+		spr.picnum = LittleShort(rec->picnum);
+		spr.ang = LittleShort(rec->ang);
+		spr.xvel = LittleShort(rec->xvel);
+		spr.yvel = LittleShort(rec->yvel);
+		spr.zvel = LittleShort(rec->zvel);
+		spr.owner = LittleShort(rec->owner);
+		spr.sectnum = LittleShort(rec->sectnum);
+		spr.statnum = LittleShort(rec->statnum);
+		spr.lotag = LittleShort(rec->lotag);
+		spr.hitag = LittleShort(rec->hitag);
+		spr.extra = LittleShort(rec->extra);
+		spr.blend = 0;
+		spr.detail = 0;
+		ValidateSprite(spr);
+	}
 }
 
-static void ReadSpriteV5(FileReader& fr, spritetype& spr)
+static void DecodeSpritesV5(const spritetypev5* rec, int count)
 {
-	spr.pos.x = fr.ReadInt32();
-	spr.pos.y = fr.ReadInt32();
-	spr.pos.z = fr.ReadInt32();
-	spr.cstat = fr.ReadUInt16();
-	spr.shade = fr.ReadInt8();
-	spr.xrepeat = fr.ReadUInt8();
-	spr.yrepeat = fr.ReadUInt8();
-	spr.picnum = fr.ReadInt16();
-	spr.ang = fr.ReadInt16();
-	spr.xvel = fr.ReadInt16();
-	spr.yvel = fr.ReadInt16();
-	spr.zvel = fr.ReadInt16();
-	spr.owner = fr.ReadInt16();
-	spr.sectnum = fr.ReadInt16();
-	spr.statnum = fr.ReadInt16();
-	spr.lotag = fr.ReadInt16();
-	spr.hitag = fr.ReadInt16();
-	spr.extra = fr.ReadInt16();
-
-	int sec = spr.sectnum;
-	if ((sector[sec].ceilingstat & 1) > 0)
-		spr.pal = sector[sec].ceilingpal;
-	else
-		spr.pal = sector[sec].floorpal;
-
-	spr.blend = 0;
-	spr.clipdist = 32;
-	spr.xoffset = 0;
-	spr.yoffset = 0;
-	spr.detail = 0;
-	ValidateSprite(spr);
+	for (int i = 0; i < count; i++, rec++)
+	{
+		auto& spr = sprite[i];
+		spr.pos.x = LittleLong(rec->x);
+		spr.pos.y = LittleLong(rec->y);
+		spr.pos.z = LittleLong(rec->z);
+		spr.cstat = LittleShort(rec->cstat);
+		spr.shade = rec->shade;
+		spr.xrepeat = rec->xrepeat;
+		spr.yrepeat = rec->yrepeat;
+		spr.picnum = LittleShort(rec->picnum);
+		spr.ang = LittleShort(rec->ang);
+		spr.xvel = LittleShort(rec->xvel);
+		spr.yvel = LittleShort(rec->yvel);
+		spr.zvel = LittleShort(rec->zvel);
+		spr.owner = LittleShort(rec->owner);
+		spr.sectnum = LittleShort(rec->sectnum);
+		spr.statnum = LittleShort(rec->statnum);
+		spr.lotag = LittleShort(rec->lotag);
+		spr.hitag = LittleShort(rec->hitag);
+		spr.extra = LittleShort(rec->extra);
+
+		int sec = spr.sectnum;
+		if ((sector[sec].ceilingstat & 1) > 0)
+			spr.pal = sector[sec].ceilingpal;
+		else
+			spr.pal = sector[sec].floorpal;
+
+		spr.blend = 0;
+		spr.clipdist = 32;
+		spr.xoffset = 0;
+		spr.yoffset = 0;
+		spr.detail = 0;
+		ValidateSprite(spr);
+	}
 }
 
 
@@ -376,13 +539,21 @@ void addBlockingPairs();
 void engineLoadBoard(const char* filename, int flags, vec3_t* pos, int16_t* ang, int16_t* cursectnum)
 {
 	inputState.ClearAllInput();
-	memset(sector, 0, sizeof(*sector) * MAXSECTORS);
-	memset(wall, 0, sizeof(*wall) * MAXWALLS);
-	memset(sprite, 0, sizeof(*sector) * MAXSPRITES);
+	clearMapArrays();
+	memset(sprite, 0, sizeof(*sprite) * MAXSPRITES);
+	sectorGrid.Clear();
 
+	uint64_t starttime = I_nsTime();
 	FileReader fr = fileSystem.OpenFileReader(filename);
 	if (!fr.isOpen()) I_Error("Unable to open map %s", filename);
-	int mapversion = fr.ReadInt32();
+
+	// Read the map once. The records get decoded and the hash calculated from this buffer.
+	auto buffer = fr.Read();
+	unsigned char md4[16];
+	md4once(buffer.Data(), buffer.Size(), md4);
+	unsigned offset = 0;
+
+	int mapversion = ReadMapInt32(buffer, offset);
 	if (mapversion < 5 || mapversion > 9) // 9 is most likely useless but let's try anyway.
 	{
 		I_Error("%s: Invalid map format, expcted 5-9, got %d", filename, mapversion);
@@ -394,47 +565,39 @@ void engineLoadBoard(const char* filename, int flags, vec3_t* pos, int16_t* ang,
 	ClearAutomap();
 	Polymost::Polymost_prepare_loadboard();
 
-	pos->x = fr.ReadInt32();
-	pos->y = fr.ReadInt32();
-	pos->z = fr.ReadInt32();
-	*ang = fr.ReadInt16() & 2047;
-	*cursectnum = fr.ReadUInt16();
+	pos->x = ReadMapInt32(buffer, offset);
+	pos->y = ReadMapInt32(buffer, offset);
+	pos->z = ReadMapInt32(buffer, offset);
+	*ang = ReadMapInt16(buffer, offset) & 2047;
+	*cursectnum = (uint16_t)ReadMapInt16(buffer, offset);
 
-	numsectors = fr.ReadUInt16();
+	numsectors = (uint16_t)ReadMapInt16(buffer, offset);
 	if ((unsigned)numsectors > MAXSECTORS) I_Error("%s: Invalid map, too many sectors", filename);
-	for (int i = 0; i < numsectors; i++)
+	switch (mapversion)
 	{
-		switch (mapversion)
-		{
-		case 5: ReadSectorV5(fr, sector[i]); break;
-		case 6: ReadSectorV6(fr, sector[i]); break;
-		default: ReadSectorV7(fr, sector[i]); break;
-		}
+	case 5: DecodeSectorsV6(GetMapRecords<sectortypev6>(buffer, offset, numsectors), numsectors, true); break;
+	case 6: DecodeSectorsV6(GetMapRecords<sectortypev6>(buffer, offset, numsectors), numsectors, false); break;
+	default: DecodeSectorsV7(GetMapRecords<sectortypev7>(buffer, offset, numsectors), numsectors); break;
 	}
 
-	numwalls = fr.ReadUInt16();
+	numwalls = (uint16_t)ReadMapInt16(buffer, offset);
 	if ((unsigned)numwalls > MAXWALLS) I_Error("%s: Invalid map, too many walls", filename);
-	for (int i = 0; i < numwalls; i++)
+	switch (mapversion)
 	{
-		switch (mapversion)
-		{
-		case 5: ReadWallV5(fr, wall[i]); break;
-		case 6: ReadWallV6(fr, wall[i]); break;
-		default: ReadWallV7(fr, wall[i]); break;
-		}
+	case 5: DecodeWallsV5(GetMapRecords<walltypev5>(buffer, offset, numwalls), numwalls); break;
+	case 6: DecodeWallsV6(GetMapRecords<walltypev6>(buffer, offset, numwalls), numwalls); break;
+	default: DecodeWallsV7(GetMapRecords<walltypev7>(buffer, offset, numwalls), numwalls); break;
 	}
 
-	int numsprites = fr.ReadUInt16();
+	int numsprites = (uint16_t)ReadMapInt16(buffer, offset);
 	if ((unsigned)numsprites > MAXSPRITES) I_Error("%s: Invalid map, too many sprites", filename);
-	for (int i = 0; i < numsprites; i++)
+	switch (mapversion)
 	{
-		switch (mapversion)
-		{
-		case 5: ReadSpriteV5(fr, sprite[i]); break;
-		case 6: ReadSpriteV6(fr, sprite[i]); break;
-		default: ReadSpriteV7(fr, sprite[i]); break;
-		}
+	case 5: DecodeSpritesV5(GetMapRecords<spritetypev5>(buffer, offset, numsprites), numsprites); break;
+	case 6: DecodeSpritesV6(GetMapRecords<spritetypev6>(buffer, offset, numsprites), numsprites); break;
+	default: DecodeSpritesV7(GetMapRecords<spritetypev7>(buffer, offset, numsprites), numsprites); break;
 	}
+	uint64_t decodetime = I_nsTime();
 
 	artSetupMapArt(filename);
 	insertAllSprites(filename, pos, cursectnum, numsprites);
@@ -446,18 +609,22 @@ void engineLoadBoard(const char* filename, int flags, vec3_t* pos, int16_t* ang,
 	//Must be last.
 	updatesector(pos->x, pos->y, cursectnum);
 	guniqhudid = 0;
-	fr.Seek(0, FileReader::SeekSet);
-	auto buffer = fr.Read();
-	unsigned char md4[16];
-	md4once(buffer.Data(), buffer.Size(), md4);
 	G_LoadMapHack(filename, md4);
 	setWallSectors();
+	uint64_t sectionstart = I_nsTime();
 	hw_BuildSections();
+	uint64_t sectiontime = I_nsTime() - sectionstart;
 	sectorGeometry.SetSize(numsections);
+	sectorGeometry.LoadCache(md4);
+	sectorGrid.Build();
+	levelAABBTree.Clear();
+
 
+	memcpy(wallbackup, wall, sizeof(*wall) * numwalls);
+	memcpy(sectorbackup, sector, sizeof(*sector) * numsectors);
 
-	memcpy(wallbackup, wall, sizeof(wallbackup));
-	memcpy(sectorbackup, sector, sizeof(sectorbackup));
+	DPrintf(DMSG_NOTIFY, "%s: v%d, %d sectors, %d walls, %d sprites. Read and decode %.2f ms, sections %.2f ms, total %.2f ms\n",
+		filename, mapversion, numsectors, numwalls, numsprites, (decodetime - starttime) / 1e6, sectiontime / 1e6, (I_nsTime() - starttime) / 1e6);
 }
 
 
@@ -0,0 +1,186 @@
+/*
+** mapstorage.cpp
+**
+** Storage for the map's sectors and walls
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 agent
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The sector and wall arrays reserve address space for the maximum map size
+** but memory only gets used for the pages a map actually writes to, so
+** the footprint grows with the map, in page sized steps.
+** Clearing the arrays returns all memory to the system instead of writing
+** zeros over the entire arrays.
+** All indices up to MAXSECTORS/MAXWALLS remain valid and read as zero
+** beyond the loaded map, just like the old static arrays did.
+**
+*/
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "build.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "gamestate.h"
+#include "hw_sections.h"
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+class FMapArray
+{
+	uint8_t* Memory = nullptr;
+	size_t Size = 0;
+	bool Mapped = true;
+
+public:
+	FMapArray(size_t elementsize, size_t count)
+	{
+		Size = elementsize * count;
+#ifdef _WIN32
+		// Committed pages do not use any memory until they are written to.
+		Memory = (uint8_t*)VirtualAlloc(nullptr, Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+		void* mem = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		Memory = mem == MAP_FAILED ? nullptr : (uint8_t*)mem;
+#endif
+		if (Memory == nullptr)
+		{
+			// Fall back to a regular allocation. This only loses the ability to give memory back.
+			Memory = (uint8_t*)M_Calloc(Size, 1);
+			Mapped = false;
+		}
+	}
+
+	template<class T> T* Data() const
+	{
+		return reinterpret_cast<T*>(Memory);
+	}
+
+	// Resets the array to all zeros and releases the memory backing it.
+	void Clear()
+	{
+		if (!Mapped)
+		{
+			memset(Memory, 0, Size);
+			return;
+		}
+#ifdef _WIN32
+		VirtualFree(Memory, Size, MEM_DECOMMIT);
+		VirtualAlloc(Memory, Size, MEM_COMMIT, PAGE_READWRITE);
+#else
+		madvise(Memory, Size, MADV_DONTNEED);
+#endif
+	}
+
+	// Bytes actually backed by memory, -1 if this cannot be determined.
+	long Resident() const
+	{
+#if !defined _WIN32 && defined __linux__
+		if (!Mapped) return -1;
+		long pagesize = sysconf(_SC_PAGESIZE);
+		size_t pages = (Size + pagesize - 1) / pagesize;
+		TArray<unsigned char> vec(pages, true);
+		if (mincore(Memory, Size, vec.Data()) != 0) return -1;
+		long resident = 0;
+		for (auto v : vec) if (v & 1) resident += pagesize;
+		return resident;
+#else
+		return -1;
+#endif
+	}
+};
+
+static FMapArray sectorStorage(sizeof(sectortype), MAXSECTORS);
+static FMapArray wallStorage(sizeof(walltype), MAXWALLS);
+static FMapArray sectorBackupStorage(sizeof(sectortype), MAXSECTORS);
+static FMapArray wallBackupStorage(sizeof(walltype), MAXWALLS);
+
+sectortype* sector = sectorStorage.Data<sectortype>();
+walltype* wall = wallStorage.Data<walltype>();
+sectortype* sectorbackup = sectorBackupStorage.Data<sectortype>();
+walltype* wallbackup = wallBackupStorage.Data<walltype>();
+
+//==========================================================================
+//
+// Must be called before loading a map and after unloading one.
+//
+//==========================================================================
+
+void clearMapArrays()
+{
+	sectorStorage.Clear();
+	wallStorage.Clear();
+	sectorBackupStorage.Clear();
+	wallBackupStorage.Clear();
+}
+
+//==========================================================================
+//
+// CCMD mapmemory
+//
+// Shows the memory used by the current map's data.
+//
+//==========================================================================
+
+static void PrintMapArray(const char* name, const FMapArray& array, int count, int max, size_t elementsize)
+{
+	long resident = array.Resident();
+	FString res = resident >= 0 ? FStringf("%7.1fk", resident / 1024.) : FString("     n/a");
+	Printf("%-14s %6d / %6d %8.1fk used, %s resident, %8.1fk reserved\n", name, count, max,
+		count * elementsize / 1024., res.GetChars(), max * elementsize / 1024.);
+}
+
+CCMD(mapmemory)
+{
+	if (gamestate != GS_LEVEL)
+	{
+		Printf("No map loaded\n");
+		return;
+	}
+	PrintMapArray("sectors", sectorStorage, numsectors, MAXSECTORS, sizeof(sectortype));
+	PrintMapArray("walls", wallStorage, numwalls, MAXWALLS, sizeof(walltype));
+	PrintMapArray("sector backup", sectorBackupStorage, numsectors, MAXSECTORS, sizeof(sectortype));
+	PrintMapArray("wall backup", wallBackupStorage, numwalls, MAXWALLS, sizeof(walltype));
+
+	// Sprites can be spawned at any time so these always use the full arrays.
+	size_t spritesize = sizeof(spritetype) + sizeof(spriteext_t) + sizeof(spritesmooth_t);
+	Printf("%-14s %6d / %6d %8.1fk used, %8.1fk static\n", "sprites", Numsprites, MAXSPRITES,
+		Numsprites * spritesize / 1024., MAXSPRITES * spritesize / 1024.);
+	Printf("%-14s %6d sections\n", "geometry", numsections);
+}
@@ -369,17 +369,19 @@ void LookupTableInfo::makeTable(int palnum, const uint8_t *remapbuf, int r, int
     {
         // colored fog case
 
+        PalEntry row[256];
         for (int i = 0; i < numshades; i++)
         {
             int colfac = (numshades - i);
             for (int j = 0; j < 256; j++)
             {
                 PalEntry pe = GPalette.BaseColors[remapbuf[j]];
-                p[256 * i + j] = ColorMatcher.Pick(
+                row[j] = PalEntry(
                     (pe.r * colfac + r * i) / numshades,
                     (pe.g * colfac + g * i) / numshades,
                     (pe.b * colfac + b * i) / numshades);
             }
+            ColorMatcher.PickBatch(row, (uint8_t*)&p[256 * i], 256);
         }
     }
 
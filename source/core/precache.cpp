@@ -43,11 +43,40 @@
 #include "hw_models.h"
 #include "hw_voxels.h"
 #include "mapinfo.h"
+#include "i_time.h"
+#include "printf.h"
+#include "c_cvars.h"
+#include <thread>
+#include <atomic>
 
 BEGIN_BLD_NS
 extern short voxelIndex[MAXTILES];
 END_BLD_NS
 
+CVAR(Bool, r_precache_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+EXTERN_CVAR(Int, gl_texture_hqresizemode)
+EXTERN_CVAR(Int, gl_texture_hqresizemult)
+
+// Upper limit for the upscaled images held in memory before they get uploaded.
+static const size_t UPSCALE_BATCH_BYTES = 128 << 20;
+
+struct PrecacheItem
+{
+	FMaterial* mat;
+	int translation;
+};
+
+struct UpscaleJob
+{
+	FTexture* tex;
+	int translation;
+	int flags;
+	bool hasAlpha;
+	FTextureBuffer buffer;
+};
+
+static TArray<PrecacheItem> precachelist;
+
 static void PrecacheTex(FGameTexture* tex, int palid)
 {
 	if (!tex || !tex->isValid()) return;
@@ -55,7 +84,109 @@ static void PrecacheTex(FGameTexture* tex, int palid)
 	if (shouldUpscale(tex, UF_Texture)) scaleflags |= CTF_Upscale;
 
 	auto mat = FMaterial::ValidateTexture(tex, scaleflags);
-	screen->PrecacheMaterial(mat, palid);
+	precachelist.Push({ mat, palid });
+}
+
+//==========================================================================
+//
+// Upscaling is the most expensive part of creating a texture so this
+// gets done for many precached textures at once on as many threads as are
+// available. Reading and translating the image stays on the main thread
+// because the image sources and the file system are not thread safe.
+// Uploading to the GPU afterward picks up the prepared buffers.
+//
+// The materials are processed in batches, each one taking as many as fit
+// into UPSCALE_BATCH_BYTES after upscaling, so that the memory in use
+// does not grow with the number of textures in the map.
+// Returns the index of the first material for the next batch.
+//
+//==========================================================================
+
+static unsigned PrepareUpscaleJobs(TArray<UpscaleJob>& jobs, unsigned first)
+{
+	size_t mult = clamp<int>(gl_texture_hqresizemult, 1, 6);
+	size_t batchsize = 0;
+	unsigned index = first;
+	for (; index < precachelist.Size() && batchsize < UPSCALE_BATCH_BYTES; index++)
+	{
+		auto& item = precachelist[index];
+		auto mat = item.mat;
+		if (mat->Source()->GetUseType() == ETextureType::SWCanvas || (mat->GetScaleFlags() & CTF_Indexed)) continue;
+
+		auto& layers = mat->GetLayerArray();
+		for (unsigned i = 0; i < layers.Size(); i++)
+		{
+			auto tex = layers[i].layerTexture;
+			int translation = i == 0 ? item.translation : 0;
+			int flags = layers[i].scaleFlags | CTF_ProcessData;
+			if (tex == nullptr || tex->SystemTextures.GetHardwareTexture(translation, layers[i].scaleFlags)) continue;
+			if (jobs.FindEx([=](auto& job) { return job.tex == tex && job.translation == translation && job.flags == flags; }) < jobs.Size()) continue;
+
+			auto& job = jobs[jobs.Reserve(1)];
+			if (tex->PrepareTexBuffer(job.buffer, translation, flags, &job.hasAlpha))
+			{
+				job.tex = tex;
+				job.translation = translation;
+				job.flags = flags;
+				batchsize += size_t(job.buffer.mWidth) * job.buffer.mHeight * 4 * mult * mult;
+			}
+			else jobs.Pop();
+		}
+	}
+	return index;
+}
+
+static void RunUpscaleJobs(TArray<UpscaleJob>& jobs)
+{
+	std::atomic<unsigned> next(0);
+	auto worker = [&]()
+	{
+		unsigned i;
+		while ((i = next++) < jobs.Size())
+		{
+			jobs[i].tex->CreateUpsampledTextureBuffer(jobs[i].buffer, jobs[i].hasAlpha, false);
+		}
+	};
+
+	// The MMX version of hqNx is not thread safe.
+	unsigned numthreads = 0;
+	if (r_precache_multithread && gl_texture_hqresizemode != 3)
+	{
+		numthreads = std::min<unsigned>(std::max(std::thread::hardware_concurrency(), 1u) - 1, jobs.Size());
+	}
+	std::vector<std::thread> threads;
+	for (unsigned i = 0; i < numthreads; i++) threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads) thread.join();
+
+	for (auto& job : jobs) job.tex->StorePrecachedBuffer(job.translation, job.flags, std::move(job.buffer));
+}
+
+static void PrecacheMaterials()
+{
+	uint64_t start = I_msTime();
+	unsigned upscaled = 0;
+	TArray<UpscaleJob> jobs;
+
+	for (unsigned first = 0; first < precachelist.Size(); )
+	{
+		unsigned next = PrepareUpscaleJobs(jobs, first);
+		RunUpscaleJobs(jobs);
+
+		for (unsigned i = first; i < next; i++)
+		{
+			screen->PrecacheMaterial(precachelist[i].mat, precachelist[i].translation);
+		}
+
+		// Anything the backend did not pick up must not linger around.
+		for (auto& job : jobs) job.tex->ClearPrecachedBuffers();
+		upscaled += jobs.Size();
+		jobs.Clear();
+		first = next;
+	}
+	FlushUpscaleCache();
+	DPrintf(DMSG_NOTIFY, "Precached %u materials, %u upscaled, in %llu ms\n", precachelist.Size(), upscaled, (unsigned long long)(I_msTime() - start));
+	precachelist.Clear();
 }
 
 static void doprecache(int picnum, int palette)
@@ -144,6 +275,7 @@ void precacheMarkedTiles()
 		if (tex) PrecacheTex(tex, 0);
 	}
 
+	PrecacheMaterials();
 	cachemap.Clear();
 }
 
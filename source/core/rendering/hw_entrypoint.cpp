@@ -51,6 +51,8 @@
 #include "render.h"
 #include "gamestruct.h"
 #include "gamehud.h"
+#include "sectorgeometry.h"
+#include "hw_levelaabbtree.h"
 
 EXTERN_CVAR(Bool, cl_capfps)
 
@@ -91,6 +93,25 @@ void CollectLights(FLevelLocals* Level)
 }
 #endif
 
+static TArray<ShadowLight> shadowLights;
+
+static void CollectShadowmapLights()
+{
+	IShadowMap* sm = &screen->mShadowMap;
+	unsigned lightindex = 0;
+
+	for (; lightindex < shadowLights.Size() && lightindex < 1024; lightindex++)
+	{
+		auto& light = shadowLights[lightindex];
+		sm->SetLight(lightindex, light.x, light.y, light.z, light.radius);
+	}
+
+	for (; lightindex < 1024; lightindex++)
+	{
+		sm->SetLight(lightindex, 0, 0, 0, 0);
+	}
+}
+
 
 //-----------------------------------------------------------------------------
 //
@@ -102,16 +123,27 @@ void RenderViewpoint(FRenderViewpoint& mainvp, IntRect* bounds, float fov, float
 {
 	auto& RenderState = *screen->RenderState();
 
-	/*
-	if (mainview && toscreen)
+	if (mainview && toscreen && gl_light_shadowmap)
 	{
-		screen->SetAABBTree(camera->Level->aabbTree);
-		screen->mShadowMap.SetCollectLights([=] {
-			CollectLights(camera->Level);
-		});
-		screen->UpdateShadowMap();
+		// Without any shadow casting lights there is nothing to do, not even keeping the tree up to date.
+		// No game reports any yet: walls, flats and sprites do not apply dynamic lights, so nothing
+		// would read the shadow map.
+		shadowLights.Clear();
+		gi->GetShadowLights(shadowLights);
+	}
+	if (mainview && toscreen && gl_light_shadowmap && shadowLights.Size() > 0)
+	{
+		// a new tree must always be uploaded in full, even if it got allocated at the same address.
+		if (levelAABBTree.Validate()) screen->SetAABBTree(nullptr);
+		if (levelAABBTree.NodesCount() > 0)
+		{
+			screen->SetAABBTree(&levelAABBTree);
+			screen->mShadowMap.SetCollectLights([=] {
+				CollectShadowmapLights();
+			});
+			screen->UpdateShadowMap();
+		}
 	}
-	*/
 
 	// Render (potentially) multiple views for stereo 3d
 	// Fixme. The view offsetting should be done with a static table and not require setup of the entire render state for the mode.
@@ -324,6 +356,9 @@ void render_drawrooms(spritetype* playersprite, const vec3_t& position, int sect
 	// reset statistics counters
 	ResetProfilingData();
 
+	// do all the expensive triangulation work for this frame up front.
+	sectorGeometry.TriangulateDirty();
+
 	// Get this before everything else
 	FRenderViewpoint r_viewpoint = SetupViewpoint(playersprite, position, sectnum, angle, horizon, rollang);
 	if (cl_capfps) r_viewpoint.TicFrac = 1.;
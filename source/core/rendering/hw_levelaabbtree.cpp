@@ -0,0 +1,350 @@
+/*
+** hw_levelaabbtree.cpp
+**
+** AABB tree over the solid walls of a Build map
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 agent
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "hw_levelaabbtree.h"
+#include "build.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "stats.h"
+
+using namespace hwrenderer;
+
+BuildAABBTree levelAABBTree;
+
+//==========================================================================
+//
+// Tree lines are in renderer coordinates, i.e. map units / 16 with Y pointing up.
+//
+//==========================================================================
+
+static AABBTreeLine MakeLine(int wallnum)
+{
+	auto wal = &wall[wallnum];
+	auto wal2 = &wall[wal->point2];
+	AABBTreeLine line;
+	line.x = wal->x * (1 / 16.f);
+	line.y = wal->y * (1 / -16.f);
+	line.dx = wal2->x * (1 / 16.f) - line.x;
+	line.dy = wal2->y * (1 / -16.f) - line.y;
+	return line;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void BuildAABBTree::Clear()
+{
+	nodes.Clear();
+	treelines.Clear();
+	parents.Clear();
+	leafs.Clear();
+	walls.Clear();
+	dynamicStartNode = dynamicStartLine = 0;
+	valid = false;
+}
+
+//==========================================================================
+//
+// Builds the tree if needed. Returns true if a new tree was created.
+//
+//==========================================================================
+
+bool BuildAABBTree::Validate()
+{
+	if (valid) return false;
+	Clear();
+	valid = true;
+
+	// Only one-sided walls block anything in 2D.
+	for (int i = 0; i < numwalls; i++)
+	{
+		if (wall[i].nextwall < 0)
+		{
+			walls.Push(i);
+			treelines.Push(MakeLine(i));
+		}
+	}
+	if (treelines.Size() == 0) return true;
+
+	TArray<FVector2> centroids(treelines.Size(), true);
+	TArray<int> lines(treelines.Size(), true);
+	for (unsigned i = 0; i < treelines.Size(); i++)
+	{
+		auto& line = treelines[i];
+		centroids[i] = { line.x + line.dx * 0.5f, line.y + line.dy * 0.5f };
+		lines[i] = i;
+	}
+
+	TArray<int> work_buffer(treelines.Size() * 2, true);
+	GenerateTreeNode(lines.Data(), lines.Size(), centroids.Data(), work_buffer.Data());
+
+	parents.Resize(nodes.Size());
+	leafs.Resize(treelines.Size());
+	parents.Last() = -1;
+	for (unsigned i = 0; i < nodes.Size(); i++)
+	{
+		auto& node = nodes[i];
+		if (node.line_index != -1) leafs[node.line_index] = i;
+		else parents[node.left_node] = parents[node.right_node] = i;
+	}
+
+	// Everything was just uploaded.
+	dynamicStartNode = nodes.Size();
+	dynamicStartLine = treelines.Size();
+	return true;
+}
+
+//==========================================================================
+//
+// Recursively splits the lines at the median of their centroids
+// along the longest axis. Children are always stored before their parent.
+//
+//==========================================================================
+
+int BuildAABBTree::GenerateTreeNode(int* lines, int num_lines, const FVector2* centroids, int* work_buffer)
+{
+	if (num_lines == 0)
+		return -1;
+
+	// Find bounding box and median of the lines
+	FVector2 median = { 0, 0 };
+	FVector2 aabb_min = { FLT_MAX, FLT_MAX };
+	FVector2 aabb_max = { -FLT_MAX, -FLT_MAX };
+	for (int i = 0; i < num_lines; i++)
+	{
+		auto& line = treelines[lines[i]];
+		float x2 = line.x + line.dx, y2 = line.y + line.dy;
+		aabb_min.X = min(aabb_min.X, min(line.x, x2));
+		aabb_min.Y = min(aabb_min.Y, min(line.y, y2));
+		aabb_max.X = max(aabb_max.X, max(line.x, x2));
+		aabb_max.Y = max(aabb_max.Y, max(line.y, y2));
+		median += centroids[lines[i]];
+	}
+	median /= float(num_lines);
+
+	if (num_lines == 1) // Leaf node
+	{
+		nodes.Push(AABBTreeNode(aabb_min, aabb_max, lines[0]));
+		return (int)nodes.Size() - 1;
+	}
+
+	// Try the longest axis first, then the other one.
+	int axis = (aabb_max.X - aabb_min.X) >= (aabb_max.Y - aabb_min.Y) ? 0 : 1;
+	int* left = work_buffer;
+	int* right = work_buffer + num_lines;
+	int left_count = 0, right_count = 0;
+	for (int attempt = 0; attempt < 2; attempt++, axis ^= 1)
+	{
+		left_count = right_count = 0;
+		for (int i = 0; i < num_lines; i++)
+		{
+			int line_index = lines[i];
+			float side = axis == 0 ? centroids[line_index].X - median.X : centroids[line_index].Y - median.Y;
+			if (side >= 0)
+				left[left_count++] = line_index;
+			else
+				right[right_count++] = line_index;
+		}
+		if (left_count != 0 && right_count != 0) break;
+	}
+
+	if (left_count == 0 || right_count == 0)
+	{
+		// All centroids are in the same spot. Just split the list in half.
+		left_count = num_lines / 2;
+		right_count = num_lines - left_count;
+	}
+	else
+	{
+		// Move the partitioned lines back so the work buffer is free for the children.
+		memcpy(lines, left, left_count * sizeof(int));
+		memcpy(lines + left_count, right, right_count * sizeof(int));
+	}
+
+	int left_node = GenerateTreeNode(lines, left_count, centroids, work_buffer);
+	int right_node = GenerateTreeNode(lines + left_count, right_count, centroids, work_buffer);
+
+	nodes.Push(AABBTreeNode(aabb_min, aabb_max, left_node, right_node));
+	return (int)nodes.Size() - 1;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void BuildAABBTree::RefitNode(int node)
+{
+	auto& n = nodes[node];
+	if (n.line_index != -1)
+	{
+		auto& line = treelines[n.line_index];
+		float x2 = line.x + line.dx, y2 = line.y + line.dy;
+		n.aabb_left = min(line.x, x2);
+		n.aabb_top = min(line.y, y2);
+		n.aabb_right = max(line.x, x2);
+		n.aabb_bottom = max(line.y, y2);
+	}
+	else
+	{
+		auto& l = nodes[n.left_node];
+		auto& r = nodes[n.right_node];
+		n.aabb_left = min(l.aabb_left, r.aabb_left);
+		n.aabb_top = min(l.aabb_top, r.aabb_top);
+		n.aabb_right = max(l.aabb_right, r.aabb_right);
+		n.aabb_bottom = max(l.aabb_bottom, r.aabb_bottom);
+	}
+}
+
+//==========================================================================
+//
+// Picks up all walls that were moved since the last call and refits
+// the tree. Returns true if anything needs to be uploaded again.
+//
+//==========================================================================
+
+bool BuildAABBTree::Update()
+{
+	int firstline = treelines.Size();
+	int firstnode = nodes.Size();
+
+	for (unsigned i = 0; i < treelines.Size(); i++)
+	{
+		auto line = MakeLine(walls[i]);
+		auto& old = treelines[i];
+		if (line.x == old.x && line.y == old.y && line.dx == old.dx && line.dy == old.dy) continue;
+
+		old = line;
+		firstline = min(firstline, (int)i);
+		firstnode = min(firstnode, leafs[i]);
+		for (int node = leafs[i]; node >= 0; node = parents[node])
+		{
+			RefitNode(node);
+		}
+	}
+
+	if (firstline == (int)treelines.Size()) return false;
+	dynamicStartLine = firstline;
+	dynamicStartNode = firstnode;
+	return true;
+}
+
+//==========================================================================
+//
+// Micro benchmark: tree ray test vs. testing all walls.
+//
+//==========================================================================
+
+CCMD(bench_aabbtree)
+{
+	if (numwalls <= 0)
+	{
+		Printf("No map loaded\n");
+		return;
+	}
+	int count = argv.argc() > 1 ? (int)strtoull(argv[1], nullptr, 0) : 10000;
+	if (count <= 0) count = 10000;
+
+	cycle_t timer;
+	timer.Reset();
+	timer.Clock();
+	levelAABBTree.Validate();
+	levelAABBTree.Update();
+	timer.Unclock();
+	double buildtime = timer.TimeMS();
+	if (levelAABBTree.NodesCount() == 0)
+	{
+		Printf("No solid walls\n");
+		return;
+	}
+
+	// rays between random pairs of wall midpoints, with a fixed seed so that results are comparable between runs.
+	TArray<DVector3> points(count * 2, true);
+	uint32_t seed = 0x12345678;
+	for (auto& p : points)
+	{
+		seed = seed * 1664525 + 1013904223;
+		int w = int((uint64_t(seed >> 8) * numwalls) >> 24);
+		auto wal = &wall[w];
+		auto wal2 = &wall[wal->point2];
+		p = { (wal->x + wal2->x) * (1 / 32.), (wal->y + wal2->y) * (1 / -32.), 0 };
+	}
+
+	int hits = 0;
+	timer.Reset();
+	timer.Clock();
+	for (int n = 0; n < count; n++)
+	{
+		if (levelAABBTree.RayTest(points[n * 2], points[n * 2 + 1]) < 1.) hits++;
+	}
+	timer.Unclock();
+	double treetime = timer.TimeMS();
+
+	// brute force reference
+	int bruteforcehits = 0;
+	timer.Reset();
+	timer.Clock();
+	for (int n = 0; n < count; n++)
+	{
+		DVector2 start = points[n * 2].XY(), end = points[n * 2 + 1].XY();
+		DVector2 raydelta = end - start;
+		for (int i = 0; i < numwalls; i++)
+		{
+			if (wall[i].nextwall >= 0) continue;
+			auto line = MakeLine(i);
+			DVector2 lp(line.x, line.y), ld(line.dx, line.dy);
+			double den = raydelta.X * ld.Y - raydelta.Y * ld.X;
+			if (fabs(den) < 0.0000001) continue;
+			DVector2 d = lp - start;
+			double t = (d.X * ld.Y - d.Y * ld.X) / den;
+			double u = (d.X * raydelta.Y - d.Y * raydelta.X) / den;
+			if (t > 0 && t < 1 && u >= 0 && u <= 1)
+			{
+				bruteforcehits++;
+				break;
+			}
+		}
+	}
+	timer.Unclock();
+	double brutetime = timer.TimeMS();
+
+	Printf("%d nodes, built in %.3f ms, %d rays\n", levelAABBTree.NodesCount(), buildtime, count);
+	Printf("tree:        %.3f ms, %d rays blocked\n", treetime, hits);
+	Printf("brute force: %.3f ms, %d rays blocked\n", brutetime, bruteforcehits);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "hw_aabbtree.h"
+
+//==========================================================================
+//
+// AABB tree over all solid walls of the current map, in renderer
+// coordinates. Used for ray tests by the shadow map and anything else
+// that needs to trace through the level's outline.
+//
+// Build maps do not have a fixed set of movable lines, so instead of
+// splitting the tree into a static and a dynamic part, Update() checks all
+// walls for movement and refits the affected leaves and their parents.
+// Since parents are always stored after their children, the dynamic range
+// reported to the shadow map starts at the first node that changed.
+//
+//==========================================================================
+
+class BuildAABBTree : public hwrenderer::LevelAABBTree
+{
+	TArray<int> parents;	// parent node of each node, -1 for the root.
+	TArray<int> leafs;		// leaf node of each tree line.
+	TArray<int> walls;		// wall of each tree line.
+	bool valid = false;
+
+	int GenerateTreeNode(int* lines, int num_lines, const FVector2* centroids, int* work_buffer);
+	void RefitNode(int node);
+
+public:
+	void Clear();
+	bool Validate();
+	bool Update() override;
+};
+
+extern BuildAABBTree levelAABBTree;
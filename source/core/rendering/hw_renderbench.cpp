@@ -0,0 +1,319 @@
+/*
+** hw_renderbench.cpp
+**
+** Renders a list of fixed viewpoints repeatedly and reports the time
+** spent in each stage of the scene renderer.
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 agent
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The viewpoint file contains one viewpoint per line:
+**
+**   x y z angle [pitch]
+**
+** in map units, with the angle in Build units (0-2047) and the pitch in
+** degrees. Empty lines and lines starting with '#' are ignored.
+**
+** From the console:  renderbench <file> [iterations] [png base name]
+** Command line:      -renderbench <file> [-renderbenchcount <n>] [-renderbenchpng <base name>]
+**
+** The command line version runs once the first level frame has been drawn
+** and quits afterward.
+**
+*/
+
+#include <float.h>
+#include "c_dispatch.h"
+#include "c_cvars.h"
+#include "m_argv.h"
+#include "files.h"
+#include "printf.h"
+#include "gamestate.h"
+#include "build.h"
+#include "v_video.h"
+#include "v_draw.h"
+#include "i_system.h"
+#include "engineerrors.h"
+#include "hw_clock.h"
+#include "hw_renderstate.h"
+#include "hw_lightbuffer.h"
+#include "hw_viewpointbuffer.h"
+#include "flatvertices.h"
+#include "hw_drawinfo.h"
+#include "sectorgeometry.h"
+#include "gamecontrol.h"
+#include "gamehud.h"
+
+void RenderViewpoint(FRenderViewpoint& mainvp, IntRect* bounds, float fov, float ratio, float fovratio, bool mainview, bool toscreen);
+FRenderViewpoint SetupViewpoint(spritetype* cam, const vec3_t& position, int sectnum, binangle angle, fixedhoriz horizon, binangle rollang);
+void DoWriteSavePic(FileWriter* file, uint8_t* scr, int width, int height, bool upsidedown);
+extern int gametic;
+
+struct BenchView
+{
+	vec3_t pos;
+	int sectnum;
+	binangle angle;
+	fixedhoriz horizon;
+};
+
+enum
+{
+	BS_Bsp,		// bunch traversal and clipping
+	BS_Setup,	// the rest of the scene setup, i.e. creating the draw lists
+	BS_Sort,	// sorting the translucent and masked draw lists
+	BS_Draw,	// submitting the draw lists to the backend
+	BS_Raster,	// waiting for the backend to finish
+	BS_Total,
+	BS_Count
+};
+
+static const char* const stagenames[] = { "bsp", "setup", "sort", "draw", "raster", "total" };
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static bool ReadViewpoints(const char* filename, TArray<BenchView>& views)
+{
+	FileReader fr;
+	if (!fr.OpenFile(filename))
+	{
+		Printf(TEXTCOLOR_RED "%s: unable to open\n", filename);
+		return false;
+	}
+	auto buffer = fr.ReadPadded(1);
+	FString text((const char*)buffer.Data());
+	auto lines = text.Split("\n");
+
+	for (unsigned i = 0; i < lines.Size(); i++)
+	{
+		auto& line = lines[i];
+		line.StripLeftRight();
+		if (line.IsEmpty() || line[0] == '#') continue;
+
+		int x, y, z, ang;
+		double pitch = 0;
+		if (sscanf(line.GetChars(), "%d %d %d %d %lf", &x, &y, &z, &ang, &pitch) < 4)
+		{
+			Printf(TEXTCOLOR_RED "%s, line %d: expected 'x y z angle [pitch]'\n", filename, i + 1);
+			return false;
+		}
+		int16_t sect = -1;
+		updatesector(x, y, &sect);
+		if (sect < 0)
+		{
+			Printf(TEXTCOLOR_RED "%s, line %d: (%d, %d) is not inside any sector\n", filename, i + 1, x, y);
+			return false;
+		}
+		views.Push({ { x, y, z }, sect, buildang(ang & 2047), pitchhoriz(pitch) });
+	}
+	if (views.Size() == 0)
+	{
+		Printf(TEXTCOLOR_RED "%s: no viewpoints\n", filename);
+		return false;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Renders one viewpoint to the full screen and returns the stage timings.
+// Uses the frame setup of the regular display code so that every iteration
+// starts from the same state.
+//
+//==========================================================================
+
+static void RenderBenchView(const BenchView& view, double* times, const char* pngname)
+{
+	auto& RenderState = *screen->RenderState();
+	int width = screen->GetWidth();
+	int height = screen->GetHeight();
+
+	IntRect bounds;
+	bounds.left = 0;
+	bounds.top = 0;
+	bounds.width = width;
+	bounds.height = height;
+
+	screen->BeginFrame();
+	twod->Clear();
+	twodpsp.Clear();
+
+	screen->mLights->Clear();
+	screen->mViewpoints->Clear();
+	screen->mVertexData->Reset();
+	RenderState.SetVertexBuffer(screen->mVertexData);
+	sectorGeometry.TriangulateDirty();
+
+	FRenderViewpoint vp = SetupViewpoint(nullptr, view.pos, view.sectnum, view.angle, view.horizon, buildang(0));
+	vp.TicFrac = 1.;
+	float ratio = ActiveRatio(width, height);
+	float fovratio = ratio >= 1.33f ? 1.33f : ratio;
+
+	ResetProfilingData();
+	cycle_t total, raster;
+	total.Reset();
+	raster.Reset();
+
+	total.Clock();
+	screen->ImageTransitionScene(true);
+	RenderViewpoint(vp, &bounds, vp.FieldOfView.Degrees, ratio, fovratio, true, false);
+	raster.Clock();
+	screen->WaitForCommands(false);
+	raster.Unclock();
+	total.Unclock();
+
+	times[BS_Bsp] = Bsp.TimeMS();
+	times[BS_Setup] = ProcessAll.TimeMS() - Bsp.TimeMS();
+	times[BS_Sort] = SortAll.TimeMS();
+	times[BS_Draw] = RenderAll.TimeMS() - SortAll.TimeMS();
+	times[BS_Raster] = raster.TimeMS();
+	times[BS_Total] = total.TimeMS();
+
+	if (pngname)
+	{
+		TArray<uint8_t> scr(width * height * 3, true);
+		screen->CopyScreenToBuffer(width, height, scr.Data());
+		auto file = FileWriter::Open(pngname);
+		if (file)
+		{
+			DoWriteSavePic(file, scr.Data(), width, height, screen->FlipSavePic());
+			delete file;
+		}
+		else Printf(TEXTCOLOR_RED "%s: unable to write\n", pngname);
+	}
+
+	screen->SetViewportRects(nullptr);
+	screen->Update();
+	screen->mVertexData->Reset();
+	screen->mViewpoints->Clear();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void RunRenderBench(const char* filename, int iterations, const char* pngbase)
+{
+	if (gamestate != GS_LEVEL || numsectors <= 0 || screen == nullptr)
+	{
+		Printf("No map loaded\n");
+		return;
+	}
+	TArray<BenchView> views;
+	if (!ReadViewpoints(filename, views)) return;
+	if (iterations <= 0) iterations = 10;
+
+	Printf("Render benchmark: %u viewpoints, %d iterations, %dx%d\n", views.Size(), iterations,
+		screen->GetWidth(), screen->GetHeight());
+	Printf("times in ms: average (minimum)\n");
+
+	bool wasactive = glcycle_t::active;
+	glcycle_t::active = true;
+
+	double grandtotal[BS_Count] = {};
+	for (unsigned v = 0; v < views.Size(); v++)
+	{
+		double times[BS_Count], sum[BS_Count] = {}, minimum[BS_Count];
+		for (auto& m : minimum) m = DBL_MAX;
+
+		// The first render uploads textures and fills caches. Don't count it but use it for the screenshot.
+		FString pngname;
+		if (pngbase && *pngbase) pngname.Format("%s_%02u.png", pngbase, v);
+		RenderBenchView(views[v], times, pngname.IsNotEmpty() ? pngname.GetChars() : nullptr);
+
+		for (int n = 0; n < iterations; n++)
+		{
+			RenderBenchView(views[v], times, nullptr);
+			for (int s = 0; s < BS_Count; s++)
+			{
+				sum[s] += times[s];
+				minimum[s] = min(minimum[s], times[s]);
+			}
+		}
+
+		FString out;
+		out.Format("%2u:", v);
+		for (int s = 0; s < BS_Count; s++)
+		{
+			out.AppendFormat(" %s %.3f (%.3f)", stagenames[s], sum[s] / iterations, minimum[s]);
+			grandtotal[s] += sum[s] / iterations;
+		}
+		Printf("%s\n", out.GetChars());
+	}
+
+	FString out = "all:";
+	for (int s = 0; s < BS_Count; s++) out.AppendFormat(" %s %.3f", stagenames[s], grandtotal[s]);
+	Printf("%s\n", out.GetChars());
+
+	glcycle_t::active = wasactive;
+	checkBenchActive();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(renderbench)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: renderbench <viewpoint file> [iterations] [png base name]\n");
+		return;
+	}
+	int iterations = argv.argc() > 2 ? (int)strtol(argv[2], nullptr, 0) : 10;
+	RunRenderBench(argv[1], iterations, argv.argc() > 3 ? argv[3] : nullptr);
+}
+
+//==========================================================================
+//
+// Called by the main loop after each frame to run a benchmark requested
+// on the command line.
+//
+//==========================================================================
+
+void CheckRenderBench()
+{
+	static bool done;
+	if (done || gamestate != GS_LEVEL || gametic == 0) return;
+
+	const char* filename = Args->CheckValue("-renderbench");
+	done = true;
+	if (filename == nullptr) return;
+
+	const char* count = Args->CheckValue("-renderbenchcount");
+	RunRenderBench(filename, count ? (int)strtol(count, nullptr, 0) : 10, Args->CheckValue("-renderbenchpng"));
+	throw CExitEvent(0);
+}
@@ -707,10 +707,12 @@ SortNode * HWDrawList::DoSort(HWDrawInfo *di, SortNode * head)
 //==========================================================================
 void HWDrawList::Sort(HWDrawInfo *di)
 {
+	SortAll.Clock();
 	reverseSort = false;
     SortZ = di->Viewpoint.Pos.Z;
 	MakeSortList();
 	sorted = DoSort(di, SortNodes[SortNodeStart]);
+	SortAll.Unclock();
 }
 
 //==========================================================================
@@ -724,6 +726,7 @@ void HWDrawList::SortWallsVert(HWDrawInfo* di)
 	auto viewy = di->Viewpoint.Pos.Y;
 	if (drawitems.Size() > 1)
 	{
+		SortAll.Clock();
 		TArray<HWDrawItem> list1(drawitems.Size(), false);
 		TArray<HWDrawItem> list2(drawitems.Size(), false);
 
@@ -757,6 +760,7 @@ void HWDrawList::SortWallsVert(HWDrawInfo* di)
 		drawitems.Clear();
 		drawitems.Append(list1);
 		drawitems.Append(list2);
+		SortAll.Unclock();
 	}
 }
 
@@ -771,6 +775,7 @@ void HWDrawList::SortWallsHorz(HWDrawInfo* di)
 	auto viewx = di->Viewpoint.Pos.X;
 	if (drawitems.Size() > 1)
 	{
+		SortAll.Clock();
 		TArray<HWDrawItem> list1(drawitems.Size(), false);
 		TArray<HWDrawItem> list2(drawitems.Size(), false);
 
@@ -804,6 +809,7 @@ void HWDrawList::SortWallsHorz(HWDrawInfo* di)
 		drawitems.Clear();
 		drawitems.Append(list1);
 		drawitems.Append(list2);
+		SortAll.Unclock();
 	}
 }
 
@@ -818,6 +824,7 @@ void HWDrawList::SortFlats(HWDrawInfo* di)
 	auto viewz = di->Viewpoint.Pos.Z;
 	if (drawitems.Size() > 1)
 	{
+		SortAll.Clock();
 		TArray<HWDrawItem> list1(drawitems.Size(), false);
 		TArray<HWDrawItem> list2(drawitems.Size(), false);
 
@@ -851,6 +858,7 @@ void HWDrawList::SortFlats(HWDrawInfo* di)
 		drawitems.Clear();
 		drawitems.Append(list1);
 		drawitems.Append(list2);
+		SortAll.Unclock();
 	}
 }
 
@@ -59,13 +59,12 @@
 #include "render.h"
 #include "hw_sections.h"
 #include "sectorgeometry.h"
+#include "sectorgrid.h"
+#include "hw_levelaabbtree.h"
 #include "d_net.h"
 #include <zlib.h>
 
 
-sectortype sectorbackup[MAXSECTORS];
-walltype wallbackup[MAXWALLS];
-
 void WriteSavePic(FileWriter* file, int width, int height);
 bool WriteZip(const char* filename, TArray<FString>& filenames, TArray<FCompressedBuffer>& content);
 extern FString savename;
@@ -651,6 +650,8 @@ void SerializeMap(FSerializer& arc)
 		setWallSectors();
 		hw_BuildSections();
 		sectorGeometry.SetSize(numsections);
+		sectorGrid.Build();
+		levelAABBTree.Clear();
 	}
 }
 
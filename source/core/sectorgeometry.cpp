@@ -41,9 +41,25 @@
 #include "earcut.hpp"
 #include "hw_sections.h"
 #include "nodebuilder/nodebuild.h"
+#include "superfasthash.h"
+#include "parallel_for.h"
+#include "i_specialpaths.h"
+#include "cmdlib.h"
+#include "files.h"
+#include "stats.h"
+#include "c_cvars.h"
+#include "printf.h"
+
+CVARD(Bool, r_sectorcache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG, "store sector triangulations on disk to speed up map loading")
 
 SectorGeometry sectorGeometry;
 
+static struct
+{
+	int hits, misses;
+	double loadtime, buildtime, savedtime;
+} cachestats;
+
 //==========================================================================
 //
 // CalcPlane fixme - this should be stored in the sector, not be recalculated each frame.
@@ -212,17 +228,16 @@ public:
 
 //==========================================================================
 //
-//
+// Triangulates a section's outline with earcut. This only reads the map's
+// geometry so it can run on a worker thread.
 //
 //==========================================================================
 
-bool SectorGeometry::MakeVertices(unsigned int secnum, int plane, const FVector2& offset)
+static bool TriangulateEarcut(unsigned int secnum, SectorTriangulation& result)
 {
 	auto sec = &sections[secnum];
-	auto sectorp = &sector[sec->sector];
 	int numvertices = sec->lines.Size();
 	
-	TArray<FVector3> points(numvertices, true);
 	using Point = std::pair<float, float>;
 	std::vector<std::vector<Point>> polygon;
 	std::vector<Point>* curPoly;
@@ -231,8 +246,6 @@ bool SectorGeometry::MakeVertices(unsigned int secnum, int plane, const FVector2
 	curPoly = &polygon.back();
 	FixedBitArray<MAXWALLSB> done;
 
-	int fz = sectorp->floorz, cz = sectorp->ceilingz;
-
 	int vertstoadd = numvertices;
 
 	done.Zero();
@@ -253,6 +266,7 @@ bool SectorGeometry::MakeVertices(unsigned int secnum, int plane, const FVector2
 				{
 					// If we get here there's some fuckery going around with the coordinates. Let's better abort and wait for things to realign.
 					// Do not try alternative methods if this happens.
+					result.aborted = true;
 					return true;
 				}
 				curPoly->push_back(std::make_pair(X, Y));
@@ -288,38 +302,18 @@ bool SectorGeometry::MakeVertices(unsigned int secnum, int plane, const FVector2
 		// this means that full triangulation failed.
 		return false;
 	}
-	sectorp->floorz = sectorp->ceilingz = 0;
 
-	int p = 0;
-	for (size_t a = 0; a < polygon.size(); a++)
+	TArray<FVector2> points;
+	for (auto& poly : polygon)
 	{
-		for (auto& pt : polygon[a])
-		{
-			float planez;
-			PlanesAtPoint(sectorp, (pt.first * 16), (pt.second * -16), plane ? &planez : nullptr, !plane ? &planez : nullptr);
-			FVector3 point = { pt.first, pt.second, planez };
-			points[p++] = point;
-		}
+		for (auto& pt : poly) points.Push({ pt.first, pt.second });
 	}
-	
-	auto& entry = data[secnum].planes[plane];
-	entry.vertices.Resize((unsigned)indices.size());
-	entry.texcoords.Resize((unsigned)indices.size());
-	entry.normal = CalcNormal(sectorp, plane);
-
-	auto texture = tileGetTexture(plane ? sectorp->ceilingpicnum : sectorp->floorpicnum);
 
-	UVCalculator uvcalc(sectorp, plane, texture, offset);
-	
-	for(unsigned i = 0; i < entry.vertices.Size(); i++)
+	result.triangles.Resize((unsigned)indices.size());
+	for (unsigned i = 0; i < result.triangles.Size(); i++)
 	{
-		auto& pt = points[indices[i]];
-		entry.vertices[i] = pt;
-		entry.texcoords[i] = uvcalc.GetUV(int(pt.X * 16), int(pt.Y * -16), pt.Z);
+		result.triangles[i] = points[indices[i]];
 	}
-
-	sectorp->floorz = fz;
-	sectorp->ceilingz = cz;
 	return true;
 }
 
@@ -331,7 +325,7 @@ bool SectorGeometry::MakeVertices(unsigned int secnum, int plane, const FVector2
 //
 //==========================================================================
 
-bool SectorGeometry::MakeVertices2(unsigned int secnum, int plane, const FVector2& offset)
+static void TriangulateNodes(unsigned int secnum, SectorTriangulation& result)
 {
 	auto sec = &sections[secnum];
 	auto sectorp = &sector[sec->sector];
@@ -354,7 +348,8 @@ bool SectorGeometry::MakeVertices2(unsigned int secnum, int plane, const FVector
 		if (fabs(vertexes[j].p.X) > 32768.f || fabs(vertexes[j].p.Y) > 32768.f)
 		{
 			// If we get here there's some fuckery going around with the coordinates. Let's better abort and wait for things to realign.
-			return true;
+			result.aborted = true;
+			return;
 		}
 
 		lines[j].backsector = nullptr;
@@ -464,13 +459,11 @@ bool SectorGeometry::MakeVertices2(unsigned int secnum, int plane, const FVector
 nexti:;
 	}
 
+
 	if (lines.Size() < 4)
 	{
 		// nothing to generate. If line count is < 4 this sector is degenerate and should not be processed further.
-		auto& entry = data[secnum].planes[plane];
-		entry.vertices.Clear();
-		entry.texcoords.Clear();
-		return true;
+		return;
 	}
 
 
@@ -487,15 +480,7 @@ nexti:;
 	FLevelLocals Level;
 	builder.Extract(Level);
 
-	// Now turn the generated subsectors into triangle meshes
-
-	auto& entry = data[secnum].planes[plane];
-	entry.vertices.Clear();
-	entry.texcoords.Clear();
-
-	int fz = sectorp->floorz, cz = sectorp->ceilingz;
-	sectorp->floorz = sectorp->ceilingz = 0;
-
+	// Now turn the generated subsectors into triangles
 	for (auto& sub : Level.subsectors)
 	{
 		if (sub.numlines <= 2) continue;
@@ -505,33 +490,159 @@ nexti:;
 			auto v1 = sub.firstline[i].v1;
 			auto v2 = sub.firstline[i].v2;
 
-			entry.vertices.Push({ (float)v0->fX(), (float)v0->fY(), 0 });
-			entry.vertices.Push({ (float)v1->fX(), (float)v1->fY(), 0 });
-			entry.vertices.Push({ (float)v2->fX(), (float)v2->fY(), 0 });
-
+			result.triangles.Push({ (float)v0->fX(), (float)v0->fY() });
+			result.triangles.Push({ (float)v1->fX(), (float)v1->fY() });
+			result.triangles.Push({ (float)v2->fX(), (float)v2->fY() });
 		}
+	}
+}
+
+//==========================================================================
+//
+// The triangulations are stored relative to the first point of the
+// section so that sections of the same shape share them no matter
+// where they are, e.g. sectors that get moved as a whole.
+//
+//==========================================================================
+
+static const walltype* OriginWall(unsigned int secnum)
+{
+	auto sec = &sections[secnum];
+	return sec->lines.Size() > 0 ? &wall[sectionLines[sec->lines[0]].startpoint] : nullptr;
+}
+
+static FVector2 Origin(unsigned int secnum)
+{
+	auto wallp = OriginWall(secnum);
+	if (!wallp) return { 0, 0 };
+	return { float(WallStartX(wallp)), float(WallStartY(wallp)) };
+}
+
+//==========================================================================
+//
+// Runs the complete 2D triangulation for one section.
+// The outcome only depends on the outline described by the key.
+//
+//==========================================================================
 
+static void Triangulate(unsigned int secnum, bool degenerate, SectorTriangulation& result)
+{
+	cycle_t timer;
+	timer.Reset();
+	timer.Clock();
+	result.triangles.Clear();
+	result.aborted = false;
+	result.degenerate = degenerate;
+	if (degenerate || !TriangulateEarcut(secnum, result))
+	{
+		//Printf(TEXTCOLOR_YELLOW "Normal triangulation failed for sector %d. Retrying with alternative approach\n", secnum);
+		result.degenerate = true;
+		result.triangles.Clear();
+		TriangulateNodes(secnum, result);
 	}
+	auto origin = Origin(secnum);
+	for (auto& pt : result.triangles) pt -= origin;
+	timer.Unclock();
+	result.cost = float(timer.TimeMS());
+}
+
+//==========================================================================
+//
+// Describes everything the triangulation of a section depends on.
+// Sections with coordinates the triangulators refuse are keyed apart
+// so that they never pick up a shape that was triangulated elsewhere.
+//
+//==========================================================================
+
+void SectorGeometry::MakeKey(unsigned int secnum, TArray<int>& key)
+{
+	auto sec = &sections[secnum];
+	auto origin = OriginWall(secnum);
+	bool outofrange = false;
+	key.Clear();
+	key.Push(data[secnum].degenerate);
+	key.Push(0);
+	for (auto line : sec->lines)
+	{
+		auto sline = &sectionLines[line];
+		auto wallp = &wall[sline->startpoint];
+		key.Push(int(unsigned(wallp->x) - unsigned(origin->x)));
+		key.Push(int(unsigned(wallp->y) - unsigned(origin->y)));
+		key.Push(sline->point2index);
+		if (fabs(WallStartX(wallp)) > 32768. || fabs(WallStartY(wallp)) > 32768.) outofrange = true;
+	}
+	key[1] = outofrange;
+}
+
+static uint32_t HashKey(const TArray<int>& key)
+{
+	return SuperFastHash((const char*)key.Data(), key.Size() * sizeof(int));
+}
+
+//==========================================================================
+//
+// Gets the triangulation for a section's current shape, either from
+// the cache or by generating it now.
+//
+//==========================================================================
+
+enum
+{
+	MAXCACHEDSHAPES = 16384,
+};
+
+const SectorTriangulation* SectorGeometry::GetTriangulation(unsigned int secnum)
+{
+	TArray<int> key;
+	MakeKey(secnum, key);
+	auto hash = HashKey(key);
+	auto cached = cache.CheckKey(hash);
+	if (cached && cached->key == key) return cached;
+
+	if (cache.CountUsed() >= MAXCACHEDSHAPES) cache.Clear();
+	auto& entry = cache.Insert(hash, {});
+	entry.key = std::move(key);
+	Triangulate(secnum, data[secnum].degenerate, entry);
+	return &entry;
+}
+
+//==========================================================================
+//
+// Generates the 3D mesh for a plane from the 2D triangulation.
+//
+//==========================================================================
+
+void SectorGeometry::MakeVertices(unsigned int secnum, int plane, const FVector2& offset, const TArray<FVector2>& triangles)
+{
+	auto sectorp = &sector[sections[secnum].sector];
+	auto& entry = data[secnum].planes[plane];
+
+	entry.vertices.Resize(triangles.Size());
+	entry.texcoords.Resize(triangles.Size());
+	if (triangles.Size() == 0) return;
+
+	int fz = sectorp->floorz, cz = sectorp->ceilingz;
+	sectorp->floorz = sectorp->ceilingz = 0;
+
+	entry.normal = CalcNormal(sectorp, plane);
 
-	// calculate the rest.
 	auto texture = tileGetTexture(plane ? sectorp->ceilingpicnum : sectorp->floorpicnum);
 
 	UVCalculator uvcalc(sectorp, plane, texture, offset);
+	auto origin = Origin(secnum);
 
-	entry.texcoords.Resize(entry.vertices.Size());
-	for (unsigned i = 0; i < entry.vertices.Size(); i++)
+	for (unsigned i = 0; i < triangles.Size(); i++)
 	{
-		auto& pt = entry.vertices[i];
+		auto pt = triangles[i] + origin;
 
 		float planez;
 		PlanesAtPoint(sectorp, (pt.X * 16), (pt.Y * -16), plane ? &planez : nullptr, !plane ? &planez : nullptr);
-		entry.vertices[i].Z = planez;
-		entry.texcoords[i] = uvcalc.GetUV(int(pt.X * 16.), int(pt.Y * -16.), pt.Z);
+		entry.vertices[i] = { pt.X, pt.Y, planez };
+		entry.texcoords[i] = uvcalc.GetUV(int(pt.X * 16), int(pt.Y * -16), planez);
 	}
-	entry.normal = CalcNormal(sectorp, plane);
+
 	sectorp->floorz = fz;
 	sectorp->ceilingz = cz;
-	return true;
 }
 
 //==========================================================================
@@ -540,44 +651,311 @@ nexti:;
 //
 //==========================================================================
 
-void SectorGeometry::ValidateSector(unsigned int secnum, int plane, const FVector2& offset)
+bool SectorGeometry::IsValid(unsigned int secnum, int plane)
 {
 	auto sec = &sector[sections[secnum].sector];
 
 	auto compare = &data[secnum].compare[plane];
 	if (plane == 0)
 	{
-		if (sec->floorheinum == compare->floorheinum &&
+		return (sec->floorheinum == compare->floorheinum &&
 			sec->floorpicnum == compare->floorpicnum &&
 			((sec->floorstat ^ compare->floorstat) & (CSTAT_SECTOR_ALIGN | CSTAT_SECTOR_YFLIP | CSTAT_SECTOR_XFLIP | CSTAT_SECTOR_TEXHALF | CSTAT_SECTOR_SWAPXY)) == 0 &&
 			sec->floorxpan_ == compare->floorxpan_ &&
 			sec->floorypan_ == compare->floorypan_ &&
 			wall[sec->wallptr].pos == data[secnum].poscompare[0] &&
 			wall[wall[sec->wallptr].point2].pos == data[secnum].poscompare2[0] &&
-			!(sec->dirty & 1) && data[secnum].planes[plane].vertices.Size() ) return;
-
-		sec->dirty &= ~1;
+			!(sec->dirty & 1) && data[secnum].planes[plane].vertices.Size());
 	}
 	else
 	{
-		if (sec->ceilingheinum == compare->ceilingheinum &&
+		return (sec->ceilingheinum == compare->ceilingheinum &&
 			sec->ceilingpicnum == compare->ceilingpicnum &&
 			((sec->ceilingstat ^ compare->ceilingstat) & (CSTAT_SECTOR_ALIGN | CSTAT_SECTOR_YFLIP | CSTAT_SECTOR_XFLIP | CSTAT_SECTOR_TEXHALF | CSTAT_SECTOR_SWAPXY)) == 0 &&
 			sec->ceilingxpan_ == compare->ceilingxpan_ &&
 			sec->ceilingypan_ == compare->ceilingypan_ &&
 			wall[sec->wallptr].pos == data[secnum].poscompare[1] &&
 			wall[wall[sec->wallptr].point2].pos == data[secnum].poscompare2[1] &&
-			!(sec->dirty & 2) && data[secnum].planes[1].vertices.Size()) return;
-
-		sec->dirty &= ~2;
+			!(sec->dirty & 2) && data[secnum].planes[1].vertices.Size());
 	}
-	*compare = *sec;
+}
+
+void SectorGeometry::ValidateSector(unsigned int secnum, int plane, const FVector2& offset)
+{
+	if (IsValid(secnum, plane)) return;
+
+	auto sec = &sector[sections[secnum].sector];
+	sec->dirty &= ~(1 << plane);
+	data[secnum].compare[plane] = *sec;
 	data[secnum].poscompare[plane] = wall[sec->wallptr].pos;
 	data[secnum].poscompare2[plane] = wall[wall[sec->wallptr].point2].pos;
-	if (data[secnum].degenerate || !MakeVertices(secnum, plane, offset))
+
+	auto tri = GetTriangulation(secnum);
+	data[secnum].degenerate = tri->degenerate;
+	if (!tri->aborted) MakeVertices(secnum, plane, offset, tri->triangles);
+}
+
+//==========================================================================
+//
+// Flags a sector for rebuilding after its walls were moved and queues
+// it for the next TriangulateDirty call.
+//
+//==========================================================================
+
+void SectorGeometry::MarkDirty(int sectnum)
+{
+	sector[sectnum].dirty = 255;
+	if ((unsigned)sectnum < dirtyqueued.Size() && !dirtyqueued[sectnum])
 	{
-		data[secnum].degenerate = true;
-		//Printf(TEXTCOLOR_YELLOW "Normal triangulation failed for sector %d. Retrying with alternative approach\n", secnum);
-		MakeVertices2(secnum, plane, offset);
+		dirtyqueued[sectnum] = 1;
+		dirtysectors.Push(sectnum);
+	}
+}
+
+//==========================================================================
+//
+// Triangulates the sections that will have to be rebuilt when they get
+// rendered and whose shape is not cached yet in parallel, so that the
+// renderer only has to do the cheap part. Must be called after all
+// geometry changes for the frame have been made.
+//
+// Right after loading a map all sections are checked, afterward only the
+// ones of sectors passed to MarkDirty. Walls that get moved without it are
+// still caught by the renderer, which then triangulates them on the spot.
+//
+//==========================================================================
+
+void SectorGeometry::TriangulateDirty()
+{
+	TArray<SectorTriangulation> jobs;
+	TArray<unsigned> jobsections;
+	TMap<uint32_t, unsigned> jobhashes;
+	TArray<int> key;
+
+	auto check = [&](unsigned i)
+	{
+		if (IsValid(i, 0) && IsValid(i, 1)) return;
+
+		MakeKey(i, key);
+		auto hash = HashKey(key);
+		auto cached = cache.CheckKey(hash);
+		if (cached && cached->key == key)
+		{
+			if (loadpending)
+			{
+				cachestats.hits++;
+				cachestats.savedtime += cached->cost;
+			}
+			return;
+		}
+		if (jobhashes.CheckKey(hash)) return;	// same shape was already queued.
+
+		jobhashes.Insert(hash, jobs.Size());
+		jobs.Reserve(1);
+		jobs.Last().key = std::move(key);
+		jobsections.Push(i);
+	};
+
+	if (loadpending)
+	{
+		for (unsigned i = 0; i < data.Size(); i++) check(i);
 	}
+	else
+	{
+		for (auto sect : dirtysectors)
+		{
+			for (auto section : sectionspersector[sect])
+			{
+				if ((unsigned)section < data.Size()) check(section);
+			}
+		}
+	}
+	for (auto sect : dirtysectors) dirtyqueued[sect] = 0;
+	dirtysectors.Clear();
+
+	if (jobs.Size() > 0)
+	{
+		auto work = [&](int i)
+		{
+			if ((unsigned)i >= jobs.Size()) return;
+			Triangulate(jobsections[i], data[jobsections[i]].degenerate, jobs[i]);
+		};
+
+		cycle_t timer;
+		timer.Reset();
+		timer.Clock();
+		if (jobs.Size() == 1) work(0);
+		else parallel_for((int)jobs.Size(), work);
+		timer.Unclock();
+
+		if (cache.CountUsed() + jobs.Size() > MAXCACHEDSHAPES) cache.Clear();
+		TMap<uint32_t, unsigned>::Iterator it(jobhashes);
+		TMap<uint32_t, unsigned>::Pair* pair;
+		while (it.NextPair(pair))
+		{
+			cache.Insert(pair->Key, std::move(jobs[pair->Value]));
+		}
+
+		if (loadpending)
+		{
+			cachestats.misses += jobs.Size();
+			cachestats.buildtime += timer.TimeMS();
+		}
+	}
+
+	if (loadpending)
+	{
+		// the first pass after loading a map covers all sections, so this is the time to update the disk cache.
+		loadpending = false;
+		if (jobs.Size() > 0) SaveCache();
+	}
+}
+
+//==========================================================================
+//
+// Disk cache for the triangulations of a map's initial state.
+// The file is selected by the map's MD4 but each entry is still validated
+// by its full key, so map hacks or edited maps only cost the changed sectors.
+//
+//==========================================================================
+
+static const char SectorCacheMagic[4] = { 'R', 'S', 'G', 'C' };
+static const uint32_t SectorCacheVersion = 2;
+
+void SectorGeometry::SetSize(unsigned sectcount)
+{
+	data.Clear(); // delete old content
+	data.Resize(sectcount);
+	cache.Clear();
+	dirtysectors.Clear();
+	dirtyqueued.Resize(numsectors);
+	memset(dirtyqueued.Data(), 0, dirtyqueued.Size());
+	hashvalid = false;
+	loadpending = true;
+	memset(&cachestats, 0, sizeof(cachestats));
+}
+
+FString SectorGeometry::CacheFileName(bool create)
+{
+	FString path = M_GetCachePath(create);
+	path << "/sectorcache";
+	if (create) CreatePath(path);
+	path.AppendFormat("/%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x.rsgc",
+		maphash[0], maphash[1], maphash[2], maphash[3], maphash[4], maphash[5], maphash[6], maphash[7],
+		maphash[8], maphash[9], maphash[10], maphash[11], maphash[12], maphash[13], maphash[14], maphash[15]);
+	return path;
+}
+
+void SectorGeometry::LoadCache(const uint8_t* md4)
+{
+	memcpy(maphash, md4, 16);
+	hashvalid = true;
+	if (!r_sectorcache) return;
+
+	cycle_t timer;
+	timer.Reset();
+	timer.Clock();
+
+	// Map the file and parse it in place. Only if that is not possible it gets read into a buffer.
+	auto filename = CacheFileName(false);
+	FileReader fr;
+	TArray<uint8_t> buffer;
+	const uint8_t* p;
+	const uint8_t* end;
+	if (fr.OpenFileMapped(filename))
+	{
+		p = (const uint8_t*)fr.GetBuffer();
+		end = p + fr.GetLength();
+	}
+	else if (fr.OpenFile(filename))
+	{
+		buffer = fr.Read();
+		p = buffer.Data();
+		end = p + buffer.Size();
+	}
+	else return;
+
+	// Parse the entire file in one go. Anything malformed invalidates the whole file.
+	auto readint = [&](uint32_t& v)
+	{
+		if (end - p < 4) return false;
+		memcpy(&v, p, 4);
+		p += 4;
+		return true;
+	};
+
+	uint32_t version, count;
+	if (end - p < 4 || memcmp(p, SectorCacheMagic, 4) != 0) return;
+	p += 4;
+	if (!readint(version) || version != SectorCacheVersion || !readint(count) || count > MAXCACHEDSHAPES) return;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		SectorTriangulation entry;
+		uint32_t keysize, flags, numtris, cost;
+		if (!readint(keysize) || keysize > (uint32_t)(end - p) / 4) break;
+		entry.key.Resize(keysize);
+		memcpy(entry.key.Data(), p, keysize * 4);
+		p += keysize * 4;
+		if (!readint(flags) || !readint(cost) || !readint(numtris) || numtris > (uint32_t)(end - p) / sizeof(FVector2)) break;
+		entry.degenerate = !!(flags & 1);
+		memcpy(&entry.cost, &cost, 4);
+		entry.triangles.Resize(numtris);
+		memcpy(entry.triangles.Data(), p, numtris * sizeof(FVector2));
+		p += numtris * sizeof(FVector2);
+		cache.Insert(HashKey(entry.key), entry);
+	}
+	if (p != end)
+	{
+		DPrintf(DMSG_WARNING, "Sector cache file for this map is damaged\n");
+		cache.Clear();
+	}
+
+	timer.Unclock();
+	cachestats.loadtime = timer.TimeMS();
+}
+
+void SectorGeometry::SaveCache()
+{
+	if (!hashvalid || !r_sectorcache) return;
+
+	// only store what the sections look like now, not the shapes that moving sectors went through.
+	TArray<const SectorTriangulation*> entries;
+	TArray<int> key;
+	for (unsigned i = 0; i < data.Size(); i++)
+	{
+		MakeKey(i, key);
+		auto cached = cache.CheckKey(HashKey(key));
+		if (cached && cached->key == key && !cached->aborted && entries.Find(cached) == entries.Size()) entries.Push(cached);
+	}
+
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(CacheFileName(true)));
+	if (!fw) return;
+
+	uint32_t count = entries.Size();
+	fw->Write(SectorCacheMagic, 4);
+	fw->Write(&SectorCacheVersion, 4);
+	fw->Write(&count, 4);
+	for (auto entry : entries)
+	{
+		uint32_t keysize = entry->key.Size();
+		uint32_t flags = entry->degenerate;
+		uint32_t numtris = entry->triangles.Size();
+		fw->Write(&keysize, 4);
+		fw->Write(entry->key.Data(), keysize * 4);
+		fw->Write(&flags, 4);
+		fw->Write(&entry->cost, 4);
+		fw->Write(&numtris, 4);
+		fw->Write(entry->triangles.Data(), numtris * sizeof(FVector2));
+	}
+}
+
+ADD_STAT(sectorcache)
+{
+	FString out;
+	out.Format("Sector cache: %d hits, %d misses, %d shapes cached\n"
+		"load %.2f ms, triangulation %.2f ms, saved %.2f ms",
+		cachestats.hits, cachestats.misses, sectorGeometry.CacheSize(),
+		cachestats.loadtime, cachestats.buildtime, cachestats.savedtime);
+	return out;
 }
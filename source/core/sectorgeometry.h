@@ -20,13 +20,34 @@ struct SectorGeometryData
 	bool degenerate = false;
 };
 
+// The 2D part of a section's triangulation. This only depends on the section's
+// outline so it can be shared between both planes and between sections of the same shape.
+struct SectorTriangulation
+{
+	TArray<int> key;			// the outline this was generated from.
+	TArray<FVector2> triangles;	// 3 vertices per triangle.
+	bool degenerate = false;	// needed the node builder.
+	bool aborted = false;		// coordinates were out of range, keep the previous mesh.
+	float cost = 0;				// time in ms it took to generate this.
+};
+
 class SectorGeometry
 {
 	TArray<SectorGeometryData> data;
+	TMap<uint32_t, SectorTriangulation> cache;
+	TArray<int> dirtysectors;		// sectors whose walls were moved since the last TriangulateDirty call.
+	TArray<uint8_t> dirtyqueued;	// per sector, set if it is in dirtysectors.
+	uint8_t maphash[16];
+	bool hashvalid = false;
+	bool loadpending = false;
 
+	bool IsValid(unsigned sectnum, int plane);
 	void ValidateSector(unsigned sectnum, int plane, const FVector2& offset);
-	bool MakeVertices(unsigned sectnum, int plane, const FVector2& offset);
-	bool MakeVertices2(unsigned sectnum, int plane, const FVector2& offset);
+	void MakeKey(unsigned sectnum, TArray<int>& key);
+	const SectorTriangulation* GetTriangulation(unsigned sectnum);
+	void MakeVertices(unsigned sectnum, int plane, const FVector2& offset, const TArray<FVector2>& triangles);
+	FString CacheFileName(bool create);
+	void SaveCache();
 
 public:
 	SectorGeometryPlane* get(unsigned sectnum, int plane, const FVector2& offset)
@@ -36,13 +57,11 @@ public:
 		return &data[sectnum].planes[plane];
 	}
 
-	void SetSize(unsigned sectcount)
-	{
-		data.Clear(); // delete old content
-		data.Resize(sectcount);
-	}
+	void SetSize(unsigned sectcount);
+	void MarkDirty(int sectnum);
+	void LoadCache(const uint8_t* md4);
+	void TriangulateDirty();
+	int CacheSize() const { return cache.CountUsed(); }
 };
 
 extern SectorGeometry sectorGeometry;
-
-		
\ No newline at end of file
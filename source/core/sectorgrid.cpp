@@ -0,0 +1,307 @@
+/*
+** sectorgrid.cpp
+**
+** spatial index for point-to-sector lookups
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 agent
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "sectorgrid.h"
+#include "build.h"
+#include "c_dispatch.h"
+#include "printf.h"
+#include "stats.h"
+
+SectorGrid sectorGrid;
+static const TArray<int16_t> emptycell;
+
+enum
+{
+	MINCELLSHIFT = 8,
+	MAXCELLSHIFT = 20,
+	MAXCELLS = 1 << 20,
+};
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void SectorGrid::Clear()
+{
+	boxes.Reset();
+	cells.Reset();
+	width = height = 0;
+	valid = false;
+	needsrebuild = false;
+}
+
+//==========================================================================
+//
+// Adds a sector to all cells covered by newbox that were not already
+// covered by oldbox, keeping each cell's list in descending order.
+//
+//==========================================================================
+
+void SectorGrid::AddToCells(int sectnum, const Box& newbox, const Box* oldbox)
+{
+	int cx1 = (newbox.x1 - originx) >> shift;
+	int cy1 = (newbox.y1 - originy) >> shift;
+	int cx2 = (newbox.x2 - originx) >> shift;
+	int cy2 = (newbox.y2 - originy) >> shift;
+
+	int ox1 = 1, oy1 = 1, ox2 = 0, oy2 = 0;
+	if (oldbox)
+	{
+		ox1 = (oldbox->x1 - originx) >> shift;
+		oy1 = (oldbox->y1 - originy) >> shift;
+		ox2 = (oldbox->x2 - originx) >> shift;
+		oy2 = (oldbox->y2 - originy) >> shift;
+	}
+
+	for (int cy = cy1; cy <= cy2; cy++)
+	{
+		for (int cx = cx1; cx <= cx2; cx++)
+		{
+			if (cx >= ox1 && cx <= ox2 && cy >= oy1 && cy <= oy2) continue;
+
+			auto& cell = cells[cy * width + cx];
+			unsigned pos = 0;
+			while (pos < cell.Size() && cell[pos] > sectnum) pos++;
+			if (pos < cell.Size() && cell[pos] == sectnum) continue;
+			cell.Insert(pos, int16_t(sectnum));
+		}
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void SectorGrid::Build()
+{
+	Clear();
+	if (numsectors <= 0) return;
+
+	boxes.Resize(numsectors);
+	int64_t minx = INT32_MAX, miny = INT32_MAX, maxx = INT32_MIN, maxy = INT32_MIN;
+
+	for (int i = 0; i < numsectors; i++)
+	{
+		auto& box = boxes[i];
+		box = { INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+		auto wal = &wall[sector[i].wallptr];
+		for (int w = 0; w < sector[i].wallnum; w++, wal++)
+		{
+			box.x1 = min(box.x1, wal->x);
+			box.y1 = min(box.y1, wal->y);
+			box.x2 = max(box.x2, wal->x);
+			box.y2 = max(box.y2, wal->y);
+		}
+		if (box.x1 > box.x2) continue;	// sector without walls.
+		minx = min<int64_t>(minx, box.x1);
+		miny = min<int64_t>(miny, box.y1);
+		maxx = max<int64_t>(maxx, box.x2);
+		maxy = max<int64_t>(maxy, box.y2);
+	}
+	if (minx > maxx) return;
+
+	// aim for roughly two cells per sector.
+	double cellsize = sqrt(double(maxx - minx + 1) * double(maxy - miny + 1) / (2. * numsectors));
+	for (shift = MINCELLSHIFT; shift < MAXCELLSHIFT && (1 << shift) < cellsize; shift++);
+	for (;;)
+	{
+		width = int(((maxx - minx) >> shift) + 1);
+		height = int(((maxy - miny) >> shift) + 1);
+		if (int64_t(width) * height <= MAXCELLS || shift >= 30) break;
+		shift++;
+	}
+	originx = int(minx);
+	originy = int(miny);
+	cells.Resize(width * height);
+
+	for (int i = numsectors - 1; i >= 0; i--)
+	{
+		if (boxes[i].x1 <= boxes[i].x2) AddToCells(i, boxes[i], nullptr);
+	}
+	valid = true;
+}
+
+//==========================================================================
+//
+// Must be called when a wall of the given sector gets moved to (x, y).
+//
+//==========================================================================
+
+void SectorGrid::Extend(int sectnum, int x, int y)
+{
+	if (!valid || (unsigned)sectnum >= boxes.Size()) return;
+
+	auto& box = boxes[sectnum];
+	if (x >= box.x1 && x <= box.x2 && y >= box.y1 && y <= box.y2) return;
+
+	Box newbox = { min(box.x1, x), min(box.y1, y), max(box.x2, x), max(box.y2, y) };
+	if (!InGrid(newbox.x1, newbox.y1) || !InGrid(newbox.x2, newbox.y2))
+	{
+		// The grid's bounds need to change. Rebuild everything on the next lookup.
+		needsrebuild = true;
+	}
+	else if (!needsrebuild)
+	{
+		AddToCells(sectnum, newbox, box.x1 <= box.x2 ? &box : nullptr);
+	}
+	box = newbox;
+}
+
+void SectorGrid::ExtendSector(int sectnum)
+{
+	if (!valid || (unsigned)sectnum >= boxes.Size()) return;
+
+	auto wal = &wall[sector[sectnum].wallptr];
+	for (int w = 0; w < sector[sectnum].wallnum; w++, wal++)
+	{
+		Extend(sectnum, wal->x, wal->y);
+	}
+}
+
+//==========================================================================
+//
+// Returns the sectors that may contain the given point, in descending order,
+// or nullptr if the grid is not usable and the caller has to check all sectors.
+//
+//==========================================================================
+
+const TArray<int16_t>* SectorGrid::GetCandidates(int x, int y)
+{
+	if (!valid || boxes.Size() != (unsigned)numsectors) return nullptr;
+	if (needsrebuild)
+	{
+		Build();
+		if (!valid) return nullptr;
+	}
+	if (!InGrid(x, y)) return &emptycell;
+	return &cells[((y - originy) >> shift) * width + ((x - originx) >> shift)];
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+size_t SectorGrid::MemoryUsage() const
+{
+	size_t size = boxes.Size() * sizeof(Box) + cells.Size() * sizeof(cells[0]);
+	for (auto& cell : cells) size += cell.Size() * sizeof(int16_t);
+	return size;
+}
+
+//==========================================================================
+//
+// Micro benchmark: point-to-sector lookups with and without the grid.
+//
+//==========================================================================
+
+CCMD(bench_sectorgrid)
+{
+	if (numsectors <= 0)
+	{
+		Printf("No map loaded\n");
+		return;
+	}
+	int count = argv.argc() > 1 ? (int)strtoull(argv[1], nullptr, 0) : 100000;
+	if (count <= 0) count = 100000;
+
+	// use the map's bounds and a fixed seed so that results are comparable between runs.
+	int minx = INT32_MAX, miny = INT32_MAX, maxx = INT32_MIN, maxy = INT32_MIN;
+	for (int i = 0; i < numwalls; i++)
+	{
+		minx = min(minx, wall[i].x);
+		miny = min(miny, wall[i].y);
+		maxx = max(maxx, wall[i].x);
+		maxy = max(maxy, wall[i].y);
+	}
+	TArray<vec2_t> points(count, true);
+	uint32_t seed = 0x12345678;
+	for (auto& p : points)
+	{
+		seed = seed * 1664525 + 1013904223;
+		p.x = minx + int((uint64_t(seed >> 8) * (uint64_t(maxx) - minx + 1)) >> 24);
+		seed = seed * 1664525 + 1013904223;
+		p.y = miny + int((uint64_t(seed >> 8) * (uint64_t(maxy) - miny + 1)) >> 24);
+	}
+
+	TArray<int16_t> linear(count, true), grid(count, true);
+	cycle_t timer;
+
+	timer.Reset();
+	timer.Clock();
+	for (int n = 0; n < count; n++)
+	{
+		linear[n] = -1;
+		for (int i = numsectors - 1; i >= 0; --i)
+			if (inside_p(points[n].x, points[n].y, i))
+			{
+				linear[n] = i;
+				break;
+			}
+	}
+	timer.Unclock();
+	double lineartime = timer.TimeMS();
+
+	timer.Reset();
+	timer.Clock();
+	for (int n = 0; n < count; n++)
+	{
+		grid[n] = -1;
+		auto cands = sectorGrid.GetCandidates(points[n].x, points[n].y);
+		if (!cands) continue;
+		for (auto i : *cands)
+			if (inside_p(points[n].x, points[n].y, i))
+			{
+				grid[n] = i;
+				break;
+			}
+	}
+	timer.Unclock();
+	double gridtime = timer.TimeMS();
+
+	int mismatches = 0;
+	for (int n = 0; n < count; n++) if (linear[n] != grid[n]) mismatches++;
+
+	Printf("%d sectors, %d lookups, grid %dx%d cells of size %d, %zu bytes\n", numsectors, count,
+		sectorGrid.Width(), sectorGrid.Height(), sectorGrid.CellSize(), sectorGrid.MemoryUsage());
+	Printf("linear: %.3f ms (%.0f lookups/s)\n", lineartime, count * 1000. / max(lineartime, 0.001));
+	Printf("grid:   %.3f ms (%.0f lookups/s)\n", gridtime, count * 1000. / max(gridtime, 0.001));
+	if (mismatches) Printf(TEXTCOLOR_RED "%d results differ!\n", mismatches);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "tarray.h"
+
+//==========================================================================
+//
+// Uniform grid over the sector bounding boxes.
+// This replaces the linear scan over all sectors that updatesector and
+// updatesectorz fall back to when the neighborhood search fails.
+//
+// The boxes are only ever grown while the map runs, so a cell is
+// guaranteed to list every sector that can contain a point inside it,
+// as long as all code that moves walls reports it through Extend or
+// ExtendSector. Each cell's list is sorted in descending sector order
+// to return the same result as the linear scan it replaces.
+//
+//==========================================================================
+
+class SectorGrid
+{
+	struct Box
+	{
+		int x1, y1, x2, y2;
+	};
+
+	TArray<Box> boxes;
+	TArray<TArray<int16_t>> cells;
+	int originx = 0, originy = 0;
+	int shift = 0;
+	int width = 0, height = 0;
+	bool valid = false;
+	bool needsrebuild = false;
+
+	void AddToCells(int sectnum, const Box& newbox, const Box* oldbox);
+	bool InGrid(int x, int y) const
+	{
+		return x >= originx && y >= originy && ((int64_t(x) - originx) >> shift) < width && ((int64_t(y) - originy) >> shift) < height;
+	}
+
+public:
+	void Clear();
+	void Build();
+	void Extend(int sectnum, int x, int y);
+	void ExtendSector(int sectnum);
+	const TArray<int16_t>* GetCandidates(int x, int y);
+	size_t MemoryUsage() const;
+	int Width() const { return width; }
+	int Height() const { return height; }
+	int CellSize() const { return 1 << shift; }
+};
+
+extern SectorGrid sectorGrid;
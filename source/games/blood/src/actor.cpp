@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "build.h"
 #include "automap.h"
 #include "savegamehelp.h"
+#include "actorprofiler.h"
 
 #include "blood.h"
 
@@ -5684,6 +5685,7 @@ static void actCheckProximity()
 	while (auto actor = it.Next())
 	{
 		spritetype* pSprite = &actor->s();
+		ActorProfileScope profile(pSprite->type, pSprite->statnum);
 		if (pSprite->flags & 32) continue;
 
 		if (actor->hasX())
@@ -5793,6 +5795,7 @@ static void actCheckThings()
 	while (auto actor = it.Next())
 	{
 		spritetype* pSprite = &actor->s();
+		ActorProfileScope profile(pSprite->type, pSprite->statnum);
 
 		if (pSprite->flags & 32) continue;
 		if (!actor->hasX()) continue;
@@ -5908,6 +5911,7 @@ static void actCheckProjectiles()
 	while (auto actor = it.Next())
 	{
 		spritetype* pSprite = &actor->s();
+		ActorProfileScope profile(pSprite->type, pSprite->statnum);
 
 		if (pSprite->flags & 32)
 			continue;
@@ -5929,6 +5933,7 @@ static void actCheckExplosion()
 	while (auto actor = it.Next())
 	{
 		spritetype* pSprite = &actor->s();
+		ActorProfileScope profile(pSprite->type, pSprite->statnum);
 
 		if (pSprite->flags & 32)
 			continue;
@@ -6105,6 +6110,7 @@ static void actCheckTraps()
 	while (auto actor = it.Next())
 	{
 		spritetype* pSprite = &actor->s();
+		ActorProfileScope profile(pSprite->type, pSprite->statnum);
 
 		if ((pSprite->flags & 32) || !actor->hasX())
 			continue;
@@ -6158,6 +6164,7 @@ static void actCheckDudes()
 	while (auto actor = it.Next())
 	{
 		spritetype* pSprite = &actor->s();
+		ActorProfileScope profile(pSprite->type, pSprite->statnum);
 
 		if (pSprite->flags & 32)
 			continue;
@@ -6266,6 +6273,7 @@ static void actCheckDudes()
 	while (auto actor = it.Next())
 	{
 		spritetype* pSprite = &actor->s();
+		ActorProfileScope profile(pSprite->type, pSprite->statnum);
 		if (pSprite->flags & 32 || !actor->hasX()) continue;
 
 		int nSector = pSprite->sectnum;
@@ -6321,6 +6329,7 @@ void actCheckFlares()
 	while (auto actor = it.Next())
 	{
 		spritetype* pSprite = &actor->s();
+		ActorProfileScope profile(pSprite->type, pSprite->statnum);
 		if ((pSprite->flags & 32) || !actor->hasX()) continue;
 
 		XSPRITE* pXSprite = &actor->x();
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "build.h"
 #include "savegamehelp.h"
+#include "actorprofiler.h"
 
 #include "blood.h"
 
@@ -1501,6 +1502,68 @@ void RecoilDude(DBloodActor* actor)
     }
 }
 
+//---------------------------------------------------------------------------
+//
+// Checks which players the dude can see or hear and targets the first one.
+// The sight checks for all players in range are run as one batch; they
+// have no side effects, so the first match is the same as when checking
+// the players one by one.
+//
+//---------------------------------------------------------------------------
+
+static bool aiThinkPlayers(spritetype *pSprite, XSPRITE *pXSprite, DUDEINFO *pDudeInfo)
+{
+    PLAYER *players[kMaxPlayers];
+    CanSeeQuery queries[kMaxPlayers];
+    uint8_t seen[kMaxPlayers];
+    int nCount = 0;
+    for (int p = connecthead; p >= 0; p = connectpoint2[p])
+    {
+        PLAYER *pPlayer = &gPlayer[p];
+        if (pSprite->owner == pPlayer->nSprite || pPlayer->pXSprite->health == 0 || powerupCheck(pPlayer, kPwUpShadowCloak) > 0)
+            continue;
+        spritetype *pPlayerSprite = pPlayer->pSprite;
+        int nDist = approxDist(pPlayerSprite->x-pSprite->x, pPlayerSprite->y-pSprite->y);
+        if (nDist > pDudeInfo->seeDist && nDist > pDudeInfo->hearDist)
+            continue;
+        CanSeeQuery &q = queries[nCount];
+        q.start = { pPlayerSprite->x, pPlayerSprite->y, pPlayerSprite->z };
+        q.startsect = pPlayerSprite->sectnum;
+        q.end = { pSprite->x, pSprite->y, pSprite->z-((pDudeInfo->eyeHeight*pSprite->yrepeat)<<2) };
+        q.endsect = pSprite->sectnum;
+        players[nCount++] = pPlayer;
+    }
+    if (nCount == 0)
+        return false;
+    canseebatch(queries, nCount, seen);
+    for (int i = 0; i < nCount; i++)
+    {
+        if (!seen[i])
+            continue;
+        PLAYER *pPlayer = players[i];
+        int x = pPlayer->pSprite->x;
+        int y = pPlayer->pSprite->y;
+        int z = pPlayer->pSprite->z;
+        int dx = x-pSprite->x;
+        int dy = y-pSprite->y;
+        int nDist = approxDist(dx, dy);
+        int nDeltaAngle = ((getangle(dx,dy)+1024-pSprite->ang)&2047)-1024;
+        if (nDist < pDudeInfo->seeDist && abs(nDeltaAngle) <= pDudeInfo->periphery)
+        {
+            aiSetTarget_(pXSprite, pPlayer->nSprite);
+            aiActivateDude(&bloodActors[pXSprite->reference]);
+            return true;
+        }
+        else if (nDist < pDudeInfo->hearDist)
+        {
+            aiSetTarget_(pXSprite, x, y, z);
+            aiActivateDude(&bloodActors[pXSprite->reference]);
+            return true;
+        }
+    }
+    return false;
+}
+
 void aiThinkTarget(DBloodActor* actor)
 {
     auto pXSprite = &actor->x();
@@ -1509,36 +1572,8 @@ void aiThinkTarget(DBloodActor* actor)
     DUDEINFO *pDudeInfo = getDudeInfo(pSprite->type);
     if (Chance(pDudeInfo->alertChance))
     {
-        for (int p = connecthead; p >= 0; p = connectpoint2[p])
-        {
-            PLAYER *pPlayer = &gPlayer[p];
-            if (pSprite->owner == pPlayer->nSprite || pPlayer->pXSprite->health == 0 || powerupCheck(pPlayer, kPwUpShadowCloak) > 0)
-                continue;
-            int x = pPlayer->pSprite->x;
-            int y = pPlayer->pSprite->y;
-            int z = pPlayer->pSprite->z;
-            int nSector = pPlayer->pSprite->sectnum;
-            int dx = x-pSprite->x;
-            int dy = y-pSprite->y;
-            int nDist = approxDist(dx, dy);
-            if (nDist > pDudeInfo->seeDist && nDist > pDudeInfo->hearDist)
-                continue;
-            if (!cansee(x, y, z, nSector, pSprite->x, pSprite->y, pSprite->z-((pDudeInfo->eyeHeight*pSprite->yrepeat)<<2), pSprite->sectnum))
-                continue;
-            int nDeltaAngle = ((getangle(dx,dy)+1024-pSprite->ang)&2047)-1024;
-            if (nDist < pDudeInfo->seeDist && abs(nDeltaAngle) <= pDudeInfo->periphery)
-            {
-                aiSetTarget_(pXSprite, pPlayer->nSprite);
-                aiActivateDude(&bloodActors[pXSprite->reference]);
-                return;
-            }
-            else if (nDist < pDudeInfo->hearDist)
-            {
-                aiSetTarget_(pXSprite, x, y, z);
-                aiActivateDude(&bloodActors[pXSprite->reference]);
-                return;
-            }
-        }
+        if (aiThinkPlayers(pSprite, pXSprite, pDudeInfo))
+            return;
     }
 }
 
@@ -1548,36 +1583,8 @@ void aiLookForTarget(spritetype *pSprite, XSPRITE *pXSprite)
     DUDEINFO *pDudeInfo = getDudeInfo(pSprite->type);
     if (Chance(pDudeInfo->alertChance))
     {
-        for (int p = connecthead; p >= 0; p = connectpoint2[p])
-        {
-            PLAYER *pPlayer = &gPlayer[p];
-            if (pSprite->owner == pPlayer->nSprite || pPlayer->pXSprite->health == 0 || powerupCheck(pPlayer, kPwUpShadowCloak) > 0)
-                continue;
-            int x = pPlayer->pSprite->x;
-            int y = pPlayer->pSprite->y;
-            int z = pPlayer->pSprite->z;
-            int nSector = pPlayer->pSprite->sectnum;
-            int dx = x-pSprite->x;
-            int dy = y-pSprite->y;
-            int nDist = approxDist(dx, dy);
-            if (nDist > pDudeInfo->seeDist && nDist > pDudeInfo->hearDist)
-                continue;
-            if (!cansee(x, y, z, nSector, pSprite->x, pSprite->y, pSprite->z-((pDudeInfo->eyeHeight*pSprite->yrepeat)<<2), pSprite->sectnum))
-                continue;
-            int nDeltaAngle = ((getangle(dx,dy)+1024-pSprite->ang)&2047)-1024;
-            if (nDist < pDudeInfo->seeDist && abs(nDeltaAngle) <= pDudeInfo->periphery)
-            {
-                aiSetTarget_(pXSprite, pPlayer->nSprite);
-                aiActivateDude(&bloodActors[pXSprite->reference]);
-                return;
-            }
-            else if (nDist < pDudeInfo->hearDist)
-            {
-                aiSetTarget_(pXSprite, x, y, z);
-                aiActivateDude(&bloodActors[pXSprite->reference]);
-                return;
-            }
-        }
+        if (aiThinkPlayers(pSprite, pXSprite, pDudeInfo))
+            return;
         if (pXSprite->state)
         {
             uint8_t sectmap[(kMaxSectors+7)>>3];
@@ -1613,6 +1620,7 @@ void aiProcessDudes(void) {
     {
         spritetype *pSprite = &sprite[nSprite];
         if (pSprite->flags & 32) continue;
+        ActorProfileScope profile(pSprite->type, pSprite->statnum);
         int nXSprite = pSprite->extra;
         XSPRITE *pXSprite = &xsprite[nXSprite]; 
         DUDEINFO *pDudeInfo = getDudeInfo(pSprite->type);
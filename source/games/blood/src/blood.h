@@ -112,6 +112,8 @@ struct GameInterface : public ::GameInterface
 	const char* Name() override { return "Blood"; }
 	void app_init() override;
 	void SerializeGameState(FSerializer& arc) override;
+	void GetRandomState(TArray<int32_t>& state) override;
+	void SetRandomState(const TArray<int32_t>& state) override;
 	void loadPalette() override;
 	void clearlocalinputstate() override;
 	bool GenerateSavePic() override;
@@ -34,6 +34,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "gamefuncs.h"
 #include "hw_sections.h"
 #include "sectorgeometry.h"
+#include "sectorgrid.h"
+#include "hw_levelaabbtree.h"
 
 #include "blood.h"
 
@@ -515,9 +517,9 @@ void dbLoadMap(const char *pPath, int *pX, int *pY, int *pZ, short *pAngle, shor
     gModernMap = false;
     #endif
 
-    memset(sector, 0, sizeof(*sector) * MAXSECTORS);
-    memset(wall, 0, sizeof(*wall) * MAXWALLS);
-    memset(sprite, 0, sizeof(*sector) * MAXSPRITES);
+    clearMapArrays();
+    memset(sprite, 0, sizeof(*sprite) * MAXSPRITES);
+    sectorGrid.Clear();
 
 #ifdef USE_OPENGL
     Polymost::Polymost_prepare_loadboard();
@@ -1071,8 +1073,11 @@ void dbLoadMap(const char *pPath, int *pX, int *pY, int *pZ, short *pAngle, shor
     setWallSectors();
     hw_BuildSections();
     sectorGeometry.SetSize(numsections);
-    memcpy(wallbackup, wall, sizeof(wallbackup));
-    memcpy(sectorbackup, sector, sizeof(sectorbackup));
+    sectorGeometry.LoadCache(md4);
+    sectorGrid.Build();
+    levelAABBTree.Clear();
+    memcpy(wallbackup, wall, sizeof(*wall) * numwalls);
+    memcpy(sectorbackup, sector, sizeof(*sector) * numsectors);
 }
 
 
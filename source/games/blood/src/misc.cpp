@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include <stdio.h>
 #include <string.h>
+#include <random>
 #include "blood.h"
 
 BEGIN_BLD_NS
@@ -52,5 +53,26 @@ void wsrand(int seed)
     wRandSeed = seed;
 }
 
+#ifdef NOONE_EXTENSIONS
+extern std::default_random_engine gStdRandom;
+#endif
+
+void GameInterface::GetRandomState(TArray<int32_t>& state)
+{
+    state.Push(randSeed);
+    state.Push(wRandSeed);
+}
+
+void GameInterface::SetRandomState(const TArray<int32_t>& state)
+{
+    if (state.Size() < 2) return;
+    randSeed = state[0];
+    wRandSeed = state[1];
+#ifdef NOONE_EXTENSIONS
+    // the modern types' generator is truly random in single player, so it has to be given a fixed start here.
+    gStdRandom.seed(state[0] ^ state[1]);
+#endif
+}
+
 
 END_BLD_NS
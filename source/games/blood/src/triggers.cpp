@@ -25,6 +25,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include <random>
 
 #include "build.h"
+#include "sectorgrid.h"
+#include "sectorgeometry.h"
 #include "compat.h"
 
 #include "blood.h"
@@ -779,10 +781,11 @@ void PathSound(int nSector, int nSound)
 
 void DragPoint(int nWall, int x, int y)
 {
-    sector[wall[nWall].sector].dirty = 255; 
+    sectorGeometry.MarkDirty(wall[nWall].sector);
     viewInterpolateWall(nWall, &wall[nWall]);
     wall[nWall].x = x;
     wall[nWall].y = y;
+    sectorGrid.Extend(wall[nWall].sector, x, y);
 
     int vsi = numwalls;
     int vb = nWall;
@@ -791,10 +794,11 @@ void DragPoint(int nWall, int x, int y)
         if (wall[vb].nextwall >= 0)
         {
             vb = wall[wall[vb].nextwall].point2;
-            sector[wall[vb].sector].dirty = 255;
+            sectorGeometry.MarkDirty(wall[vb].sector);
             viewInterpolateWall(vb, &wall[vb]);
             wall[vb].x = x;
             wall[vb].y = y;
+            sectorGrid.Extend(wall[vb].sector, x, y);
         }
         else
         {
@@ -804,10 +808,11 @@ void DragPoint(int nWall, int x, int y)
                 if (wall[lastwall(vb)].nextwall >= 0)
                 {
                     vb = wall[lastwall(vb)].nextwall;
-                    sector[wall[vb].sector].dirty = 255;
+                    sectorGeometry.MarkDirty(wall[vb].sector);
                     viewInterpolateWall(vb, &wall[vb]);
                     wall[vb].x = x;
                     wall[vb].y = y;
+                    sectorGrid.Extend(wall[vb].sector, x, y);
                 }
                 else
                     break;
@@ -1,6 +1,7 @@
 #include "src/actors.cpp"
 #include "src/ccmds.cpp"
 #include "src/cheats.cpp"
+#include "src/conprofile.cpp"
 #include "src/d_menu.cpp"
 #include "src/dispatch.cpp"
 #include "src/game.cpp"
@@ -45,6 +45,7 @@ This file is a combination of code from the following sources:
 #include "stats.h"
 #include "constants.h"
 #include "dukeactor.h"
+#include "actorprofiler.h"
 
 BEGIN_DUKE_NS
 
@@ -359,6 +360,7 @@ void movedummyplayers(void)
 	DukeStatIterator iti(STAT_DUMMYPLAYER);
 	while (auto act = iti.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		if (!act->GetOwner()) continue;
 		p = act->GetOwner()->PlayerIndex();
 		auto spri = act->s;
@@ -406,6 +408,7 @@ void moveplayers(void)
 	DukeStatIterator iti(STAT_PLAYER);
 	while (auto act = iti.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		int pn = act->PlayerIndex();
 		auto p = &ps[pn];
 		auto spri = act->s;
@@ -550,6 +553,7 @@ void movefx(void)
 	DukeStatIterator iti(STAT_FX);
 	while (auto act = iti.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto spri = act->s;
 		switch (spri->picnum)
 		{
@@ -39,6 +39,7 @@ This file contains parts of DukeGDX by Alexander Makarov-[M210] (m210-2007@mail.
 #include "names_d.h"
 #include "serializer.h"
 #include "dukeactor.h"
+#include "actorprofiler.h"
 
 BEGIN_DUKE_NS
 
@@ -706,12 +707,18 @@ void movefta_d(void)
 {
 	int x, px, py, sx, sy;
 	short p, psect, ssect;
-	int j;
+
+	// The sight checks of all sleeping actors are collected first and run as
+	// one batch. cansee has no side effects and the random numbers are still
+	// drawn in actor order, so the result is the same as checking one by one.
+	TArray<DDukeActor*> woken;
+	TArray<CanSeeQuery> queries;
 
 	DukeStatIterator iti(STAT_ZOMBIEACTOR);
 
 	while (auto act = iti.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto s = act->s;
 		p = findplayer(act, &x);
 
@@ -725,6 +732,7 @@ void movefta_d(void)
 				act->timetosleep++;
 				if (act->timetosleep >= (x >> 8))
 				{
+					CanSeeQuery q;
 					if (badguy(act))
 					{
 						px = ps[p].oposx + 64 - (krand() & 127);
@@ -744,47 +752,20 @@ void movefta_d(void)
 
 						int r1 = krand();
 						int r2 = krand();
-						j = cansee(sx, sy, s->z - (r2 % (52 << 8)), s->sectnum, px, py, ps[p].oposz - (r1 % (32 << 8)), ps[p].cursectnum);
+						q.start = { sx, sy, s->z - (r2 % (52 << 8)) };
+						q.end = { px, py, ps[p].oposz - (r1 % (32 << 8)) };
 					}
 					else
 					{
 						int r1 = krand();
 						int r2 = krand();
-						j = cansee(s->x, s->y, s->z - ((r2 & 31) << 8), s->sectnum, ps[p].oposx, ps[p].oposy, ps[p].oposz - ((r1 & 31) << 8), ps[p].cursectnum);
+						q.start = { s->x, s->y, s->z - ((r2 & 31) << 8) };
+						q.end = { ps[p].oposx, ps[p].oposy, ps[p].oposz - ((r1 & 31) << 8) };
 					}
-
-
-					if (j) switch(s->picnum)
-					{
-						case RUBBERCAN:
-						case EXPLODINGBARREL:
-						case WOODENHORSE:
-						case HORSEONSIDE:
-						case CANWITHSOMETHING:
-						case CANWITHSOMETHING2:
-						case CANWITHSOMETHING3:
-						case CANWITHSOMETHING4:
-						case FIREBARREL:
-						case FIREVASE:
-						case NUKEBARREL:
-						case NUKEBARRELDENTED:
-						case NUKEBARRELLEAKED:
-						case TRIPBOMB:
-							if (sector[s->sectnum].ceilingstat&1)
-								s->shade = sector[s->sectnum].ceilingshade;
-							else s->shade = sector[s->sectnum].floorshade;
-
-							act->timetosleep = 0;
-							changespritestat(act, STAT_STANDABLE);
-							break;
-
-						default:
-							act->timetosleep = 0;
-							check_fta_sounds_d(act);
-							changespritestat(act, STAT_ACTOR);
-							break;
-					}
-					else act->timetosleep = 0;
+					q.startsect = s->sectnum;
+					q.endsect = ps[p].cursectnum;
+					queries.Push(q);
+					woken.Push(act);
 				}
 			}
 			if (badguy(act))
@@ -795,6 +776,47 @@ void movefta_d(void)
 			}
 		}
 	}
+
+	if (queries.Size() == 0) return;
+	TArray<uint8_t> seen(queries.Size(), true);
+	canseebatch(queries.Data(), queries.Size(), seen.Data());
+
+	for (unsigned i = 0; i < woken.Size(); i++)
+	{
+		auto act = woken[i];
+		auto s = act->s;
+		if (seen[i]) switch(s->picnum)
+		{
+			case RUBBERCAN:
+			case EXPLODINGBARREL:
+			case WOODENHORSE:
+			case HORSEONSIDE:
+			case CANWITHSOMETHING:
+			case CANWITHSOMETHING2:
+			case CANWITHSOMETHING3:
+			case CANWITHSOMETHING4:
+			case FIREBARREL:
+			case FIREVASE:
+			case NUKEBARREL:
+			case NUKEBARRELDENTED:
+			case NUKEBARRELLEAKED:
+			case TRIPBOMB:
+				if (sector[s->sectnum].ceilingstat&1)
+					s->shade = sector[s->sectnum].ceilingshade;
+				else s->shade = sector[s->sectnum].floorshade;
+
+				act->timetosleep = 0;
+				changespritestat(act, STAT_STANDABLE);
+				break;
+
+			default:
+				act->timetosleep = 0;
+				check_fta_sounds_d(act);
+				changespritestat(act, STAT_ACTOR);
+				break;
+		}
+		else act->timetosleep = 0;
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -944,6 +966,7 @@ void movefallers_d(void)
 	DukeStatIterator iti(STAT_FALLER);
 	while (auto act = iti.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto s = act->s;
 		sect = s->sectnum;
 
@@ -1423,6 +1446,7 @@ void movestandables_d(void)
 	DukeStatIterator it(STAT_STANDABLE);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		int picnum = act->s->picnum;
 
 		if (act->s->sectnum < 0)
@@ -1928,6 +1952,7 @@ void moveweapons_d(void)
 	DukeStatIterator it(STAT_PROJECTILE);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		if (act->s->sectnum < 0)
 		{
 			deletesprite(act);
@@ -1991,6 +2016,7 @@ void movetransports_d(void)
 	DukeStatIterator iti(STAT_TRANSPORT);
 	while (auto act = iti.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto spr = act->s;
 		auto Owner = act->GetOwner();
 		
@@ -3040,6 +3066,7 @@ void moveactors_d(void)
 	DukeStatIterator it(STAT_ACTOR);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto s = act->s;
 		sect = s->sectnum;
 
@@ -3261,6 +3288,7 @@ void moveexplosions_d(void)  // STATNUM 5
 	DukeStatIterator it(STAT_MISC);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto s = act->s;
 		int* t = &act->temp_data[0];
 		sect = s->sectnum;
@@ -3596,6 +3624,7 @@ void moveeffectors_d(void)   //STATNUM 3
 	DukeStatIterator it(STAT_EFFECTOR);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto sc = &sector[act->s->sectnum];
 		switch (act->s->lotag)
 		{
@@ -31,6 +31,7 @@ Prepared for public release: 03/21/2003 - Charlie Wiederhold, 3D Realms
 #include "names_r.h"
 #include "mapinfo.h"
 #include "dukeactor.h"
+#include "actorprofiler.h"
 
 BEGIN_DUKE_NS
 
@@ -531,6 +532,7 @@ void movefta_r(void)
 	DukeStatIterator it(STAT_ZOMBIEACTOR);
 	while(auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto s = act->s;
 		p = findplayer(act, &x);
 		j = 0;
@@ -800,6 +802,7 @@ void movefallers_r(void)
 	DukeStatIterator it(STAT_FALLER);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto s = act->s;
 		int sect = s->sectnum;
 
@@ -998,6 +1001,7 @@ void movestandables_r(void)
 	DukeStatIterator it(STAT_STANDABLE);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		int picnum = act->s->picnum;
 
 		if (act->s->sectnum < 0)
@@ -1509,6 +1513,7 @@ void moveweapons_r(void)
 	DukeStatIterator it(STAT_PROJECTILE);
 	while (auto proj = it.Next())
 	{
+		ActorProfileScope profile(proj->s->picnum, proj->s->statnum);
 		if (proj->s->sectnum < 0)
 		{
 			deletesprite(proj);
@@ -1577,6 +1582,7 @@ void movetransports_r(void)
 	DukeStatIterator iti(STAT_TRANSPORT);
 	while (auto act = iti.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto spr = act->s;
 		sect = spr->sectnum;
 		sectlotag = sector[sect].lotag;
@@ -2849,6 +2855,7 @@ void moveactors_r(void)
 	DukeStatIterator it(STAT_ACTOR);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto s = act->s;
 		bool deleteafterexecute = false;	// taking a cue here from RedNukem to not run scripts on deleted sprites.
 		auto sect = s->sectnum;
@@ -3117,6 +3124,7 @@ void moveexplosions_r(void)  // STATNUM 5
 	DukeStatIterator it(STAT_MISC);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto s = act->s;
 		t = &act->temp_data[0];
 		sect = s->sectnum;
@@ -3460,6 +3468,7 @@ void moveeffectors_r(void)   //STATNUM 3
 	DukeStatIterator it(STAT_EFFECTOR);
 	while (auto act = it.Next())
 	{
+		ActorProfileScope profile(act->s->picnum, act->s->statnum);
 		auto sc = &sector[act->s->sectnum];
 		int st = act->s->lotag;
 		int sh = act->s->hitag;
@@ -10,6 +10,7 @@ BEGIN_DUKE_NS
 enum EConCommands
 {
 #include "condef.h"
+	concmd_max
 };
 
 #undef cmd
@@ -0,0 +1,179 @@
+//-------------------------------------------------------------------------
+/*
+Copyright (C) 2026 - agent
+
+This is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+//-------------------------------------------------------------------------
+
+#include <algorithm>
+#include "ns.h"
+#include "concmd.h"
+#include "conprofile.h"
+#include "c_dispatch.h"
+#include "i_time.h"
+#include "printf.h"
+#include "tarray.h"
+#include "zstring.h"
+
+BEGIN_DUKE_NS
+
+//---------------------------------------------------------------------------
+//
+// Opcode profiler for the CON interpreter. Records how often each command
+// runs, its inclusive and exclusive time and which command preceded it.
+// The most frequent pairs are the candidates for fused instructions.
+//
+//---------------------------------------------------------------------------
+
+#define cmd(a) #a,
+#define cmdx(a, b) b,
+#define cmda(a,b)
+
+static const char* const conCommandNames[] =
+{
+#include "condef.h"
+};
+
+#undef cmd
+#undef cmdx
+#undef cmda
+
+struct ConProfileEntry
+{
+	uint64_t count;
+	int64_t inclusive;
+	int64_t exclusive;
+};
+
+bool conprofiling;
+static ConProfileEntry conprofile[concmd_max];
+static TArray<uint32_t> conpairs;	// concmd_max * concmd_max counters of consecutive commands.
+static int64_t conchildtime;
+static int conlastcmd = -1;
+
+ConProfileScope::ConProfileScope(int command)
+{
+	cmd = (unsigned)command < concmd_max ? command : -1;
+	if (cmd >= 0)
+	{
+		if (conlastcmd >= 0) conpairs[conlastcmd * concmd_max + cmd]++;
+		conlastcmd = cmd;
+	}
+	parentchildtime = conchildtime;
+	conchildtime = 0;
+	start = int64_t(I_nsTime());
+}
+
+ConProfileScope::~ConProfileScope()
+{
+	int64_t elapsed = int64_t(I_nsTime()) - start;
+	if (cmd >= 0)
+	{
+		auto& entry = conprofile[cmd];
+		entry.count++;
+		entry.inclusive += elapsed;
+		entry.exclusive += elapsed - conchildtime;
+	}
+	conchildtime = parentchildtime + elapsed;
+}
+
+//---------------------------------------------------------------------------
+//
+//
+//
+//---------------------------------------------------------------------------
+
+static void ResetConProfile()
+{
+	memset(conprofile, 0, sizeof(conprofile));
+	conpairs.Resize(concmd_max * concmd_max);
+	memset(conpairs.Data(), 0, conpairs.Size() * sizeof(uint32_t));
+	conchildtime = 0;
+	conlastcmd = -1;
+}
+
+static void DumpConProfile(int limit)
+{
+	TArray<int> order;
+	uint64_t total = 0;
+	int64_t totaltime = 0;
+	for (int i = 0; i < concmd_max; i++)
+	{
+		if (conprofile[i].count == 0) continue;
+		order.Push(i);
+		total += conprofile[i].count;
+		totaltime += conprofile[i].exclusive;
+	}
+	if (order.Size() == 0)
+	{
+		Printf("No CON commands recorded\n");
+		return;
+	}
+	std::sort(order.begin(), order.end(), [](int a, int b) { return conprofile[a].exclusive > conprofile[b].exclusive; });
+
+	Printf("%llu commands, %.3f ms\n", (unsigned long long)total, totaltime * 1e-6);
+	Printf("%-20s %12s %10s %10s %8s %6s\n", "command", "count", "self ms", "incl ms", "self ns", "self %");
+	for (unsigned i = 0; i < order.Size() && (int)i < limit; i++)
+	{
+		auto& e = conprofile[order[i]];
+		Printf("%-20s %12llu %10.3f %10.3f %8.1f %6.2f\n", conCommandNames[order[i]], (unsigned long long)e.count,
+			e.exclusive * 1e-6, e.inclusive * 1e-6, double(e.exclusive) / e.count,
+			e.exclusive * 100. / std::max<int64_t>(totaltime, 1));
+	}
+
+	TArray<int> pairs;
+	for (unsigned i = 0; i < conpairs.Size(); i++) if (conpairs[i]) pairs.Push(i);
+	std::sort(pairs.begin(), pairs.end(), [](int a, int b) { return conpairs[a] > conpairs[b]; });
+	Printf("\n%-41s %12s\n", "command pair", "count");
+	for (unsigned i = 0; i < pairs.Size() && (int)i < limit; i++)
+	{
+		FString pair;
+		pair.Format("%s, %s", conCommandNames[pairs[i] / concmd_max], conCommandNames[pairs[i] % concmd_max]);
+		Printf("%-41s %12u\n", pair.GetChars(), conpairs[pairs[i]]);
+	}
+}
+
+CCMD(con_profile)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: con_profile start|stop|reset|dump [count]\n");
+		return;
+	}
+	if (!stricmp(argv[1], "start"))
+	{
+		if (conpairs.Size() == 0) ResetConProfile();
+		conprofiling = true;
+	}
+	else if (!stricmp(argv[1], "stop"))
+	{
+		conprofiling = false;
+		conlastcmd = -1;
+	}
+	else if (!stricmp(argv[1], "reset"))
+	{
+		ResetConProfile();
+	}
+	else if (!stricmp(argv[1], "dump"))
+	{
+		int limit = argv.argc() > 2 ? (int)strtol(argv[2], nullptr, 0) : 30;
+		DumpConProfile(limit > 0 ? limit : 30);
+	}
+}
+
+END_DUKE_NS
@@ -0,0 +1,20 @@
+#pragma once
+
+BEGIN_DUKE_NS
+
+extern bool conprofiling;
+
+// Records one executed CON command while 'con_profile' is active.
+// Commands nested in an if's block run within their parent's scope,
+// so their time gets subtracted from the parent's exclusive time.
+struct ConProfileScope
+{
+	int cmd;
+	int64_t start;
+	int64_t parentchildtime;
+
+	ConProfileScope(int cmd);
+	~ConProfileScope();
+};
+
+END_DUKE_NS
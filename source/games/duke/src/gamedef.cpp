@@ -47,6 +47,13 @@ Modifications for JonoF's port by Jonathon Fowler (jf@jonof.id.au)
 #include "conlabel.h"
 #include "conlabeldef.h"
 #include "gi.h"
+#include "superfasthash.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "m_crc32.h"
+#include "i_specialpaths.h"
+#include "version.h"
+#include "files.h"
 
 extern TArray<TPointer<MapRecord>> mapList;
 
@@ -133,6 +140,19 @@ class ConCompiler
 	int casecount = 0;
 	int casescriptptr;
 
+	// Everything needed to recreate the compiler's output from the cache.
+	// Declarations with side effects outside the compiled code get stored as source and are executed again.
+	struct SourceRecord
+	{
+		FString name;
+		uint32_t size, crc;
+	};
+	TArray<SourceRecord> sources;
+	TArray<char> declarations;
+	TArray<int> actorrecords;	// tile, script address, added flags
+	TArray<int> tilerecords;	// tile, load event address
+	bool validateonly = false;	// parse the declarations without applying them, to check a cache before anything of it gets installed.
+
 
 	void ReportError(int error);
 	int getkeyword(const char* text);
@@ -150,12 +170,17 @@ class ConCompiler
 	int transnum(int type);
 	void checkforkeyword();
 	int parsecommand();
+	int parsecommand(int tw);
+	void addsource(const char* name, const TArray<uint8_t>& data);
 
 	// EDuke 2.x additions
 	int CountCaseStatements();
 
 public:
 	void compilecon(const char* filenam);
+	void compilebuffer(char* text);
+	bool loadcache(const TArray<FString>& roots, int gametype);
+	void savecache(const TArray<FString>& roots, int gametype);
 	void setmusic();
 	int getErrorCount() { return errorcount; }
 };
@@ -190,6 +215,85 @@ struct labeldef
 static TArray<labeldef> labels;
 TArray<int> ScriptCode;
 
+//---------------------------------------------------------------------------
+//
+// Hashed name lookup for the keyword and label tables.
+// Only the first entry of a given name gets added, which is the one
+// the old linear searches would have returned.
+//
+//---------------------------------------------------------------------------
+
+class SymbolHash
+{
+	TArray<int> buckets;	// first entry in each bucket, or -1
+	TArray<int> chain;		// next entry in the same bucket, indexed by entry
+	unsigned count = 0;
+	const char* (*getname)(int index);
+	bool nocase;
+
+	unsigned Hash(const char* text) const
+	{
+		size_t len = strlen(text);
+		return nocase ? SuperFastHashI(text, len) : SuperFastHash(text, len);
+	}
+
+	bool Match(int index, const char* text) const
+	{
+		return (nocase ? stricmp(getname(index), text) : strcmp(getname(index), text)) == 0;
+	}
+
+	void Insert(int index)
+	{
+		if ((unsigned)index >= chain.Size()) chain.Resize(index + 1);
+		auto& bucket = buckets[Hash(getname(index)) & (buckets.Size() - 1)];
+		chain[index] = bucket;
+		bucket = index;
+	}
+
+	void Rehash(unsigned size)
+	{
+		TArray<int> entries;
+		for (auto head : buckets)
+		{
+			for (int i = head; i >= 0; i = chain[i]) entries.Push(i);
+		}
+		buckets.Resize(size);
+		for (auto& b : buckets) b = -1;
+		for (auto i : entries) Insert(i);
+	}
+
+public:
+	SymbolHash(const char* (*func)(int), bool ignorecase) : getname(func), nocase(ignorecase) {}
+
+	void Clear()
+	{
+		buckets.Clear();
+		chain.Clear();
+		count = 0;
+	}
+
+	int Find(const char* text) const
+	{
+		if (count == 0) return -1;
+		for (int i = buckets[Hash(text) & (buckets.Size() - 1)]; i >= 0; i = chain[i])
+		{
+			if (Match(i, text)) return i;
+		}
+		return -1;
+	}
+
+	void Add(int index)
+	{
+		if (Find(getname(index)) >= 0) return;
+		if (count >= buckets.Size() / 2) Rehash(max(256u, buckets.Size() * 2));
+		Insert(index);
+		count++;
+	}
+};
+
+static SymbolHash labelHash([](int i) -> const char* { return labels[i].GetChars(); }, false);
+static SymbolHash labelHashI([](int i) -> const char* { return labels[i].GetChars(); }, true);
+
 //---------------------------------------------------------------------------
 //
 // synthesize the instruction list
@@ -215,16 +319,12 @@ static ConCommand cmdList[] =
 #undef cmdx
 #undef cmda
 
-static int cmdCmp(const void *a, const void *b)
-{
-	auto A = (ConCommand*)a;
-	auto B = (ConCommand*)b;
-	return strcmp(A->cmd, B->cmd);
-}
+static SymbolHash cmdHash([](int i) -> const char* { return cmdList[i].cmd; }, false);
 
-void SortCommands()
+void InitCommandHash()
 {
-	qsort(cmdList, countof(cmdList), sizeof(ConCommand), cmdCmp);
+	if (cmdHash.Find(cmdList[0].cmd) >= 0) return;
+	for (unsigned i = 0; i < countof(cmdList); i++) cmdHash.Add(i);
 }
 
 //---------------------------------------------------------------------------
@@ -303,34 +403,14 @@ void ConCompiler::ReportError(int error)
 
 //---------------------------------------------------------------------------
 //
-// binary search for keyword
+// hashed lookup for keyword
 //
 //---------------------------------------------------------------------------
 
 int ConCompiler::getkeyword(const char* text)
 {
-	ptrdiff_t min = 0;
-	ptrdiff_t max = countof(cmdList) - 1;
-	
-	while (min <= max)
-	{
-		auto mid = (min + max) >> 1;
-		const int comp = strcmp(text, cmdList[mid].cmd);
-		
-		if (comp == 0)
-		{
-			return cmdList[mid].instr;
-		}
-		else if (comp > 0)
-		{
-			min = mid + 1;
-		}
-		else
-		{
-			max = mid - 1;
-		}
-	}
-	return -1; 
+	int index = cmdHash.Find(text);
+	return index < 0 ? -1 : cmdList[index].instr;
 }
 
 //---------------------------------------------------------------------------
@@ -353,24 +433,9 @@ FString ConCompiler::translatelabeltype(int type)
 
 int findlabel(const char* text, bool ignorecase = false)
 {
-	for (unsigned j = 0; j < labels.Size(); j++)
-	{
-		if (labels[j].compare(text) == 0)
-		{
-			return j;
-		}
-	}
-	if (ignorecase)
-	{
-		for (unsigned j = 0; j < labels.Size(); j++)
-		{
-			if (labels[j].name.comparei(text) == 0)
-			{
-				return j;
-			}
-		}
-	}
-	return -1;
+	int j = labelHash.Find(text);
+	if (j < 0 && ignorecase) j = labelHashI.Find(text);
+	return j;
 }
 
 // This is for the 'spawn' CCMD.
@@ -592,6 +657,8 @@ void ConCompiler::appendlabelvalue(labeltypes type, int value)
 	labels.Last().type = type;
 	labels.Last().name = parselabel;
 	labels.Last().value = value;
+	labelHash.Add(labels.Size() - 1);
+	labelHashI.Add(labels.Size() - 1);
 }
 
 void ConCompiler::appendlabeladdress(labeltypes type, int offset)
@@ -697,25 +764,23 @@ int ConCompiler::transnum(int type)
 	}
 
 
-	for (unsigned i = 0; i < labels.Size(); i++)
+	int i = findlabel(parsebuf);
+	if (i >= 0)
 	{
-		if (labels[i].compare(parsebuf) == 0)
+		// Non-values can be compared with 0.
+		if (labels[i].type & type || (labels[i].value == 0))
 		{
-			// Non-values can be compared with 0.
-			if (labels[i].type & type || (labels[i].value == 0))
-			{
-				appendscriptvalue(labels[i].value);
-				textptr += l;
-				return labels[i].value;
-			}
-			appendscriptvalue(0);
+			appendscriptvalue(labels[i].value);
 			textptr += l;
-			auto el = translatelabeltype(type);
-			auto gl = translatelabeltype(labels[i].type);
-			const char* fn = fileSystem.GetFileFullName(currentsourcefile);
-			Printf(TEXTCOLOR_YELLOW "  * WARNING.(%s, line %d) %s: Expected a '%s' label but found a '%s' label instead.\n", fn, line_number, labels[i].GetChars(), el.GetChars(), gl.GetChars());
-			return -1;  // valid label name, but wrong type
+			return labels[i].value;
 		}
+		appendscriptvalue(0);
+		textptr += l;
+		auto el = translatelabeltype(type);
+		auto gl = translatelabeltype(labels[i].type);
+		const char* fn = fileSystem.GetFileFullName(currentsourcefile);
+		Printf(TEXTCOLOR_YELLOW "  * WARNING.(%s, line %d) %s: Expected a '%s' label but found a '%s' label instead.\n", fn, line_number, labels[i].GetChars(), el.GetChars(), gl.GetChars());
+		return -1;  // valid label name, but wrong type
 	}
 
 	if (isdigit(*textptr) == 0 && *textptr != '-')
@@ -820,6 +885,35 @@ int ConCompiler::CountCaseStatements()
 //---------------------------------------------------------------------------
 
 int ConCompiler::parsecommand()
+{
+	// Do not count warnings here and allow more errors before bailing out.
+	if ((errorcount) > 64 || (*textptr == '\0') || (*(textptr + 1) == '\0')) return 1;
+	char* start = textptr;
+	int tw = transword();
+
+	switch (tw)
+	{
+	case concmd_definelevelname:
+	case concmd_definevolumename:
+	case concmd_defineskillname:
+	case concmd_definequote:
+	case concmd_definesound:
+	case concmd_music:
+	case concmd_gamestartup:
+	case concmd_gamevar:
+	{
+		int res = parsecommand(tw);
+		unsigned len = unsigned(textptr - start);
+		memcpy(&declarations[declarations.Reserve(len)], start, len);
+		declarations.Push('\n');
+		return res;
+	}
+	default:
+		return parsecommand(tw);
+	}
+}
+
+int ConCompiler::parsecommand(int tw)
 {
 	const char* fn = fileSystem.GetFileFullName(currentsourcefile);
 	int i, j, k;
@@ -829,10 +923,6 @@ int ConCompiler::parsecommand()
 	int temp_current_file;
 	int lnum;
 
-	// Do not count warnings here and allow more errors before bailing out.
-	if ((errorcount) > 64 || (*textptr == '\0') || (*(textptr + 1) == '\0')) return 1;
-	int tw = transword();
-
 	switch (tw)
 	{
 	default:
@@ -915,7 +1005,7 @@ int ConCompiler::parsecommand()
 			Printf(TEXTCOLOR_RED "  * WARNING.(%s, line %d) Variable Name '%s' too int (max is %d)\n", fn, line_number, parselabel.GetChars(), MAXVARLABEL - 1);
 			return 0;
 		}
-		int res = AddGameVar(parselabel, j, lnum & (~(GAMEVAR_FLAG_DEFAULT | GAMEVAR_FLAG_SECRET)));
+		int res = validateonly ? 0 : AddGameVar(parselabel, j, lnum & (~(GAMEVAR_FLAG_DEFAULT | GAMEVAR_FLAG_SECRET)));
 		if (res < 0)
 		{
 			errorcount++;
@@ -983,14 +1073,12 @@ int ConCompiler::parsecommand()
 
 			checkforkeyword();
 
-			for (i = 0; i < (int)labels.Size(); i++)
-				if (labels[i].compare(parselabel) == 0)
-				{
-					warningcount++;
-					Printf(TEXTCOLOR_RED "  * WARNING.(%s, line %d) Duplicate move '%s' ignored.\n", fn, line_number, parselabel.GetChars());
-					break;
-				}
-			if (i == (int)labels.Size())
+			if (findlabel(parselabel) >= 0)
+			{
+				warningcount++;
+				Printf(TEXTCOLOR_RED "  * WARNING.(%s, line %d) Duplicate move '%s' ignored.\n", fn, line_number, parselabel.GetChars());
+			}
+			else
 				appendlabeladdress(LABEL_MOVE);
 			for (j = 0; j < 2; j++)
 			{
@@ -1009,7 +1097,7 @@ int ConCompiler::parsecommand()
 		popscriptvalue();
 		transnum(LABEL_DEFINE); // Volume Number (0/4)
 		k = popscriptvalue() - 1;
-		if (k < 0) specialmusic.Clear();
+		if (k < 0 && !validateonly) specialmusic.Clear();
 
 		i = 0;
 		// get the file name...
@@ -1036,7 +1124,7 @@ int ConCompiler::parsecommand()
 				tempMusic.Last().levlnum = i + 1;
 				tempMusic.Last().music = parsebuffer.Data();
 			}
-			else
+			else if (!validateonly)
 			{
 				specialmusic.Push(parsebuffer.Data());
 			}
@@ -1077,6 +1165,7 @@ int ConCompiler::parsecommand()
 		}
 
 		auto data = fileSystem.GetFileData(fni, 1);
+		addsource(parsebuffer.Data(), data);
 
 		temp_current_file = currentsourcefile;
 		currentsourcefile = fni;
@@ -1199,14 +1288,19 @@ int ConCompiler::parsecommand()
 		lnum = popscriptvalue();
 
 		gs.actorinfo[lnum].scriptaddress = parsing_actor;	// TRANSITIONAL should only store an index
+		k = 0;
 		if (tw == concmd_useractor)
 		{
 			if (j & 1)
-				gs.actorinfo[lnum].flags |= SFLAG_BADGUY;
+				k |= SFLAG_BADGUY;
 
 			if (j & 2)
-				gs.actorinfo[lnum].flags |= (SFLAG_BADGUY | SFLAG_BADGUYSTAYPUT);
+				k |= (SFLAG_BADGUY | SFLAG_BADGUYSTAYPUT);
+			gs.actorinfo[lnum].flags |= k;
 		}
+		actorrecords.Push(lnum);
+		actorrecords.Push(parsing_actor);
+		actorrecords.Push(k);
 
 		for (j = 0; j < 4; j++)
 		{
@@ -1676,6 +1770,7 @@ int ConCompiler::parsecommand()
 			textptr++, i++;
 		}
 		parsebuffer.Push(0);
+		if (validateonly) return 0;
 		// We need both a volume and a cluster for this new episode.
 		auto vol = MustFindVolume(j);
 		auto clust = MustFindCluster(j + 1);
@@ -1708,7 +1803,7 @@ int ConCompiler::parsecommand()
 			textptr++, i++;
 		}
 		parsebuffer.Push(0);
-		gSkillNames[j] = FStringTable::MakeMacro(parsebuffer.Data(), i);
+		if (!validateonly) gSkillNames[j] = FStringTable::MakeMacro(parsebuffer.Data(), i);
 		return 0;
 
 	case concmd_definelevelname:
@@ -1728,10 +1823,11 @@ int ConCompiler::parsecommand()
 			textptr++, i++;
 		}
 		parsebuffer.Push(0);
-		auto map = FindMapByIndexOnly(j + 1, k + 1);
+		MapRecord scratch;
+		auto map = validateonly ? &scratch : FindMapByIndexOnly(j + 1, k + 1);
 		if (!map) map = AllocateMap();
 		map->SetFileName(parsebuffer.Data());
-		if (k == 0)
+		if (k == 0 && !validateonly)
 		{
 			auto vol = MustFindVolume(j);
 			vol->startmap = map->labelName;
@@ -1750,7 +1846,7 @@ int ConCompiler::parsecommand()
 			(((*(textptr + 0) - '0') * 10 + (*(textptr + 1) - '0')) * 60) +
 			(((*(textptr + 3) - '0') * 10 + (*(textptr + 4) - '0')));
 
-		SetLevelNum(map, makelevelnum(j + 1, k + 1));
+		if (!validateonly) SetLevelNum(map, makelevelnum(j + 1, k + 1));
 
 		map->cluster = j + 1;
 
@@ -1789,7 +1885,7 @@ int ConCompiler::parsecommand()
 			textptr++, i++;
 		}
 		parsebuffer.Push(0);
-		quoteMgr.InitializeQuote(k, parsebuffer.Data(), true);
+		if (!validateonly) quoteMgr.InitializeQuote(k, parsebuffer.Data(), true);
 		return 0;
 	case concmd_definesound:
 	{
@@ -1817,7 +1913,7 @@ int ConCompiler::parsecommand()
 		int m = popscriptvalue();
 		transnum(LABEL_DEFINE);
 		int vo = popscriptvalue();
-		S_DefineSound(k, parsebuffer.Data(), ps, pe, pr, m, vo, 1.f);
+		if (!validateonly) S_DefineSound(k, parsebuffer.Data(), ps, pe, pr, m, vo, 1.f);
 		return 0;
 	}
 
@@ -1914,6 +2010,12 @@ int ConCompiler::parsecommand()
 		}
 		int pget = 0;
 
+		if (validateonly)
+		{
+			popscriptvalue();
+			return 0;
+		}
+
 		if (!isRR())
 		{
 			if (pcount == 30) g_gameType |= GAMEFLAG_PLUTOPAK;
@@ -1991,6 +2093,8 @@ int ConCompiler::parsecommand()
 		transnum(LABEL_DEFINE);
 		int n = popscriptvalue();
 		gs.tileinfo[n].loadeventscriptptr = parsing_actor;
+		tilerecords.Push(n);
+		tilerecords.Push(parsing_actor);
 		checking_ifelse = 0;
 		return 0;
 	}
@@ -3104,22 +3208,381 @@ void ConCompiler::compilecon(const char *filenam)
 	}
 	Printf("Compiling: '%s'.\n", filenam);
 	auto data = fileSystem.GetFileData(currentsourcefile, 1);
-	textptr = (char*)data.Data();
-
-	line_number = 1;
-	errorcount = warningcount = 0;
-
-	while (parsecommand() == 0);
+	addsource(filenam, data);
+	compilebuffer((char*)data.Data());
 
 	if ((errorcount) > 64)
 		Printf(TEXTCOLOR_RED  "  * ERROR! Too many errors.");
 	else if (warningcount || errorcount)
 		Printf(TEXTCOLOR_ORANGE "Found %d warning(s), %d error(s).\n", warningcount, errorcount);
 	if (errorcount > 0) I_FatalError("Failed to compile %s", filenam);
+}
+
+void ConCompiler::compilebuffer(char* text)
+{
+	textptr = text;
+	line_number = 1;
+	errorcount = warningcount = 0;
 
+	while (parsecommand() == 0);
+}
 
-	// Install the crosshair toggle messages in the CVAR.
-	cl_crosshair.SetToggleMessages(quoteMgr.GetRawQuote(QUOTE_CROSSHAIR_OFF), quoteMgr.GetRawQuote(QUOTE_CROSSHAIR_OFF-1));
+//==========================================================================
+//
+// Compiled CON cache
+//
+// Stores the compiler's output keyed by the game and the root CON files.
+// The cache is only used if every source file that went into it is
+// still found under the same name with identical content.
+// The game type in the key is the one from before compiling, because
+// gamestartup adds the Atomic and World Tour flags to it.
+//
+//==========================================================================
+
+CVARD(Bool, con_cache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG, "store compiled CONs on disk to speed up startup")
+
+static const char ConCacheMagic[4] = { 'D', 'C', 'O', 'N' };
+enum { CONCACHEVERSION = 1 };
+
+// The key the CONs of the running game were looked up with, for concache_check.
+static TArray<FString> conCacheRoots;
+static int conCacheGameType;
+
+void ConCompiler::addsource(const char* name, const TArray<uint8_t>& data)
+{
+	sources.Push({ name, data.Size(), CalcCRC32(data.Data(), data.Size()) });
+}
+
+static FString ConCacheFileName(const TArray<FString>& roots, int gametype, bool create)
+{
+	FString key;
+	key.Format("%d", gametype);
+	for (auto& root : roots) key << "|" << root;
+
+	FString path = M_GetCachePath(create);
+	path << "/concache";
+	if (create) CreatePath(path);
+	path.AppendFormat("/%08x.dcon", CalcCRC32((const uint8_t*)key.GetChars(), key.Len()));
+	return path;
+}
+
+class ConCacheWriter
+{
+public:
+	TArray<uint8_t> buffer;
+
+	void Write(const void* data, size_t size)
+	{
+		if (size > 0) memcpy(&buffer[buffer.Reserve(size)], data, size);
+	}
+	void WriteInt(int v)
+	{
+		Write(&v, 4);
+	}
+	void WriteString(const char* text)
+	{
+		int len = (int)strlen(text);
+		WriteInt(len);
+		Write(text, len);
+	}
+};
+
+class ConCacheReader
+{
+	const uint8_t* p;
+	const uint8_t* end;
+
+public:
+	bool ok = true;
+
+	ConCacheReader(const TArray<uint8_t>& buffer) : p(buffer.Data()), end(buffer.Data() + buffer.Size()) {}
+
+	void Read(void* data, size_t size)
+	{
+		if (!ok || size_t(end - p) < size)
+		{
+			ok = false;
+			memset(data, 0, size);
+			return;
+		}
+		memcpy(data, p, size);
+		p += size;
+	}
+	int ReadInt()
+	{
+		int v;
+		Read(&v, 4);
+		return v;
+	}
+	unsigned ReadCount(unsigned elementsize)
+	{
+		unsigned count = ReadInt();
+		if (!ok || elementsize == 0 || count > size_t(end - p) / elementsize)
+		{
+			ok = false;
+			return 0;
+		}
+		return count;
+	}
+	FString ReadString()
+	{
+		unsigned len = ReadCount(1);
+		FString str((const char*)p, len);
+		p += len;
+		return str;
+	}
+	bool AtEnd() const { return ok && p == end; }
+};
+
+//==========================================================================
+//
+// Checks that a cache file belongs to this game and that all its
+// sources are unchanged.
+//
+//==========================================================================
+
+static bool CheckConCacheHeader(ConCacheReader& r, const TArray<FString>& roots, int gametype)
+{
+	char magic[4];
+	r.Read(magic, 4);
+	if (!r.ok || memcmp(magic, ConCacheMagic, 4) || r.ReadInt() != CONCACHEVERSION) return false;
+	if (r.ReadString().Compare(GetVersionString()) || r.ReadInt() != gametype) return false;
+
+	if (r.ReadCount(4) != roots.Size()) return false;
+	for (auto& root : roots)
+	{
+		if (r.ReadString().Compare(root)) return false;
+	}
+
+	// Check that every file still looks the same.
+	unsigned numsources = r.ReadCount(12);
+	for (unsigned i = 0; i < numsources; i++)
+	{
+		auto name = r.ReadString();
+		uint32_t size = r.ReadInt();
+		uint32_t crc = r.ReadInt();
+		if (!r.ok) return false;
+		int lump = fileSystem.FindFile(name);
+		if (lump < 0) return false;
+		auto data = fileSystem.GetFileData(lump, 1);
+		if (data.Size() != size || CalcCRC32(data.Data(), data.Size()) != crc) return false;
+	}
+	return true;
+}
+
+void ConCompiler::savecache(const TArray<FString>& roots, int gametype)
+{
+	if (!con_cache) return;
+
+	ConCacheWriter w;
+	w.Write(ConCacheMagic, 4);
+	w.WriteInt(CONCACHEVERSION);
+	w.WriteString(GetVersionString());
+	w.WriteInt(gametype);
+
+	w.WriteInt(roots.Size());
+	for (auto& root : roots) w.WriteString(root);
+
+	w.WriteInt(sources.Size());
+	for (auto& source : sources)
+	{
+		w.WriteString(source.name);
+		w.WriteInt(source.size);
+		w.WriteInt(source.crc);
+	}
+
+	w.WriteInt(ScriptCode.Size());
+	w.Write(ScriptCode.Data(), ScriptCode.Size() * sizeof(int));
+
+	w.WriteInt(labels.Size());
+	for (auto& label : labels)
+	{
+		w.WriteString(label.GetChars());
+		w.WriteInt(label.type);
+		w.WriteInt(label.value);
+	}
+
+	w.WriteInt(MAXGAMEEVENTS);
+	for (int i = 0; i < MAXGAMEEVENTS; i++) w.WriteInt((int)apScriptGameEvent[i]);
+
+	w.WriteInt(actorrecords.Size());
+	w.Write(actorrecords.Data(), actorrecords.Size() * sizeof(int));
+	w.WriteInt(tilerecords.Size());
+	w.Write(tilerecords.Data(), tilerecords.Size() * sizeof(int));
+	w.WriteInt(declarations.Size());
+	w.Write(declarations.Data(), declarations.Size());
+
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(ConCacheFileName(roots, gametype, true)));
+	if (fw) fw->Write(w.buffer.Data(), w.buffer.Size());
+}
+
+bool ConCompiler::loadcache(const TArray<FString>& roots, int gametype)
+{
+	if (!con_cache) return false;
+
+	FileReader fr;
+	if (!fr.OpenFile(ConCacheFileName(roots, gametype, false))) return false;
+	auto buffer = fr.Read();
+	fr.Close();
+
+	ConCacheReader r(buffer);
+	if (!CheckConCacheHeader(r, roots, gametype)) return false;
+
+	TArray<int> code(r.ReadCount(4), true);
+	r.Read(code.Data(), code.Size() * sizeof(int));
+
+	TArray<labeldef> newlabels(r.ReadCount(12), true);
+	for (auto& label : newlabels)
+	{
+		label.name = r.ReadString();
+		label.type = (labeltypes)r.ReadInt();
+		label.value = r.ReadInt();
+	}
+
+	intptr_t events[MAXGAMEEVENTS];
+	if (r.ReadInt() != MAXGAMEEVENTS) return false;
+	for (auto& ev : events) ev = r.ReadInt();
+
+	TArray<int> newactors(r.ReadCount(4), true);
+	r.Read(newactors.Data(), newactors.Size() * sizeof(int));
+	TArray<int> newtiles(r.ReadCount(4), true);
+	r.Read(newtiles.Data(), newtiles.Size() * sizeof(int));
+	TArray<char> decl(r.ReadCount(1), true);
+	r.Read(decl.Data(), decl.Size());
+	if (!r.AtEnd() || newactors.Size() % 3 || newtiles.Size() % 2) return false;
+	for (unsigned i = 0; i < newactors.Size(); i += 3)
+	{
+		if ((unsigned)newactors[i] >= MAXTILES) return false;
+	}
+	for (unsigned i = 0; i < newtiles.Size(); i += 2)
+	{
+		if ((unsigned)newtiles[i] >= MAXTILES) return false;
+	}
+
+	// Install the compiled data and run the declarations again. They only use the labels and must not emit any code.
+	// The compiler's own output gets reset if the cache is rejected, but the declarations change state all over
+	// the engine, so they are parsed once without applying anything to make sure the replay will go through.
+	ScriptCode = std::move(code);
+	labels = std::move(newlabels);
+	for (unsigned i = 0; i < labels.Size(); i++)
+	{
+		labelHash.Add(i);
+		labelHashI.Add(i);
+	}
+	unsigned codesize = ScriptCode.Size();
+	decl.Push(0);
+	decl.Push(0);
+	TArray<char> check = decl;
+	validateonly = true;
+	compilebuffer(check.Data());
+	validateonly = false;
+	tempMusic.Clear();
+	if (errorcount || ScriptCode.Size() != codesize)
+	{
+		Printf(TEXTCOLOR_ORANGE "Compiled CON cache is not usable, recompiling.\n");
+		return false;
+	}
+	compilebuffer(decl.Data());
+
+	memcpy(apScriptGameEvent, events, sizeof(events));
+	for (unsigned i = 0; i < newactors.Size(); i += 3)
+	{
+		gs.actorinfo[newactors[i]].scriptaddress = newactors[i + 1];
+		gs.actorinfo[newactors[i]].flags |= newactors[i + 2];
+	}
+	for (unsigned i = 0; i < newtiles.Size(); i += 2)
+	{
+		gs.tileinfo[newtiles[i]].loadeventscriptptr = newtiles[i + 1];
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Reads back the cache file for the running game and checks that the
+// next start will accept it and get the same script code.
+//
+//==========================================================================
+
+CCMD(concache_check)
+{
+	if (conCacheRoots.Size() == 0)
+	{
+		Printf("No CONs loaded\n");
+		return;
+	}
+	Printf("Game type %x at startup, %x after compiling\n", conCacheGameType, g_gameType);
+
+	FileReader fr;
+	if (!fr.OpenFile(ConCacheFileName(conCacheRoots, conCacheGameType, false)))
+	{
+		Printf(TEXTCOLOR_RED "No compiled CON cache for this game\n");
+		return;
+	}
+	auto buffer = fr.Read();
+	fr.Close();
+
+	ConCacheReader r(buffer);
+	if (!CheckConCacheHeader(r, conCacheRoots, conCacheGameType))
+	{
+		Printf(TEXTCOLOR_RED "Compiled CON cache would be rejected\n");
+		return;
+	}
+	TArray<int> code(r.ReadCount(4), true);
+	r.Read(code.Data(), code.Size() * sizeof(int));
+	if (!r.ok || code.Size() != ScriptCode.Size() || memcmp(code.Data(), ScriptCode.Data(), code.Size() * sizeof(int)))
+	{
+		Printf(TEXTCOLOR_RED "Compiled CON cache does not match the loaded script\n");
+		return;
+	}
+	Printf("Compiled CON cache matches the loaded script\n");
+}
+
+//==========================================================================
+//
+// Compiles a synthetic script with lots of labels to measure the
+// symbol lookup cost. The real compiler output is restored afterward.
+//
+//==========================================================================
+
+CCMD(bench_concompile)
+{
+	int count = argv.argc() > 1 ? (int)strtoull(argv[1], nullptr, 0) : 50000;
+	if (count <= 0) count = 50000;
+
+	// each define refers to the one before, so every line does one lookup for a new and one for an existing label.
+	FString script = "define BENCHLABEL0 1\n";
+	for (int i = 1; i < count; i++) script.AppendFormat("define BENCHLABEL%d BENCHLABEL%d\n", i, i - 1);
+	script += "\n";
+
+	auto savedlabels = std::move(labels);
+	auto savedcode = std::move(ScriptCode);
+	labels.Clear();
+	labelHash.Clear();
+	labelHashI.Clear();
+	ScriptCode.Clear();
+	ScriptCode.Push(0);
+	InitCommandHash();
+
+	ConCompiler comp;
+	cycle_t timer;
+	timer.Reset();
+	timer.Clock();
+	comp.compilebuffer(script.LockBuffer());
+	timer.Unclock();
+	script.UnlockBuffer();
+
+	Printf("%u labels compiled in %.2f ms, %d errors\n", labels.Size(), timer.TimeMS(), comp.getErrorCount());
+
+	labels = std::move(savedlabels);
+	ScriptCode = std::move(savedcode);
+	labelHash.Clear();
+	labelHashI.Clear();
+	for (unsigned i = 0; i < labels.Size(); i++)
+	{
+		labelHash.Add(i);
+		labelHashI.Add(i);
+	}
 }
 
 //==========================================================================
@@ -3202,44 +3665,65 @@ void loadcons()
 	gs.displayflags = DUKE3D_NO_WIDESCREEN_PINNING;
 
 
-	ScriptCode.Clear();
-	labels.Clear();
-
-	SortCommands();
-
-	ClearGameEvents();
-	ClearGameVars();
-	AddSystemVars();
-
-	auto before = I_nsTime();
-
-	ScriptCode.Push(0);
-	ConCompiler comp;
-
+	TArray<FString> roots;
 	if (fileSystem.FileExists("engine/engine.con"))
 	{
-		comp.compilecon("engine/engine.con");
+		roots.Push("engine/engine.con");
 	}
-
-	comp.compilecon(ConFile()); //Tokenize
-
+	roots.Push(ConFile());
 	if (userConfig.AddCons) for (FString& m : *userConfig.AddCons.get())
 	{
-		comp.compilecon(m);
+		roots.Push(m);
 	}
-	ScriptCode.ShrinkToFit();
-	labels.ShrinkToFit();
 	userConfig.AddCons.reset();
-	setscriptvalue(0, scriptpos());
 
-	if (comp.getErrorCount())
+	auto before = I_nsTime();
+	auto resetoutput = []()
+	{
+		ScriptCode.Clear();
+		labels.Clear();
+		labelHash.Clear();
+		labelHashI.Clear();
+
+		ClearGameEvents();
+		ClearGameVars();
+		AddSystemVars();
+	};
+
+	InitCommandHash();
+	resetoutput();
+
+	// gamestartup adds the Atomic and World Tour flags, so saving and loading must both use the game type from before compiling.
+	int gametype = g_gameType;
+	conCacheRoots = roots;
+	conCacheGameType = gametype;
+
+	auto comp = std::make_unique<ConCompiler>();
+	bool fromcache = comp->loadcache(roots, gametype);
+	if (!fromcache)
+	{
+		resetoutput();
+		comp = std::make_unique<ConCompiler>();
+
+		ScriptCode.Push(0);
+		for (auto& root : roots)
+		{
+			comp->compilecon(root); //Tokenize
+		}
+		ScriptCode.ShrinkToFit();
+		labels.ShrinkToFit();
+		setscriptvalue(0, scriptpos());
+	}
+
+	if (comp->getErrorCount())
 	{
 		I_FatalError("Failed to compile CONs.");
 	}
 	else
 	{
+		if (!fromcache) comp->savecache(roots, gametype);
 		auto after = I_nsTime();
-		Printf("Compilation time:%.2f ms, Code Size:%u bytes. %u labels. %d/%d Variables.\n", (after-before) / 1000000.,
+		Printf("%s time:%.2f ms, Code Size:%u bytes. %u labels. %d/%d Variables.\n", fromcache? "Compiled CON cache load" : "Compilation", (after-before) / 1000000.,
 			(ScriptCode.Size() << 2) - 4,
 			labels.Size(),
 			0,//iGameVarCount,
@@ -3247,12 +3731,15 @@ void loadcons()
 		);
 	}
 
+	// Install the crosshair toggle messages in the CVAR.
+	cl_crosshair.SetToggleMessages(quoteMgr.GetRawQuote(QUOTE_CROSSHAIR_OFF), quoteMgr.GetRawQuote(QUOTE_CROSSHAIR_OFF-1));
+
 	// These can only be retrieved AFTER loading the scripts.
 	InitGameVarPointers();
 	ResetSystemDefaults();
 	S_WorldTourMappingsForOldSounds(); // create a sound mapping for World Tour.
 	S_CacheAllSounds();
-	comp.setmusic();
+	comp->setmusic();
 
 	// RR must link the last map of E1 to the first map of E2.
 	if (isRR()) for (auto& map : mapList)
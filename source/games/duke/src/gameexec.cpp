@@ -40,6 +40,7 @@ source as it is released.
 #include "conlabel.h"
 #include "automap.h"
 #include "dukeactor.h"
+#include "conprofile.h"
 
 BEGIN_DUKE_NS
 
@@ -77,6 +78,7 @@ struct ParseState
 	Collision coll;
 
 	int parse(void);
+	int parseone(void);
 	void parseifelse(int condition);
 };
 
@@ -1494,9 +1496,24 @@ static bool ifcansee(DDukeActor* actor, int pnum)
 }
 
 
-// int *it = 0x00589a04;
+//---------------------------------------------------------------------------
+//
+// The opcode profiler in conprofile.cpp hooks in here, so that with
+// profiling off the interpreter only pays for one branch per command.
+//
+//---------------------------------------------------------------------------
 
 int ParseState::parse(void)
+{
+	if (!conprofiling) return parseone();
+
+	ConProfileScope scope(*insptr);
+	return parseone();
+}
+
+// int *it = 0x00589a04;
+
+int ParseState::parseone(void)
 {
 	int j, l, s;
 	auto g_sp = g_ac? g_ac->s : nullptr;
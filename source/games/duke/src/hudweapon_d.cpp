@@ -1183,8 +1183,8 @@ void displayweapon_d(int snum, double smoothratio)
 				static const uint8_t cat_frames[] = { 0, 0, 1, 1, 2, 2 };
 				if (p->GetActor()->s->pal != 1)
 				{
-					weapon_xoffset += krand() & 1;
-					looking_arc += krand() & 1;
+					weapon_xoffset += rand() & 1;
+					looking_arc += rand() & 1;
 				}
 				gun_pos -= 16;
 				hud_drawpal(weapon_xoffset + 210 - look_anghalf, looking_arc + 261 - gun_pos, FLAMETHROWER + 1, -32, o, pal);
@@ -178,14 +178,14 @@ void displayweapon_r(int snum, double smoothratio)
 				shade = 0;
 				if (*kb == 1)
 				{
-					if ((krand()&1) == 1)
+					if ((rand()&1) == 1)
 						temp_kb = MOTOHIT+1;
 					else
 						temp_kb = MOTOHIT+2;
 				}
 				else if (*kb == 4)
 				{
-					if ((krand()&1) == 1)
+					if ((rand()&1) == 1)
 						temp_kb = MOTOHIT+3;
 					else
 						temp_kb = MOTOHIT+4;
@@ -458,7 +458,7 @@ void displayweapon_r(int snum, double smoothratio)
 						rdmyospal((weapon_xoffset + 210) - look_anghalf,
 							looking_arc + 222 - gun_pos, RPGGUN2 + 7, shade, o |  pin, pal);
 					}
-					else if ((krand() & 15) == 5)
+					else if ((rand() & 15) == 5)
 					{
 						S_PlayActorSound(327, p->GetActor());
 						rdmyospal((weapon_xoffset + 210) - look_anghalf,
@@ -1051,7 +1051,7 @@ void enterlevel(MapRecord *mi, int gamemode)
 	setLevelStarted(mi);
     if (isRRRA() && ps[screenpeek].sea_sick_stat == 1)
     {
-        for (int i = 0; i < MAXWALLS; i++)
+        for (int i = 0; i < numwalls; i++)
         {
             if (wall[i].picnum == 7873 || wall[i].picnum == 7870)
                 StartInterpolation(i, Interp_Wall_PanX);
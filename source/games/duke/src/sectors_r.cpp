@@ -202,7 +202,7 @@ void animatewalls_r(void)
 
 	if (isRRRA() &&ps[screenpeek].sea_sick_stat == 1)
 	{
-		for (i = 0; i < MAXWALLS; i++)
+		for (i = 0; i < numwalls; i++)
 		{
 			if (wall[i].picnum == RRTILE7873)
 				wall[i].addxpan(6);
@@ -46,6 +46,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "cheathandler.h"
 #include "inputstate.h"
 #include "d_protocol.h"
+#include "d_net.h"
 #include "texturemanager.h"
 #include "razemenu.h"
 #include "v_draw.h"
@@ -321,6 +322,8 @@ void GameInterface::Ticker()
 	}
     else if (EndLevel == 0)
     {
+        // demos must run off the command stream, not whatever was last polled from the input devices.
+        if (demorecording || demoplayback) localInput = playercmds[nLocalPlayer].ucmd;
         inita &= kAngleMask;
 
         for (int i = 0; i < 4; i++)
@@ -219,6 +219,8 @@ struct GameInterface : public ::GameInterface
     const char* Name() override { return "Exhumed"; }
     void app_init() override;
     void clearlocalinputstate() override;
+    void GetRandomState(TArray<int32_t>& state) override;
+    void SetRandomState(const TArray<int32_t>& state) override;
     void loadPalette() override;
 	bool GenerateSavePic() override;
     void MenuOpened() override;
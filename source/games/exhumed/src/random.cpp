@@ -43,6 +43,21 @@ void InitRandom()
     randC = 0x1010101;
 }
 
+void GameInterface::GetRandomState(TArray<int32_t>& state)
+{
+    state.Push(randA);
+    state.Push(randB);
+    state.Push(randC);
+}
+
+void GameInterface::SetRandomState(const TArray<int32_t>& state)
+{
+    if (state.Size() < 3) return;
+    randA = state[0];
+    randB = state[1];
+    randC = state[2];
+}
+
 // TODO - checkme
 int RandomBit()
 {
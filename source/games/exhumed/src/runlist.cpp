@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "aistuff.h"
 #include "player.h"
 #include "sound.h"
+#include "actorprofiler.h"
 #include <assert.h>
 
 BEGIN_PS_NS
@@ -279,6 +280,7 @@ void runlist_SendMessageToRunRec(int nRun, int nMessage, int nDamage)
     assert(nFunc < kFuncMax); // REMOVE
 
     // do function pointer call here.
+    ActorProfileScope profile(nFunc, nMessage >> 16);
     aiFunctions[nFunc](nMessage, nDamage, nRun);
 }
 
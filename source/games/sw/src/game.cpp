@@ -228,6 +228,24 @@ void GameInterface::app_init()
     InitFX();
 }
 
+//---------------------------------------------------------------------------
+//
+// The game logic only uses randomseed, which the engine takes care of.
+// The effects based on STD_RANDOM use the C library's generator, whose
+// state cannot be read, so it gets a start value instead.
+//
+//---------------------------------------------------------------------------
+
+void GameInterface::GetRandomState(TArray<int32_t>& state)
+{
+    state.Push(randomseed);
+}
+
+void GameInterface::SetRandomState(const TArray<int32_t>& state)
+{
+    if (state.Size() > 0) srand(state[0]);
+}
+
 //---------------------------------------------------------------------------
 //
 //
@@ -2234,6 +2234,8 @@ struct GameInterface : public ::GameInterface
 {
     const char* Name() override { return "ShadowWarrior"; }
     void app_init() override;
+    void GetRandomState(TArray<int32_t>& state) override;
+    void SetRandomState(const TArray<int32_t>& state) override;
     void LoadGameTextures();
     void loadPalette();
     void clearlocalinputstate() override;
@@ -30,6 +30,7 @@ Prepared for public release: 03/28/2005 - Charlie Wiederhold, 3D Realms
 
 #include "game.h"
 #include "interpso.h"
+#include "sectorgeometry.h"
 #include "serializer.h"
 #include "names2.h"
 
@@ -78,10 +79,10 @@ static int &getvalue(int element, bool write)
     switch (type)
     {
     case soi_wallx:
-        if (write) sector[wall[index].sector].dirty = 255;
+        if (write) sectorGeometry.MarkDirty(wall[index].sector);
         return wall[index].x;
     case soi_wally:
-        if (write) sector[wall[index].sector].dirty = 255;
+        if (write) sectorGeometry.MarkDirty(wall[index].sector);
         return wall[index].y;
     case soi_ceil:
         return sector[index].ceilingz;
@@ -181,11 +181,19 @@ int testquadinsect(int *point_num, vec2_t const * q, short sectnum)
         }
     }
 
+    // All four edges start in the same sector, so they can be traced together.
+    CanSeeQuery edges[4];
+    uint8_t cansee_edge[4];
     for (i=0; i<4; i++)
     {
         next_i = MOD4(i+1);
-        if (!cansee(q[i].x, q[i].y,0x3fffffff, sectnum,
-                    q[next_i].x, q[next_i].y,0x3fffffff, sectnum))
+        edges[i] = { { q[i].x, q[i].y, 0x3fffffff }, { q[next_i].x, q[next_i].y, 0x3fffffff }, sectnum, sectnum };
+    }
+    canseebatch(edges, 4, cansee_edge);
+
+    for (i=0; i<4; i++)
+    {
+        if (!cansee_edge[i])
         {
             return false;
         }
@@ -25,6 +25,7 @@ Prepared for public release: 03/28/2005 - Charlie Wiederhold, 3D Realms
 //-------------------------------------------------------------------------
 #include "ns.h"
 #include "build.h"
+#include "sectorgrid.h"
 
 #include "names2.h"
 #include "panel.h"
@@ -407,6 +408,7 @@ int DoSlidorMoveWalls(short SpriteNum, int amt)
                 wall[pw].x -= amt;
                 wall[wall[w].point2].x -= amt;
                 wall[wall[wall[w].point2].point2].x -= amt;
+                sectorGrid.ExtendSector(wall[w].sector);
             }
             else
             {
@@ -431,6 +433,7 @@ int DoSlidorMoveWalls(short SpriteNum, int amt)
                 wall[pw].x += amt;
                 wall[wall[w].point2].x += amt;
                 wall[wall[wall[w].point2].point2].x += amt;
+                sectorGrid.ExtendSector(wall[w].sector);
             }
             else
             {
@@ -454,6 +457,7 @@ int DoSlidorMoveWalls(short SpriteNum, int amt)
                 wall[pw].y -= amt;
                 wall[wall[w].point2].y -= amt;
                 wall[wall[wall[w].point2].point2].y -= amt;
+                sectorGrid.ExtendSector(wall[w].sector);
             }
             else
             {
@@ -476,6 +480,7 @@ int DoSlidorMoveWalls(short SpriteNum, int amt)
                 wall[pw].y += amt;
                 wall[wall[w].point2].y += amt;
                 wall[wall[wall[w].point2].point2].y += amt;
+                sectorGrid.ExtendSector(wall[w].sector);
             }
             else
             {
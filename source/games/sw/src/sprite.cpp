@@ -25,6 +25,8 @@ Prepared for public release: 03/28/2005 - Charlie Wiederhold, 3D Realms
 //-------------------------------------------------------------------------
 #include "ns.h"
 #include "build.h"
+#include "sectorgrid.h"
+#include "actorprofiler.h"
 
 #include "names2.h"
 #include "panel.h"
@@ -1665,6 +1667,7 @@ void PreMapCombineFloors(void)
             {
                 wall[j].x += dx;
                 wall[j].y += dy;
+                sectorGrid.Extend(dasect, wall[j].x, wall[j].y);
 
                 nextsector = wall[j].nextsector;
                 if (nextsector < 0) continue;
@@ -6717,6 +6720,7 @@ SpriteControl(void)
     StatIterator it(STAT_MISC);
     while ((i = it.NextIndex()) >= 0)
     {
+        ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
 #if INLINE_STATE
         ASSERT(User[i].Data());
         u = User[i].Data();
@@ -6738,6 +6742,7 @@ SpriteControl(void)
             StatIterator it(stat);
             while ((i = it.NextIndex()) >= 0)
             {
+                ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
 #if INLINE_STATE
                 ASSERT(User[i].Data());
                 u = User[i].Data();
@@ -6759,6 +6764,7 @@ SpriteControl(void)
         StatIterator it(STAT_ENEMY);
         while ((i = it.NextIndex()) >= 0)
         {
+            ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
             ASSERT(User[i].Data());
 
             u = User[i].Data();
@@ -6813,6 +6819,7 @@ SpriteControl(void)
             StatIterator it(stat);
             while ((i = it.NextIndex()) >= 0)
             {
+                ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
 #if INLINE_STATE
                 ASSERT(User[i].Data());
                 u = User[i].Data();
@@ -6831,6 +6838,7 @@ SpriteControl(void)
     it.Reset(STAT_NO_STATE);
     while ((i = it.NextIndex()) >= 0)
     {
+        ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
         if (User[i].Data() && User[i]->ActorActionFunc)
             (*User[i]->ActorActionFunc)(i);
         ASSERT(it.PeekIndex() >= 0 ? sprite[it.PeekIndex()].statnum != MAXSTATUS : true);
@@ -6841,6 +6849,7 @@ SpriteControl(void)
         it.Reset(STAT_STATIC_FIRE);
         while ((i = it.NextIndex()) >= 0)
         {
+            ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
             extern int DoStaticFlamesDamage(short SpriteNum);
             ASSERT(User[i].Data());
             DoStaticFlamesDamage(i);
@@ -6852,6 +6861,7 @@ SpriteControl(void)
         it.Reset(STAT_WALLBLOOD_QUEUE);
         while ((i = it.NextIndex()) >= 0)
         {
+            ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
             ASSERT(User[i].Data());
             u = User[i].Data();
             sp = User[i]->SpriteP;
@@ -6866,6 +6876,7 @@ SpriteControl(void)
     it.Reset(STAT_VATOR);
     while ((i = it.NextIndex()) >= 0)
     {
+        ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
         u = User[i].Data();
 
         if (u == 0)
@@ -6887,6 +6898,7 @@ SpriteControl(void)
     it.Reset(STAT_SPIKE);
     while ((i = it.NextIndex()) >= 0)
     {
+        ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
         u = User[i].Data();
 
         if (u->Tics)
@@ -6909,6 +6921,7 @@ SpriteControl(void)
     it.Reset(STAT_ROTATOR);
     while ((i = it.NextIndex()) >= 0)
     {
+        ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
         u = User[i].Data();
 
         if (u->Tics)
@@ -6928,6 +6941,7 @@ SpriteControl(void)
     it.Reset(STAT_SLIDOR);
     while ((i = it.NextIndex()) >= 0)
     {
+        ActorProfileScope profile(sprite[i].picnum, sprite[i].statnum);
         u = User[i].Data();
 
         if (u->Tics)
@@ -25,6 +25,7 @@ Prepared for public release: 03/28/2005 - Charlie Wiederhold, 3D Realms
 //-------------------------------------------------------------------------
 #include "ns.h"
 #include "build.h"
+#include "sectorgrid.h"
 
 #include "names2.h"
 #include "panel.h"
@@ -1767,6 +1768,7 @@ MovePoints(SECTOR_OBJECTp sop, short delta_ang, int nx, int ny)
             {
                 wp->x = rxy.x;
                 wp->y = rxy.y;
+                sectorGrid.Extend(wp->sector, wp->x, wp->y);
             }
         }
 
@@ -1992,6 +1994,7 @@ void RefreshPoints(SECTOR_OBJECTp sop, int nx, int ny, bool dynamic)
                     {
                         wp->x = dx;
                         wp->y = dy;
+                        sectorGrid.Extend(wp->sector, wp->x, wp->y);
                     }
                 }
 
@@ -2158,6 +2161,7 @@ CollapseSectorObject(SECTOR_OBJECTp sop, int nx, int ny)
                 {
                     wp->x = nx;
                     wp->y = ny;
+                    sectorGrid.Extend(wp->sector, wp->x, wp->y);
                 }
             }
         }
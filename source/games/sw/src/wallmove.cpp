@@ -25,6 +25,8 @@ Prepared for public release: 03/28/2005 - Charlie Wiederhold, 3D Realms
 //-------------------------------------------------------------------------
 #include "ns.h"
 #include "build.h"
+#include "sectorgrid.h"
+#include "sectorgeometry.h"
 
 #include "names2.h"
 #include "game.h"
@@ -123,7 +125,8 @@ int DoWallMove(SPRITEp sp)
             {
                 wallp->x = sp->x + nx;
                 wallp->y = sp->y + ny;
-                sector[wallp->sector].dirty = 255;
+                sectorGrid.Extend(wallp->sector, wallp->x, wallp->y);
+                sectorGeometry.MarkDirty(wallp->sector);
             }
 
             if (shade1)